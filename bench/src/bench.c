@@ -0,0 +1,219 @@
+#include "bench.h"
+#include <notstd/topology.h>
+#include <math.h>
+#include <fnmatch.h>
+#include <getopt.h>
+#include <sched.h>
+
+typedef enum { BENCH_OUT_TEXT, BENCH_OUT_JSON, BENCH_OUT_CSV } benchOut_e;
+
+//registration happen in constructor, can't use mem_alloc
+__private bench_s BENCHS[BENCH_MAX];
+__private unsigned BENCHCOUNT;
+
+void bench_register(const char* group, const char* name, size_t ops, benchSetup_f setup, benchRun_f run, benchClean_f clean){
+	if( BENCHCOUNT >= BENCH_MAX ) die("too many benchmark, increase BENCH_MAX");
+	bench_s* b = &BENCHS[BENCHCOUNT++];
+	b->group = group;
+	b->name  = name;
+	b->ops   = ops;
+	b->setup = setup;
+	b->run   = run;
+	b->clean = clean;
+}
+
+__private int bench_cmp(const void* a, const void* b){
+	const bench_s* ba = a;
+	const bench_s* bb = b;
+	int ret = strcmp(ba->group, bb->group);
+	return ret ? ret : strcmp(ba->name, bb->name);
+}
+
+__private int double_cmp(const void* a, const void* b){
+	const double da = *(const double*)a;
+	const double db = *(const double*)b;
+	return (da > db) - (da < db);
+}
+
+//filter can be group, group/name or glob pattern on group/name
+__private int bench_match(const bench_s* b, char** filter, unsigned count){
+	if( !count ) return 1;
+	char full[256];
+	snprintf(full, sizeof full, "%s/%s", b->group, b->name);
+	for( unsigned i = 0; i < count; ++i ){
+		if( !strcmp(filter[i], b->group) ) return 1;
+		if( !fnmatch(filter[i], full, 0) ) return 1;
+	}
+	return 0;
+}
+
+__private double bench_sample(const bench_s* b, size_t ops, double* cycles){
+	void* ctx = b->setup ? b->setup(ops) : NULL;
+	bench_clobber();
+	const delay_t st = time_mono_ns();
+	const uint64_t cs = time_cycles();
+	b->run(ctx, ops);
+	const uint64_t ce = time_cycles();
+	const delay_t en = time_mono_ns();
+	bench_clobber();
+	if( b->clean ) b->clean(ctx);
+	else if( ctx ) mem_free(ctx);
+	*cycles = (double)(ce - cs) / ops;
+	return (double)(en - st) / ops;
+}
+
+__private void bench_exec(benchResult_s* r, const bench_s* b, size_t ops, unsigned warmup, unsigned samples){
+	__free double* ns  = MANY(double, samples);
+	__free double* cyc = MANY(double, samples);
+	double dummy;
+	for( unsigned i = 0; i < warmup; ++i ) bench_sample(b, ops, &dummy);
+	for( unsigned i = 0; i < samples; ++i ) ns[i] = bench_sample(b, ops, &cyc[i]);
+
+	double sum = 0;
+	for( unsigned i = 0; i < samples; ++i ) sum += ns[i];
+	const double mean = sum / samples;
+	double var = 0;
+	for( unsigned i = 0; i < samples; ++i ) var += (ns[i] - mean) * (ns[i] - mean);
+
+	qsort(ns, samples, sizeof(double), double_cmp);
+	qsort(cyc, samples, sizeof(double), double_cmp);
+	//nearest rank
+	unsigned p99 = (unsigned)ceil(samples * 0.99);
+	if( p99 ) --p99;
+
+	r->bench   = b;
+	r->ops     = ops;
+	r->samples = samples;
+	r->min     = ns[0];
+	r->median  = samples & 1 ? ns[samples/2] : (ns[samples/2 - 1] + ns[samples/2]) / 2.0;
+	r->p99     = ns[p99];
+	r->mean    = mean;
+	r->stddev  = samples > 1 ? sqrt(var / (samples - 1)) : 0.0;
+	r->cycles  = samples & 1 ? cyc[samples/2] : (cyc[samples/2 - 1] + cyc[samples/2]) / 2.0;
+}
+
+__private void out_begin(FILE* f, benchOut_e mode, int cpu){
+	switch( mode ){
+		case BENCH_OUT_TEXT:
+			fprintf(f, "# cpu:%d tsc:%s hz:%lu\n", cpu, time_tsc_invariant() ? "invariant" : "variant", time_cycles_hz());
+			fprintf(f, "%-28s %10s %5s %12s %12s %12s %12s %10s\n", "benchmark", "ops", "n", "min ns/op", "median", "p99", "stddev", "cyc/op");
+		break;
+		case BENCH_OUT_JSON:
+			fprintf(f, "{\n\t\"cpu\": %d,\n\t\"tsc_invariant\": %d,\n\t\"cycles_hz\": %lu,\n\t\"results\": [", cpu, time_tsc_invariant(), time_cycles_hz());
+		break;
+		case BENCH_OUT_CSV:
+			fputs("group,name,ops,samples,min_ns,median_ns,p99_ns,mean_ns,stddev_ns,cycles_op\n", f);
+		break;
+	}
+}
+
+__private void out_result(FILE* f, benchOut_e mode, const benchResult_s* r, unsigned id){
+	switch( mode ){
+		case BENCH_OUT_TEXT:{
+			char full[256];
+			snprintf(full, sizeof full, "%s/%s", r->bench->group, r->bench->name);
+			fprintf(f, "%-28s %10zu %5u %12.2f %12.2f %12.2f %12.2f %10.1f\n", full, r->ops, r->samples, r->min, r->median, r->p99, r->stddev, r->cycles);
+		}
+		break;
+		case BENCH_OUT_JSON:
+			fprintf(f, "%s\n\t\t{\"group\": \"%s\", \"name\": \"%s\", \"ops\": %zu, \"samples\": %u, \"min_ns\": %.3f, \"median_ns\": %.3f, \"p99_ns\": %.3f, \"mean_ns\": %.3f, \"stddev_ns\": %.3f, \"cycles_op\": %.3f}",
+				id ? "," : "", r->bench->group, r->bench->name, r->ops, r->samples, r->min, r->median, r->p99, r->mean, r->stddev, r->cycles
+			);
+		break;
+		case BENCH_OUT_CSV:
+			fprintf(f, "%s,%s,%zu,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+				r->bench->group, r->bench->name, r->ops, r->samples, r->min, r->median, r->p99, r->mean, r->stddev, r->cycles
+			);
+		break;
+	}
+	fflush(f);
+}
+
+__private void out_end(FILE* f, benchOut_e mode){
+	if( mode == BENCH_OUT_JSON ) fputs("\n\t]\n}\n", f);
+}
+
+__private void usage(const char* argv0){
+	printf("usage: %s [options] [filter...]\n", argv0);
+	puts("  -f text|json|csv  output format, default text");
+	puts("  -o file           write results to file, default stdout");
+	puts("  -n samples        measured samples, default " EXPAND_STRING(BENCH_SAMPLES));
+	puts("  -w warmup         discarded samples, default " EXPAND_STRING(BENCH_WARMUP));
+	puts("  -s scale          multiply operations of each benchmark, default 1.0");
+	puts("  -c cpu            pin on logical cpu, -1 no pin, default first usable cpu");
+	puts("  -S seed           seed of data generators");
+	puts("  -l                list benchmark");
+	puts("filter is group, group/name or glob as 'rbhash/find*'");
+}
+
+int main(int argc, char** argv){
+	benchOut_e mode = BENCH_OUT_TEXT;
+	const char* out = NULL;
+	unsigned samples = BENCH_SAMPLES;
+	unsigned warmup = BENCH_WARMUP;
+	double scale = 1.0;
+	uint64_t seed = BENCH_SEED;
+	int list = 0;
+	//read topology before pin, otherwise threads benchmark see only one cpu
+	int cpu = topology()->cpu[0].id;
+
+	int opt;
+	while( (opt = getopt(argc, argv, "f:o:n:w:s:c:S:lh")) != -1 ){
+		switch( opt ){
+			case 'f':
+				if( !strcmp(optarg, "json") ) mode = BENCH_OUT_JSON;
+				else if( !strcmp(optarg, "csv") ) mode = BENCH_OUT_CSV;
+				else if( !strcmp(optarg, "text") ) mode = BENCH_OUT_TEXT;
+				else die("unknown format %s", optarg);
+			break;
+			case 'o': out = optarg; break;
+			case 'n': samples = strtoul(optarg, NULL, 0); break;
+			case 'w': warmup = strtoul(optarg, NULL, 0); break;
+			case 's': scale = strtod(optarg, NULL); break;
+			case 'c': cpu = strtol(optarg, NULL, 0); break;
+			case 'S': seed = strtoull(optarg, NULL, 0); break;
+			case 'l': list = 1; break;
+			default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+		}
+	}
+	if( !samples ) die("required at least one sample");
+	if( scale <= 0.0 ) die("scale need to be greater than 0");
+
+	qsort(BENCHS, BENCHCOUNT, sizeof(bench_s), bench_cmp);
+	char** filter = &argv[optind];
+	const unsigned nfilter = argc - optind;
+
+	if( list ){
+		for( unsigned i = 0; i < BENCHCOUNT; ++i ){
+			if( bench_match(&BENCHS[i], filter, nfilter) ) printf("%s/%s\n", BENCHS[i].group, BENCHS[i].name);
+		}
+		return 0;
+	}
+
+	if( cpu >= 0 ){
+		cpu_set_t mask;
+		CPU_ZERO(&mask);
+		CPU_SET(cpu, &mask);
+		if( sched_setaffinity(0, sizeof mask, &mask) ) die("unable to pin on cpu %d: %m", cpu);
+	}
+
+	FILE* f = stdout;
+	if( out && !(f = fopen(out, "w")) ) die("unable to open %s: %m", out);
+
+	out_begin(f, mode, cpu);
+	unsigned id = 0;
+	for( unsigned i = 0; i < BENCHCOUNT; ++i ){
+		if( !bench_match(&BENCHS[i], filter, nfilter) ) continue;
+		benchResult_s r;
+		size_t ops = BENCHS[i].ops * scale;
+		if( !ops ) ops = 1;
+		//each benchmark receive same data independently from order
+		gen_seed(seed);
+		bench_exec(&r, &BENCHS[i], ops, warmup, samples);
+		out_result(f, mode, &r, id++);
+	}
+	out_end(f, mode);
+
+	if( f != stdout ) fclose(f);
+	return 0;
+}
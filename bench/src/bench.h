@@ -0,0 +1,96 @@
+#ifndef __NOTSTD_BENCH_H__
+#define __NOTSTD_BENCH_H__
+
+#include <notstd/core.h>
+#include <notstd/delay.h>
+
+/* microbenchmark, each benchmark is registered with BENCH and is executed by notstd-bench
+ * every sample call setup, run and clean, only run is measured, result is reported for single operation
+ *
+ * BENCH(vector, push, 100000, NULL, NULL){
+ *	int* v = VECTOR(int, 16);
+ *	for( size_t i = 0; i < n; ++i ) vector_push(&v, &i);
+ *	mem_free(v);
+ * }
+ */
+
+//max numbers of benchmark can be registered
+#define BENCH_MAX       256
+//default samples measured
+#define BENCH_SAMPLES   31
+//default samples executed and discarded before measure
+#define BENCH_WARMUP    3
+//default seed of generators, same seed same data on each run
+#define BENCH_SEED      0x6E6F74737464ULL
+
+//create fixture for n operations, not measured, can return NULL
+typedef void*(*benchSetup_f)(size_t n);
+//execute n operations on fixture
+typedef void(*benchRun_f)(void* ctx, size_t n);
+//release fixture, not measured
+typedef void(*benchClean_f)(void* ctx);
+
+typedef struct bench{
+	const char* group;   /**< group, same of module name*/
+	const char* name;    /**< name of benchmark*/
+	size_t ops;          /**< operations executed on each sample*/
+	benchSetup_f setup;  /**< optional*/
+	benchRun_f run;      /**< measured*/
+	benchClean_f clean;  /**< optional, if NULL and setup return not NULL call mem_free*/
+}bench_s;
+
+typedef struct benchResult{
+	const bench_s* bench;
+	size_t ops;          /**< operations on each sample*/
+	unsigned samples;    /**< measured samples*/
+	double min;          /**< ns for op*/
+	double median;       /**< ns for op*/
+	double p99;          /**< ns for op*/
+	double mean;         /**< ns for op*/
+	double stddev;       /**< ns for op*/
+	double cycles;       /**< median cycles for op*/
+}benchResult_s;
+
+/* register benchmark, called from BENCH before main */
+void bench_register(const char* group, const char* name, size_t ops, benchSetup_f setup, benchRun_f run, benchClean_f clean);
+
+/* define and register benchmark, body receive void* ctx and size_t n */
+#define BENCH(GROUP, NAME, OPS, SETUP, CLEAN)\
+	__private void bench_##GROUP##_##NAME(void* ctx, size_t n);\
+	__ctor_prio(1) __private void bench_##GROUP##_##NAME##_register(void){\
+		bench_register(#GROUP, #NAME, OPS, SETUP, bench_##GROUP##_##NAME, CLEAN);\
+	}\
+	__private void bench_##GROUP##_##NAME(__unused void* ctx, __unused size_t n)
+
+/* prevent compiler to remove computation of value */
+#define bench_keep(V) __asm__ volatile("" : : "g"(V) : "memory")
+
+/* prevent compiler to cache memory across this point */
+#define bench_clobber() __asm__ volatile("" : : : "memory")
+
+/***************/
+/* generator.c */
+/***************/
+
+/* reset generator, same seed generate same sequence */
+void gen_seed(uint64_t seed);
+
+/* next random, splitmix64 */
+uint64_t gen_u64(void);
+
+/* random in range 0..n-1 */
+uint64_t gen_range(uint64_t n);
+
+/* vector of n unique random keys */
+uint64_t* gen_keys(size_t n);
+
+/* vector of n random words [a-z], words are gift of vector, unique up to 26^minlen words
+ * @param minlen min len of word, need to be >= 4
+ * @param maxlen max len of word
+ */
+char** gen_words(size_t n, unsigned minlen, unsigned maxlen);
+
+/* vector of n random size, distribution is log uniform, more small size than big */
+size_t* gen_sizes(size_t n, size_t min, size_t max);
+
+#endif
@@ -0,0 +1,820 @@
+#include "bench.h"
+#include <notstd/vector.h>
+#include <notstd/generics.h>
+#include <notstd/rbhash.h>
+#include <notstd/rbtree.h>
+#include <notstd/btree.h>
+#include <notstd/skiplist.h>
+#include <notstd/map.h>
+#include <notstd/phq.h>
+#include <notstd/trie.h>
+#include <notstd/dict.h>
+#include <notstd/intern.h>
+#include <notstd/fzs.h>
+#include <notstd/threads.h>
+
+#define WORD_MIN 6
+#define WORD_MAX 24
+
+__private int u64_cmp(const void* a, const void* b){
+	const uint64_t ua = *(const uint64_t*)a;
+	const uint64_t ub = *(const uint64_t*)b;
+	return (ua > ub) - (ua < ub);
+}
+
+__private int ptr_cmp(const void* a, const void* b){
+	return (ADDR(a) > ADDR(b)) - (ADDR(a) < ADDR(b));
+}
+
+__private void* setup_keys(size_t n){
+	return gen_keys(n);
+}
+
+__private void* setup_words(size_t n){
+	return gen_words(n, WORD_MIN, WORD_MAX);
+}
+
+/**********/
+/* vector */
+/**********/
+
+BENCH(vector, push, 1000000, NULL, NULL){
+	__free uint64_t* v = VECTOR(uint64_t, 16);
+	for( size_t i = 0; i < n; ++i ) vector_push(&v, &i);
+	bench_keep(v[n-1]);
+}
+
+BENCH(vector, iterate, 1000000, setup_keys, NULL){
+	uint64_t* v = ctx;
+	uint64_t sum = 0;
+	foreach_vector(v, i) sum += v[i];
+	bench_keep(sum);
+}
+
+BENCH(vector, qsort, 100000, setup_keys, NULL){
+	uint64_t* v = ctx;
+	vector_qsort(&v, u64_cmp);
+}
+
+/************/
+/* generics */
+/************/
+
+//same mixed values, one of four is double, in array of generic_s, array of gbox_t and columnar
+typedef struct bgenerics{
+	generic_s* gen;
+	gbox_t* box;
+	gcolumn_t* col;
+}bgenerics_s;
+
+__private void* setup_generics(size_t n){
+	bgenerics_s* b = NEW(bgenerics_s);
+	uint64_t* keys = gen_keys(n);
+	b->gen = mem_gift(MANY(generic_s, n), b);
+	b->box = mem_gift(MANY(gbox_t, n), b);
+	b->col = mem_gift(gcolumn_new(n), b);
+	for( size_t i = 0; i < n; ++i ){
+		b->gen[i] = i & 3 ? GI((long)(keys[i] & 0xFFFFFF)) : GI((double)i);
+		b->box[i] = gbox_from(b->gen[i]);
+		gcolumn_push(b->col, b->gen[i]);
+	}
+	mem_free(keys);
+	return b;
+}
+
+BENCH(generics, generic_sum, 1000000, setup_generics, NULL){
+	bgenerics_s* b = ctx;
+	long sum = 0;
+	for( size_t i = 0; i < n; ++i ) if( b->gen[i].type == G_LONG ) sum += b->gen[i].l;
+	bench_keep(sum);
+}
+
+BENCH(generics, gbox_sum, 1000000, setup_generics, NULL){
+	bgenerics_s* b = ctx;
+	long sum = 0;
+	for( size_t i = 0; i < n; ++i ) if( gbox_type(b->box[i]) == G_LONG ) sum += gbox_l(b->box[i]);
+	bench_keep(sum);
+}
+
+BENCH(generics, column_sum, 1000000, setup_generics, NULL){
+	bgenerics_s* b = ctx;
+	const uint8_t* types = gcolumn_types(b->col);
+	const uint64_t* pay  = gcolumn_payloads(b->col);
+	long sum = 0;
+	for( size_t i = 0; i < n; ++i ) if( types[i] == G_LONG ) sum += (long)pay[i];
+	bench_keep(sum);
+}
+
+BENCH(generics, column_count, 1000000, setup_generics, NULL){
+	bgenerics_s* b = ctx;
+	const uint8_t* types = gcolumn_types(b->col);
+	size_t count = 0;
+	for( size_t i = 0; i < n; ++i ) count += types[i] == G_FLOAT;
+	bench_keep(count);
+}
+
+/**********/
+/* rbhash */
+/**********/
+
+typedef struct brbhash{
+	rbhash_t* rbh;
+	uint64_t* keys;
+	char** words;
+}brbhash_s;
+
+__private void* setup_rbhash_u64(size_t n){
+	brbhash_s* b = NEW(brbhash_s);
+	b->words = NULL;
+	b->keys = mem_gift(gen_keys(n * 2), b);
+	b->rbh  = mem_gift(rbhash_new(16, 10, sizeof(uint64_t), hash64_splitmix), b);
+	for( size_t i = 0; i < n; ++i ) rbhash_add(b->rbh, &b->keys[i], sizeof(uint64_t), &b->keys[i]);
+	return b;
+}
+
+__private void* setup_rbhash_str(size_t n){
+	brbhash_s* b = NEW(brbhash_s);
+	b->keys  = NULL;
+	b->words = mem_gift(gen_words(n, WORD_MIN, WORD_MAX), b);
+	b->rbh   = mem_gift(rbhash_new(16, 10, WORD_MAX, hash_fasthash), b);
+	for( size_t i = 0; i < n; ++i ) rbhash_add(b->rbh, b->words[i], strlen(b->words[i]), b->words[i]);
+	return b;
+}
+
+BENCH(rbhash, insert_u64, 200000, setup_keys, NULL){
+	uint64_t* keys = ctx;
+	__free rbhash_t* rbh = rbhash_new(16, 10, sizeof(uint64_t), hash64_splitmix);
+	for( size_t i = 0; i < n; ++i ) rbhash_add(rbh, &keys[i], sizeof(uint64_t), &keys[i]);
+}
+
+BENCH(rbhash, find_u64, 200000, setup_rbhash_u64, NULL){
+	brbhash_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		if( !rbhash_find(b->rbh, &b->keys[i], sizeof(uint64_t)) ) die("rbhash lost key");
+	}
+}
+
+//table over last level cache, find is bound by memory latency
+#define RBHASH_LARGE 4000000
+
+typedef struct brbhashbatch{
+	brbhash_s* b;
+	const void** keys;
+	void** out;
+}brbhashbatch_s;
+
+__private void* setup_rbhash_batch(size_t n){
+	brbhashbatch_s* bb = NEW(brbhashbatch_s);
+	bb->b    = mem_gift(setup_rbhash_u64(n), bb);
+	bb->keys = mem_gift(MANY(const void*, n), bb);
+	bb->out  = mem_gift(MANY(void*, n), bb);
+	//random order of lookup
+	for( size_t i = 0; i < n; ++i ) bb->keys[i] = &bb->b->keys[gen_range(n)];
+	return bb;
+}
+
+BENCH(rbhash, find_large_u64, RBHASH_LARGE, setup_rbhash_batch, NULL){
+	brbhashbatch_s* bb = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		if( !rbhash_find(bb->b->rbh, bb->keys[i], sizeof(uint64_t)) ) die("rbhash lost key");
+	}
+}
+
+BENCH(rbhash, find_batch_large_u64, RBHASH_LARGE, setup_rbhash_batch, NULL){
+	brbhashbatch_s* bb = ctx;
+	if( rbhash_find_batch(bb->b->rbh, bb->keys, NULL, n, bb->out) != n ) die("rbhash batch lost key");
+}
+
+BENCH(rbhash, miss_u64, 200000, setup_rbhash_u64, NULL){
+	brbhash_s* b = ctx;
+	for( size_t i = n; i < n * 2; ++i ){
+		bench_keep(rbhash_find(b->rbh, &b->keys[i], sizeof(uint64_t)));
+	}
+}
+
+BENCH(rbhash, remove_u64, 200000, setup_rbhash_u64, NULL){
+	brbhash_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		bench_keep(rbhash_remove(b->rbh, &b->keys[i], sizeof(uint64_t)));
+	}
+}
+
+BENCH(rbhash, insert_str, 200000, setup_words, NULL){
+	char** words = ctx;
+	__free rbhash_t* rbh = rbhash_new(16, 10, WORD_MAX, hash_fasthash);
+	for( size_t i = 0; i < n; ++i ) rbhash_add(rbh, words[i], strlen(words[i]), words[i]);
+}
+
+BENCH(rbhash, find_str, 200000, setup_rbhash_str, NULL){
+	brbhash_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		if( !rbhash_find(b->rbh, b->words[i], strlen(b->words[i])) ) die("rbhash lost word");
+	}
+}
+
+//fasthash is 32 bit, miss compare fingerprint on all group
+BENCH(rbhash, miss_str, 200000, setup_rbhash_str, NULL){
+	brbhash_s* b = ctx;
+	char miss[WORD_MAX + 2];
+	for( size_t i = 0; i < n; ++i ){
+		const size_t len = strlen(b->words[i]);
+		memcpy(miss, b->words[i], len);
+		miss[len] = '#';
+		bench_keep(rbhash_find(b->rbh, miss, len + 1));
+	}
+}
+
+RBHASH_DECLARE(u64map, uint64_t, uint64_t*, rbhash_mix64, RBHASH_EQ)
+
+typedef struct bu64map{
+	u64map_t* m;
+	uint64_t* keys;
+}bu64map_s;
+
+__private void* setup_u64map(size_t n){
+	bu64map_s* b = NEW(bu64map_s);
+	b->keys = mem_gift(gen_keys(n * 2), b);
+	b->m    = mem_gift(u64map_new(16, 10), b);
+	for( size_t i = 0; i < n; ++i ) u64map_add(b->m, b->keys[i], &b->keys[i]);
+	return b;
+}
+
+BENCH(rbhash, declare_insert_u64, 200000, setup_keys, NULL){
+	uint64_t* keys = ctx;
+	__free u64map_t* m = u64map_new(16, 10);
+	for( size_t i = 0; i < n; ++i ) u64map_add(m, keys[i], &keys[i]);
+}
+
+BENCH(rbhash, declare_find_u64, 200000, setup_u64map, NULL){
+	bu64map_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		if( !u64map_find(b->m, b->keys[i]) ) die("u64map lost key");
+	}
+}
+
+BENCH(rbhash, declare_miss_u64, 200000, setup_u64map, NULL){
+	bu64map_s* b = ctx;
+	for( size_t i = n; i < n * 2; ++i ) bench_keep(u64map_find(b->m, b->keys[i]));
+}
+
+BENCH(rbhash, declare_remove_u64, 200000, setup_u64map, NULL){
+	bu64map_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ) bench_keep(u64map_remove(b->m, b->keys[i], NULL));
+}
+
+/***********/
+/* crbhash */
+/***********/
+
+//max readers, limited to numbers of cpu
+#define CRBHASH_THREADS 4
+
+typedef struct bcrbhash{
+	crbhash_t* ch;
+	rbhash_t* rbh;
+	glock_s mtx;
+	uint64_t* keys;
+	size_t ops;
+	unsigned next;
+	int locked;
+}bcrbhash_s;
+
+__private void* setup_crbhash(size_t n){
+	bcrbhash_s* b = NEW(bcrbhash_s);
+	mutex_ctor(&b->mtx, 0);
+	b->keys = mem_gift(gen_keys(n), b);
+	b->ch   = mem_gift(crbhash_new(16, 10, sizeof(uint64_t), 0, hash64_splitmix), b);
+	b->rbh  = mem_gift(rbhash_new(16, 10, sizeof(uint64_t), hash64_splitmix), b);
+	for( size_t i = 0; i < n; ++i ){
+		crbhash_add(b->ch, &b->keys[i], sizeof(uint64_t), &b->keys[i]);
+		rbhash_add(b->rbh, &b->keys[i], sizeof(uint64_t), &b->keys[i]);
+	}
+	return b;
+}
+
+__private void crbhash_find_loop(bcrbhash_s* b, size_t start, size_t n){
+	for( size_t i = start; i < start + n; ++i ){
+		void* f;
+		if( b->locked ){
+			mutex_guard(&b->mtx) f = rbhash_find(b->rbh, &b->keys[i], sizeof(uint64_t));
+		}
+		else{
+			f = crbhash_find(b->ch, &b->keys[i], sizeof(uint64_t));
+		}
+		if( !f ) die("crbhash lost key");
+	}
+}
+
+//each reader find own slice of keys
+__private void async_crbhash_find(__unused thr_t* self, void* ctx){
+	bcrbhash_s* b = ctx;
+	const unsigned id = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED);
+	crbhash_find_loop(b, id * b->ops, b->ops);
+}
+
+//n is split on threads, result is time of single find with all readers
+__private void crbhash_readers(bcrbhash_s* b, int locked, size_t n){
+	unsigned count = topology_cpu_count();
+	if( count > CRBHASH_THREADS ) count = CRBHASH_THREADS;
+	b->locked = locked;
+	b->next = 0;
+	b->ops = n / count ? n / count : 1;
+	thr_t* t[CRBHASH_THREADS];
+	for( unsigned i = 0; i < count; ++i ) t[i] = thr_new_affinity(async_crbhash_find, b, 0, CPU_AFFINITY_SCATTER, i, 0);
+	thr_waitv(t, count);
+	for( unsigned i = 0; i < count; ++i ) mem_free(t[i]);
+}
+
+BENCH(crbhash, find_u64, 200000, setup_crbhash, NULL){
+	bcrbhash_s* b = ctx;
+	b->locked = 0;
+	crbhash_find_loop(b, 0, n);
+}
+
+BENCH(crbhash, find_readers, 200000, setup_crbhash, NULL){
+	crbhash_readers(ctx, 0, n);
+}
+
+//baseline, rbhash wrapped in one mutex
+BENCH(crbhash, mutex_readers, 200000, setup_crbhash, NULL){
+	crbhash_readers(ctx, 1, n);
+}
+
+/**********/
+/* rbtree */
+/**********/
+
+typedef struct brbtree{
+	rbtree_t* rbt;
+	uint64_t* keys;
+}brbtree_s;
+
+__private void* setup_rbtree(size_t n){
+	brbtree_s* b = NEW(brbtree_s);
+	b->keys = mem_gift(gen_keys(n), b);
+	b->rbt  = mem_gift(rbtree_new(ptr_cmp), b);
+	for( size_t i = 0; i < n; ++i ) rbtree_insert(b->rbt, mem_gift(rbtree_node_new((void*)b->keys[i]), b->rbt));
+	return b;
+}
+
+BENCH(rbtree, insert, 200000, setup_keys, NULL){
+	uint64_t* keys = ctx;
+	__free rbtree_t* rbt = rbtree_new(ptr_cmp);
+	for( size_t i = 0; i < n; ++i ) rbtree_insert(rbt, mem_gift(rbtree_node_new((void*)keys[i]), rbt));
+}
+
+//keys as pointer sorted with ptr_cmp
+__private void* setup_sorted_ptr(size_t n){
+	__free uint64_t* keys = gen_keys(n);
+	qsort(keys, n, sizeof(uint64_t), u64_cmp);
+	void** v = MANY(void*, n);
+	for( size_t i = 0; i < n; ++i ) v[i] = (void*)keys[i];
+	return v;
+}
+
+BENCH(rbtree, insert_sorted, 200000, setup_sorted_ptr, NULL){
+	void** keys = ctx;
+	__free rbtree_t* rbt = rbtree_new(ptr_cmp);
+	for( size_t i = 0; i < n; ++i ) rbtree_insert(rbt, mem_gift(rbtree_node_new(keys[i]), rbt));
+}
+
+BENCH(rbtree, bulk_build, 200000, setup_sorted_ptr, NULL){
+	__free rbtree_t* rbt = rbtree_new(ptr_cmp);
+	rbtree_bulk_build(rbt, ctx, n);
+}
+
+BENCH(rbtree, find, 200000, setup_rbtree, NULL){
+	brbtree_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		if( !rbtree_find(b->rbt, (void*)b->keys[i]) ) die("rbtree lost key");
+	}
+}
+
+BENCH(rbtree, scan, 200000, setup_rbtree, NULL){
+	brbtree_s* b = ctx;
+	uint64_t sum = 0;
+	rbtNode_t* node;
+	foreach(rbtree_inorder, b->rbt, node, 0, n) sum += ADDR(rbtree_node_data(node));
+	bench_keep(sum);
+}
+
+BENCH(rbtree, cursor_scan, 200000, setup_rbtree, NULL){
+	brbtree_s* b = ctx;
+	uint64_t sum = 0;
+	rbtNode_t* node;
+	rbtree_each(node, rbtree_cursor(b->rbt, 0)) sum += ADDR(rbtree_node_data(node));
+	bench_keep(sum);
+}
+
+//pagination, iterator start from offset in O(log n)
+BENCH(rbtree, page, 20000, setup_rbtree, NULL){
+	brbtree_s* b = ctx;
+	uint64_t sum = 0;
+	rbtNode_t* node;
+	for( size_t i = 0; i < n; ++i ){
+		foreach(rbtree_inorder, b->rbt, node, b->keys[i] % n, 10) sum += ADDR(rbtree_node_data(node));
+	}
+	bench_keep(sum);
+}
+
+BENCH(rbtree, rank, 200000, setup_rbtree, NULL){
+	brbtree_s* b = ctx;
+	size_t sum = 0;
+	for( size_t i = 0; i < n; ++i ) sum += rbtree_rank(b->rbt, (void*)b->keys[i]);
+	bench_keep(sum);
+}
+
+BENCH(rbtree, remove, 200000, setup_rbtree, NULL){
+	brbtree_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		rbtNode_t* node = rbtree_find(b->rbt, (void*)b->keys[i]);
+		if( !node ) die("rbtree lost key");
+		//node stay gifted to tree, mem_give is linear on childs and is not measured
+		rbtree_remove(b->rbt, node);
+	}
+}
+
+typedef struct bitem{
+	rbtLink_s link;
+	uint64_t key;
+}bitem_s;
+
+RBTREE_DECLARE(bitems, bitem_s, link, key, RBTREE_CMP)
+
+__private int u64_cmp_item(const void* a, const void* b){
+	return u64_cmp(&((const bitem_s*)a)->key, &((const bitem_s*)b)->key);
+}
+
+typedef struct brbtreei{
+	rbtRoot_s root;
+	bitem_s* items;
+}brbtreei_s;
+
+__private void* setup_rbtree_intrusive(size_t n){
+	brbtreei_s* b = NEW(brbtreei_s);
+	__free uint64_t* keys = gen_keys(n);
+	b->items = mem_gift(MANY(bitem_s, n), b);
+	b->root  = (rbtRoot_s){ NULL, 0, NULL };
+	for( size_t i = 0; i < n; ++i ) b->items[i].key = keys[i];
+	return b;
+}
+
+__private void* setup_rbtree_intrusive_fill(size_t n){
+	brbtreei_s* b = setup_rbtree_intrusive(n);
+	for( size_t i = 0; i < n; ++i ) bitems_insert(&b->root, &b->items[i]);
+	return b;
+}
+
+BENCH(rbtree, intrusive_insert, 200000, setup_rbtree_intrusive, NULL){
+	brbtreei_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ) bitems_insert(&b->root, &b->items[i]);
+}
+
+__private void* setup_rbtree_intrusive_sorted(size_t n){
+	brbtreei_s* b = setup_rbtree_intrusive(n);
+	qsort(b->items, n, sizeof(bitem_s), u64_cmp_item);
+	return b;
+}
+
+BENCH(rbtree, intrusive_insert_sorted, 200000, setup_rbtree_intrusive_sorted, NULL){
+	brbtreei_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ) bitems_insert(&b->root, &b->items[i]);
+}
+
+BENCH(rbtree, intrusive_build, 200000, setup_rbtree_intrusive_sorted, NULL){
+	brbtreei_s* b = ctx;
+	bitems_build(&b->root, b->items, n);
+}
+
+BENCH(rbtree, intrusive_find, 200000, setup_rbtree_intrusive_fill, NULL){
+	brbtreei_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		if( !bitems_find(&b->root, &b->items[i].key) ) die("rbtree lost key");
+	}
+}
+
+BENCH(rbtree, intrusive_remove, 200000, setup_rbtree_intrusive_fill, NULL){
+	brbtreei_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ) bitems_remove(&b->root, &b->items[i]);
+}
+
+/*********/
+/* btree */
+/*********/
+
+typedef struct bbtree{
+	btree_t* bt;
+	uint64_t* keys;
+}bbtree_s;
+
+__private void* setup_btree(size_t n){
+	bbtree_s* b = NEW(bbtree_s);
+	b->keys = mem_gift(gen_keys(n), b);
+	b->bt   = mem_gift(btree_new(sizeof(uint64_t), 0, u64_cmp), b);
+	for( size_t i = 0; i < n; ++i ) btree_insert(b->bt, &b->keys[i], (void*)b->keys[i]);
+	return b;
+}
+
+BENCH(btree, insert, 200000, setup_keys, NULL){
+	uint64_t* keys = ctx;
+	__free btree_t* bt = btree_new(sizeof(uint64_t), 0, u64_cmp);
+	for( size_t i = 0; i < n; ++i ) btree_insert(bt, &keys[i], (void*)keys[i]);
+}
+
+BENCH(btree, find, 200000, setup_btree, NULL){
+	bbtree_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		if( !btree_find(b->bt, &b->keys[i]) ) die("btree lost key");
+	}
+}
+
+BENCH(btree, scan, 200000, setup_btree, NULL){
+	bbtree_s* b = ctx;
+	uint64_t sum = 0;
+	btreeEntry_s* e;
+	foreach(btree_inorder, b->bt, e, 0, n) sum += ADDR(e->data);
+	bench_keep(sum);
+}
+
+/************/
+/* skiplist */
+/************/
+
+//writers contend on same list, not limited to numbers of cpu
+#define SKIPLIST_WRITERS 32
+
+typedef struct bskiplist{
+	skiplist_t* sl;
+	rbtree_t* rbt;
+	glock_s mtx;
+	uint64_t* keys;
+	size_t ops;
+	unsigned next;
+	int locked;
+}bskiplist_s;
+
+__private void* setup_skiplist(size_t n){
+	bskiplist_s* b = NEW(bskiplist_s);
+	mutex_ctor(&b->mtx, 0);
+	b->keys = mem_gift(gen_keys(n), b);
+	b->sl   = mem_gift(skiplist_new(u64_cmp), b);
+	for( size_t i = 0; i < n; ++i ) skiplist_insert(b->sl, &b->keys[i]);
+	return b;
+}
+
+__private void* setup_skiplist_writers(size_t n){
+	bskiplist_s* b = NEW(bskiplist_s);
+	mutex_ctor(&b->mtx, 0);
+	b->keys = mem_gift(gen_keys(n), b);
+	return b;
+}
+
+BENCH(skiplist, insert, 200000, setup_keys, NULL){
+	uint64_t* keys = ctx;
+	__free skiplist_t* sl = skiplist_new(u64_cmp);
+	for( size_t i = 0; i < n; ++i ) skiplist_insert(sl, &keys[i]);
+}
+
+BENCH(skiplist, find, 200000, setup_skiplist, NULL){
+	bskiplist_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		if( !skiplist_find(b->sl, &b->keys[i]) ) die("skiplist lost key");
+	}
+}
+
+//each writer insert and remove own slice of keys
+__private void async_skiplist_write(__unused thr_t* self, void* ctx){
+	bskiplist_s* b = ctx;
+	const unsigned id = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED);
+	uint64_t* keys = &b->keys[id * b->ops];
+	for( size_t i = 0; i < b->ops; ++i ){
+		if( b->locked ){
+			mutex_guard(&b->mtx) rbtree_insert(b->rbt, rbtree_node_new(&keys[i]));
+		}
+		else{
+			skiplist_insert(b->sl, &keys[i]);
+		}
+	}
+	for( size_t i = 0; i < b->ops; i += 2 ){
+		if( b->locked ){
+			mutex_guard(&b->mtx) mem_free(rbtree_remove(b->rbt, rbtree_find(b->rbt, &keys[i])));
+		}
+		else{
+			skiplist_remove(b->sl, &keys[i]);
+		}
+	}
+}
+
+//n is split on writers, result is time of single insert with half remove with all writers
+__private void skiplist_writers(bskiplist_s* b, int locked, size_t n){
+	__free skiplist_t* sl = skiplist_new(u64_cmp);
+	__free rbtree_t* rbt = rbtree_new(u64_cmp);
+	b->sl = sl;
+	b->rbt = rbt;
+	b->locked = locked;
+	b->next = 0;
+	b->ops = n / SKIPLIST_WRITERS ? n / SKIPLIST_WRITERS : 1;
+	thr_t* t[SKIPLIST_WRITERS];
+	for( unsigned i = 0; i < SKIPLIST_WRITERS; ++i ) t[i] = thr_new_affinity(async_skiplist_write, b, 0, CPU_AFFINITY_SCATTER, i, 0);
+	thr_waitv(t, SKIPLIST_WRITERS);
+	for( unsigned i = 0; i < SKIPLIST_WRITERS; ++i ) mem_free(t[i]);
+	//rbtree nodes are not gifted, release the remaining
+	rbtNode_t* node;
+	while( (node = rbtree_select(rbt, 0)) ) mem_free(rbtree_remove(rbt, node));
+}
+
+BENCH(skiplist, writers, 200000, setup_skiplist_writers, NULL){
+	skiplist_writers(ctx, 0, n);
+}
+
+//baseline, rbtree wrapped in one mutex
+BENCH(skiplist, mutex_writers, 200000, setup_skiplist_writers, NULL){
+	skiplist_writers(ctx, 1, n);
+}
+
+/*******/
+/* phq */
+/*******/
+
+typedef struct bphq{
+	phq_t* q;
+	phqElement_t** el;
+}bphq_s;
+
+__private void* setup_phq(size_t n){
+	bphq_s* b = NEW(bphq_s);
+	b->q  = mem_gift(phq_new(16, phq_cmp_asc, 0), b);
+	b->el = mem_gift(MANY(phqElement_t*, n), b);
+	for( size_t i = 0; i < n; ++i ) b->el[i] = mem_gift(phq_element_new(gen_range(n), NULL), b->q);
+	return b;
+}
+
+//one op is one insert and one pop
+BENCH(phq, insert_pop, 200000, setup_phq, NULL){
+	bphq_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ) phq_insert(b->q, b->el[i]);
+	for( size_t i = 0; i < n; ++i ) bench_keep(phq_pop(b->q));
+}
+
+/********/
+/* trie */
+/********/
+
+typedef struct btrie{
+	trie_t* tr;
+	char** words;
+}btrie_s;
+
+__private void* setup_trie(size_t n, trieMode_e mode){
+	btrie_s* b = NEW(btrie_s);
+	b->words = mem_gift(gen_words(n, WORD_MIN, WORD_MAX), b);
+	b->tr    = mem_gift(trie_new_mode(mode), b);
+	for( size_t i = 0; i < n; ++i ) trie_insert(b->tr, b->words[i], 0, b->words[i]);
+	return b;
+}
+
+__private void* setup_trie_edge(size_t n){
+	return setup_trie(n, TRIE_EDGE);
+}
+
+__private void* setup_trie_art(size_t n){
+	return setup_trie(n, TRIE_ART);
+}
+
+BENCH(trie, edge_insert, 100000, setup_words, NULL){
+	char** words = ctx;
+	__free trie_t* tr = trie_new_mode(TRIE_EDGE);
+	for( size_t i = 0; i < n; ++i ) trie_insert(tr, words[i], 0, words[i]);
+}
+
+BENCH(trie, art_insert, 100000, setup_words, NULL){
+	char** words = ctx;
+	__free trie_t* tr = trie_new_mode(TRIE_ART);
+	for( size_t i = 0; i < n; ++i ) trie_insert(tr, words[i], 0, words[i]);
+}
+
+BENCH(trie, edge_find, 100000, setup_trie_edge, NULL){
+	btrie_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		if( !trie_find(b->tr, b->words[i], 0) ) die("trie lost word");
+	}
+}
+
+BENCH(trie, art_find, 100000, setup_trie_art, NULL){
+	btrie_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		if( !trie_find(b->tr, b->words[i], 0) ) die("trie lost word");
+	}
+}
+
+/********/
+/* dict */
+/********/
+
+typedef struct bdict{
+	dict_t* d;
+	char** words;
+}bdict_s;
+
+__private bdict_s* setup_dict(size_t n, dictMode_e mode){
+	bdict_s* b = NEW(bdict_s);
+	b->words = mem_gift(gen_words(n, WORD_MIN, WORD_MAX), b);
+	b->d     = mem_gift(dict_new_mode(mode), b);
+	for( size_t i = 0; i < n; ++i ) *dicts(b->d, b->words[i]) = GI((long)i);
+	return b;
+}
+
+__private void* setup_dict_ordered(size_t n){
+	return setup_dict(n, DICT_ORDERED);
+}
+
+__private void* setup_dict_hash(size_t n){
+	return setup_dict(n, DICT_HASH);
+}
+
+BENCH(dict, ordered_insert_str, 100000, setup_words, NULL){
+	char** words = ctx;
+	__free dict_t* d = dict_new();
+	for( size_t i = 0; i < n; ++i ) *dicts(d, words[i]) = GI((long)i);
+}
+
+BENCH(dict, hash_insert_str, 100000, setup_words, NULL){
+	char** words = ctx;
+	__free dict_t* d = dict_new_mode(DICT_HASH);
+	for( size_t i = 0; i < n; ++i ) *dicts(d, words[i]) = GI((long)i);
+}
+
+BENCH(dict, ordered_find_str, 100000, setup_dict_ordered, NULL){
+	bdict_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		if( dicts(b->d, b->words[i])->type != G_LONG ) die("dict lost key");
+	}
+}
+
+BENCH(dict, hash_find_str, 100000, setup_dict_hash, NULL){
+	bdict_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		if( dicts(b->d, b->words[i])->type != G_LONG ) die("dict lost key");
+	}
+}
+
+//keys are interned one time and added with dictk, lookup use hash of pool and compare pointer
+__private void* setup_dict_interned(size_t n){
+	bdict_s* b = NEW(bdict_s);
+	b->words = mem_gift(gen_words(n, WORD_MIN, WORD_MAX), b);
+	b->d     = mem_gift(dict_new_mode(DICT_HASH), b);
+	for( size_t i = 0; i < n; ++i ){
+		b->words[i] = (char*)intern(b->words[i], 0);
+		*dictk(b->d, b->words[i]) = GI((long)i);
+	}
+	return b;
+}
+
+BENCH(dict, hash_find_interned, 100000, setup_dict_interned, NULL){
+	bdict_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		if( dictk(b->d, b->words[i])->type != G_LONG ) die("dict lost key");
+	}
+}
+
+/**********/
+/* intern */
+/**********/
+
+BENCH(intern, add, 100000, setup_words, NULL){
+	char** words = ctx;
+	__free intern_t* pool = intern_new();
+	for( size_t i = 0; i < n; ++i ) intern_add(pool, words[i], 0);
+}
+
+/*******/
+/* fzs */
+/*******/
+
+#define FZS_DICTIONARY 1024
+
+BENCH(fzs, levenshtein, 100000, setup_words, NULL){
+	char** words = ctx;
+	size_t d = 0;
+	for( size_t i = 1; i < n; ++i ) d += fzs_levenshtein(words[i-1], strlen(words[i-1]), words[i], strlen(words[i]));
+	bench_keep(d);
+}
+
+BENCH(fzs, damerau, 100000, setup_words, NULL){
+	char** words = ctx;
+	size_t d = 0;
+	for( size_t i = 1; i < n; ++i ) d += fzs_damerau_levenshtein(words[i-1], strlen(words[i-1]), words[i], strlen(words[i]));
+	bench_keep(d);
+}
+
+__private void* setup_fzs_dictionary(__unused size_t n){
+	return gen_words(FZS_DICTIONARY, WORD_MIN, WORD_MAX);
+}
+
+//one op is a search on FZS_DICTIONARY words
+BENCH(fzs, vector_find, 100, setup_fzs_dictionary, NULL){
+	char** words = ctx;
+	for( size_t i = 0; i < n; ++i ){
+		bench_keep(fzs_vector_find(words, FZS_DICTIONARY, words[gen_range(FZS_DICTIONARY)], 0, fzs_levenshtein));
+	}
+}
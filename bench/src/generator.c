@@ -0,0 +1,71 @@
+#include "bench.h"
+#include <notstd/vector.h>
+#include <math.h>
+
+/* synthetic data, deterministic from seed, no external files */
+
+__private uint64_t GENSTATE = BENCH_SEED;
+
+//splitmix64 finalizer is a bijection, distinct input generate distinct output
+__private inline uint64_t gen_mix(uint64_t z){
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+void gen_seed(uint64_t seed){
+	GENSTATE = seed;
+}
+
+uint64_t gen_u64(void){
+	GENSTATE += 0x9E3779B97F4A7C15ULL;
+	return gen_mix(GENSTATE);
+}
+
+uint64_t gen_range(uint64_t n){
+	return ((unsigned __int128)gen_u64() * n) >> 64;
+}
+
+uint64_t* gen_keys(size_t n){
+	uint64_t* v = VECTOR(uint64_t, n);
+	const uint64_t base = gen_u64();
+	for( size_t i = 0; i < n; ++i ){
+		uint64_t k = gen_mix(base + i);
+		vector_push(&v, &k);
+	}
+	return v;
+}
+
+char** gen_words(size_t n, unsigned minlen, unsigned maxlen){
+	iassert( minlen >= 4 && maxlen >= minlen );
+	char** v = VECTOR(char*, n);
+	for( size_t i = 0; i < n; ++i ){
+		const unsigned len = minlen + gen_range(maxlen - minlen + 1);
+		char* w = mem_gift(MANY(char, len + 1), v);
+		//random prefix and index in base 26 as suffix, words are unique and share prefix as real text
+		unsigned k = len;
+		size_t id = i;
+		do{
+			w[--k] = 'a' + id % 26;
+			id /= 26;
+		}while( id && k );
+		while( k-- ) w[k] = 'a' + gen_range(26);
+		w[len] = 0;
+		vector_push(&v, &w);
+	}
+	return v;
+}
+
+size_t* gen_sizes(size_t n, size_t min, size_t max){
+	iassert( min > 0 && max >= min );
+	size_t* v = VECTOR(size_t, n);
+	const double lmin = log((double)min);
+	const double lmax = log((double)max + 1.0);
+	for( size_t i = 0; i < n; ++i ){
+		const double u = (double)(gen_u64() >> 11) / (double)(1ULL << 53);
+		size_t sz = exp(lmin + (lmax - lmin) * u);
+		if( sz > max ) sz = max;
+		vector_push(&v, &sz);
+	}
+	return v;
+}
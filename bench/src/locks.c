@@ -0,0 +1,82 @@
+#include "bench.h"
+#include <notstd/threads.h>
+
+//max threads used in contended benchmark, limited to numbers of cpu
+#define LOCK_THREADS 4
+
+typedef enum { BLOCK_MUTEX, BLOCK_MCS, BLOCK_COHORT } block_e;
+
+typedef struct block{
+	glock_s mtx;
+	mcs_s mcs;
+	cohort_t* cohort;
+	block_e mode;
+	size_t ops;
+	unsigned long counter;
+}block_s;
+
+__private void* setup_lock(__unused size_t n){
+	block_s* b = NEW(block_s);
+	mutex_ctor(&b->mtx, 0);
+	mcs_ctor(&b->mcs, 0);
+	b->cohort = mem_gift(cohort_new(0), b);
+	b->counter = 0;
+	b->ops = 0;
+	return b;
+}
+
+__private void lock_loop(block_s* b, size_t n){
+	switch( b->mode ){
+		case BLOCK_MUTEX:  for( size_t i = 0; i < n; ++i ) mutex_guard(&b->mtx) ++b->counter; break;
+		case BLOCK_MCS:    for( size_t i = 0; i < n; ++i ) mcs_guard(&b->mcs) ++b->counter; break;
+		case BLOCK_COHORT: for( size_t i = 0; i < n; ++i ) cohort_guard(b->cohort) ++b->counter; break;
+	}
+}
+
+__private void async_lock(__unused thr_t* self, void* ctx){
+	block_s* b = ctx;
+	lock_loop(b, b->ops);
+}
+
+//n is split on threads, spread on core and node, result is time of single lock in contention
+__private void lock_contended(block_s* b, block_e mode, size_t n){
+	unsigned count = topology_cpu_count();
+	if( count > LOCK_THREADS ) count = LOCK_THREADS;
+	b->mode = mode;
+	b->ops = n / count ? n / count : 1;
+	thr_t* t[LOCK_THREADS];
+	for( unsigned i = 0; i < count; ++i ) t[i] = thr_new_affinity(async_lock, b, 0, CPU_AFFINITY_SCATTER, i, 0);
+	thr_waitv(t, count);
+	for( unsigned i = 0; i < count; ++i ) mem_free(t[i]);
+	if( b->counter != b->ops * count ) die("lock lose increment");
+}
+
+BENCH(locks, mutex, 1000000, setup_lock, NULL){
+	block_s* b = ctx;
+	b->mode = BLOCK_MUTEX;
+	lock_loop(b, n);
+}
+
+BENCH(locks, mcs, 1000000, setup_lock, NULL){
+	block_s* b = ctx;
+	b->mode = BLOCK_MCS;
+	lock_loop(b, n);
+}
+
+BENCH(locks, cohort, 1000000, setup_lock, NULL){
+	block_s* b = ctx;
+	b->mode = BLOCK_COHORT;
+	lock_loop(b, n);
+}
+
+BENCH(locks, mutex_contended, 400000, setup_lock, NULL){
+	lock_contended(ctx, BLOCK_MUTEX, n);
+}
+
+BENCH(locks, mcs_contended, 400000, setup_lock, NULL){
+	lock_contended(ctx, BLOCK_MCS, n);
+}
+
+BENCH(locks, cohort_contended, 400000, setup_lock, NULL){
+	lock_contended(ctx, BLOCK_COHORT, n);
+}
@@ -0,0 +1,54 @@
+#include "bench.h"
+#include <notstd/vector.h>
+
+#define SMALL_SIZE 64
+#define SIZE_MIN   8
+#define SIZE_MAX_  (64*1024)
+
+BENCH(memory, alloc_small, 1000000, NULL, NULL){
+	for( size_t i = 0; i < n; ++i ){
+		char* p = MANY(char, SMALL_SIZE);
+		bench_keep(p);
+		mem_free(p);
+	}
+}
+
+BENCH(memory, malloc_small, 1000000, NULL, NULL){
+	for( size_t i = 0; i < n; ++i ){
+		char* p = malloc(SMALL_SIZE);
+		bench_keep(p);
+		free(p);
+	}
+}
+
+typedef struct bmem{
+	size_t* sizes;
+	void** ptr;
+}bmem_s;
+
+__private void* setup_sizes(size_t n){
+	bmem_s* b = NEW(bmem_s);
+	b->sizes = mem_gift(gen_sizes(n, SIZE_MIN, SIZE_MAX_), b);
+	b->ptr   = mem_gift(MANY(void*, n), b);
+	return b;
+}
+
+//one op is one alloc and one free, all blocks are alive before free
+BENCH(memory, alloc_batch, 100000, setup_sizes, NULL){
+	bmem_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ) b->ptr[i] = mem_alloc(b->sizes[i], 0, 0, NULL, 0, NULL);
+	for( size_t i = 0; i < n; ++i ) mem_free(b->ptr[i]);
+}
+
+BENCH(memory, malloc_batch, 100000, setup_sizes, NULL){
+	bmem_s* b = ctx;
+	for( size_t i = 0; i < n; ++i ) b->ptr[i] = malloc(b->sizes[i]);
+	for( size_t i = 0; i < n; ++i ) free(b->ptr[i]);
+}
+
+//one op is one realloc growing of SMALL_SIZE bytes
+BENCH(memory, realloc_grow, 10000, NULL, NULL){
+	char* p = MANY(char, SMALL_SIZE);
+	for( size_t i = 1; i < n; ++i ) p = mem_realloc(p, SMALL_SIZE * (i + 1));
+	mem_free(p);
+}
@@ -0,0 +1,49 @@
+#ifndef __NOTSTD_CORE_BTREE_H__
+#define __NOTSTD_CORE_BTREE_H__
+
+#include <notstd/core.h>
+
+/* ordered map as B+tree, keys of fixed size are stored inline in wide nodes, data are only in leaf
+ * leafs are linked, iterate and range scan never go up in tree
+ * cmp is called as cmp(key in tree, key searched), same of rbtree but on pointer to inline key
+*/
+
+//default node size in bytes, 8 cache lines
+#define BTREE_NODE_SIZE (CACHE_LINE_SIZE*8)
+//each allocation of nodes is of this size, nodes are reused from free list
+#define BTREE_SLAB_SIZE (1024*64)
+//max height, also with 4 keys for node can store more than 2^64 elements
+#define BTREE_DEPTH_MAX 48
+
+typedef struct btree btree_t;
+typedef struct btreeit btree_i;
+
+//element returned from iterate, valid until next change of tree
+typedef struct btreeEntry{
+	const void* key;
+	void* data;
+}btreeEntry_s;
+
+/* @param keysize size in bytes of key copied in tree
+ * @param nodesize size of node rounded to CACHE_LINE_SIZE, 0 use BTREE_NODE_SIZE, PAGE_SIZE for big tree
+ */
+btree_t* btree_new(unsigned keysize, unsigned nodesize, cmp_f fn);
+//return -1 and errno EEXIST if key exists
+int btree_insert(btree_t* t, const void* key, void* data);
+//return data of key or NULL
+void* btree_find(btree_t* t, const void* key);
+//return data of first element with key >= key and copy key in out if not NULL, NULL if not exists
+void* btree_find_best(btree_t* t, const void* key, void* out);
+//return data of removed key or NULL
+void* btree_remove(btree_t* t, const void* key);
+size_t btree_count(btree_t* t);
+unsigned btree_depth(btree_t* t);
+
+//iterate return btreeEntry_s*, with foreach(btree_inorder, t, e, 0, 0)
+btree_i* btree_inorder_iterator(btree_t* t, unsigned offset, unsigned count);
+void* btree_inorder_iterate(void* IT);
+//range scan from first key >= key, foreach(btree_range, t, e, &key, count)
+btree_i* btree_range_iterator(btree_t* t, const void* key, unsigned count);
+#define btree_range_iterate btree_inorder_iterate
+
+#endif
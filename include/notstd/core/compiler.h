@@ -29,7 +29,8 @@
 #define __weak              __attribute__((weak))
 #define __noinline          __attribute__((noinline))
 #define __sectiona(SEC, CS) __attribute__((section(SEC "." EXPAND_STRING(CS))))
-#define __aligneda(N)       __attribute__((aligned(4)))
+#define __aligneda(N)       __attribute__((aligned(N)))
+#define __cacheline         __aligneda(CACHE_LINE_SIZE)
 #define __noreturn          __attribute__((noreturn))
 #define __constructor       __attribute__((constructor))
 #define __destructor        __attribute__((destructor))
@@ -37,6 +38,7 @@
 #define __malloc            __attribute__((malloc))
 #define __cpu_init()        __builtin_cpu_init()
 #define __resolver(NAME)    __attribute__((ifunc(#NAME)))
+#define __target(T)         __attribute__((target(T)))
 #define __constructor_priority(P) __attribute__((constructor(P)))
 #define __destructor_priority(P)  __attribute__((destructor(P)))
 #define __compatible_type(A,B) __builtin_types_compatible_p(A,B)
@@ -74,9 +76,13 @@
 
 #define ADDR(VAR) ((uintptr_t)(VAR))
 #define ADDRTO(VAR, SO, I) ( ADDR(VAR) + ((SO)*(I)))
+//from address of MEMBER return address of struct T that contain it
+#define container_of(PTR, T, MEMBER) ((T*)(ADDR(PTR) - offsetof(T, MEMBER)))
 
 #define OS_PAGE_SIZE sysconf(_SC_PAGESIZE)
 
+#define CACHE_LINE_SIZE 64
+
 #define sizeof_vector(V) (sizeof(V) / sizeof(V[0]))
 
 #define forever() for(;;)
@@ -21,6 +21,18 @@
 
 typedef uint64_t delay_t;
 
+//before deadline stop sleep and spin, start value, is adapted to twice the wakeup latency inside min/max
+#define DELAY_SPIN_NS  USTONS(100)
+#define DELAY_SPIN_MIN USTONS(5)
+#define DELAY_SPIN_MAX USTONS(1000)
+
+//min time used for calibrate tsc if cpu not report frequency
+#define TIME_TSC_CALIBRATE_NS MSTONS(10)
+
+//called from notstd __ctor, take first tsc/monotonic pair used for calibrate tsc
+void time_begin(void);
+
+//wall clock, can jump under ntp, use only for date
 delay_t time_ms(void);
 delay_t time_us(void);
 delay_t time_ns(void);
@@ -31,6 +43,34 @@ delay_t time_cpu_ns(void);
 
 double time_sec(void);
 
+//monotonic clock, never jump, use for measure interval
+delay_t time_mono_ms(void);
+delay_t time_mono_us(void);
+delay_t time_mono_ns(void);
+
+//raw tsc, cost few cycles, not serialized
+__private inline uint64_t time_cycles(void){
+	return __builtin_ia32_rdtsc();
+}
+
+//1 if tsc is invariant, constant rate on all power state, otherwise cycles conversion are only approximate
+int time_tsc_invariant(void);
+
+//tsc frequency, the first call can wait until TIME_TSC_CALIBRATE_NS from startup
+uint64_t time_cycles_hz(void);
+
+//convert interval of cycles to ns
+delay_t time_cycles_to_ns(uint64_t cycles);
+
+//convert tsc readed with time_cycles to monotonic ns, same timeline of time_mono_ns
+delay_t time_cycles_ns(uint64_t cycles);
+
+//convert buffer of tsc to monotonic ns, same result of time_cycles_ns without reload state for each element, ns and cycles can be same buffer
+//uint64_t trace[N];
+//for( ... ) trace[i] = time_cycles();
+//time_cycles_ns_batch(trace, trace, N);
+void time_cycles_ns_batch(delay_t* ns, const uint64_t* cycles, size_t count);
+
 void delay_ms(delay_t ms);
 void delay_us(delay_t us);
 void delay_ns(delay_t ns);
@@ -38,4 +78,33 @@ void delay_sec(double s);
 
 void delay_hard(delay_t us);
 
+//sleep with clock_nanosleep until spin window before deadline, then spin on tsc, deadline is monotonic ns
+void delay_until(delay_t deadline);
+
+//same delay_until but relative
+void delay_precise(delay_t ns);
+
+typedef struct pacer pacer_t;
+
+//pacer issue events at fixed rate, events/s, the slots are absolute from start, late or jitter never accumulate drift
+//__free pacer_t* p = pacer_new(10000.0);
+//forever(){
+//	pacer_wait(p);
+//	send();
+//}
+//return NULL and errno EINVAL if rate is not finite or <= 0
+pacer_t* pacer_new(double rate);
+
+//restart schedule from now
+void pacer_reset(pacer_t* p);
+
+//change rate from current slot, return -1 and errno EINVAL if rate is not valid and old rate is kept
+int pacer_rate(pacer_t* p, double rate);
+
+//wait next slot, if already late return immediately and return how many ns is late, late slot are recovered as burst, call pacer_reset if you want to skip
+delay_t pacer_wait(pacer_t* p);
+
+//numbers of slot consumed
+uint64_t pacer_count(pacer_t* p);
+
 #endif
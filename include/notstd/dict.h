@@ -14,17 +14,37 @@ typedef struct gpair{
 	generic_s* value;
 }gpair_s;
 
+/* DICT_ORDERED, integer and string keys are in two rbtree, iterate integer keys ascending and after string keys ascending,
+ *               string keys are not copied and need to live until are removed
+ * DICT_HASH,    pairs are inline in array with open addressing index, dict() is O(1), iterate in insertion order,
+ *               string keys are copied and owned from dict, value pointer is valid until next new key is added
+ */
+typedef enum { DICT_ORDERED, DICT_HASH } dictMode_e;
+
 typedef struct dict dict_t;
 typedef struct dictit dict_i;
 
 typedef int(*dictMap_f)(gpair_s pair, void* arg);
 
+//same of dict_new_mode(DICT_ORDERED)
 dict_t* dict_new(void);
+dict_t* dict_new_mode(dictMode_e mode);
+dictMode_e dict_mode(dict_t* d);
 generic_s* dicti(dict_t* d, long key);
 generic_s* dicts(dict_t* d, const char* key);
 int dictsrm(dict_t* d, const char* key);
+/* ikey is returned from intern(), DICT_HASH use hash of pool and store ikey without copy,
+ * keys added with dictk are compared only by pointer, keys added with dicts need strcmp, DICT_ORDERED is same of dicts
+ */
+generic_s* dictk(dict_t* d, const char* ikey);
+int dictkrm(dict_t* d, const char* ikey);
 int dictirm(dict_t* d, long key);
 unsigned long dict_count(dict_t* dic);
+/* load empty dict in O(n) from pairs in order of dict_iterate, integer and string keys are sorted ascending and unique in own group,
+ * DICT_HASH accept pairs in any order but keys need to be unique
+ * @return -1 and errno ENOTEMPTY if dict is not empty, EINVAL if keys are not sorted or duplicated
+ */
+int dict_load(dict_t* d, const dictPair_s* pairs, size_t n);
 
 dict_i* dict_iterator(dict_t* dic, unsigned offset, unsigned count);
 void* dict_iterate(void* IT);
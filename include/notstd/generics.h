@@ -106,8 +106,153 @@ inline int g_dump(generic_s g){
 	}
 }
 
+/************/
+/*** gbox ***/
+/************/
 
+/* gbox_t is generic in 8 bytes with nan boxing, a double is stored as is and other types are in space of negative quiet nan:
+ * bits 63..51 are all 1, bits 50..48 are tag, bits 47..0 are payload.
+ * long and ulong are 48 bit, out of range are stored as double and type is G_FLOAT.
+ * const char* of max GBOX_INLINE chars is copied in payload and terminated, gbox_lstr return pointer inside box,
+ * char* is G_STRING and is never inline because is owned from caller.
+ * pointers are user space and use 47 bit, bit 47 separate G_VECTOR from G_OBJ and G_LSTRING from G_STRING
+ * gbox_t and gcolumn_t are storage for user containers, dict, generics vector and g_print still use generic_s,
+ * use gbox_from/gbox_generic at the boundary, an inline G_LSTRING must be copied before the box go out of scope
+ */
+typedef uint64_t gbox_t;
 
+#define GBOX_INLINE    5
+#define GBOX_NAN       0x7FF8000000000000ULL
+#define GBOX_BOXED     0xFFF8000000000000ULL
+#define GBOX_PAYLOAD   0x0000FFFFFFFFFFFFULL
+#define GBOX_BIT47     0x0000800000000000ULL
+#define GBOX_LONG_MAX  ((long)(GBOX_BIT47 - 1))
+#define GBOX_LONG_MIN  (-(long)GBOX_BIT47)
+#define GBOX_TAG_CHAR  1ULL
+#define GBOX_TAG_LONG  2ULL
+#define GBOX_TAG_ULONG 3ULL
+#define GBOX_TAG_STR   4ULL
+#define GBOX_TAG_SSO   5ULL
+#define GBOX_TAG_PTR   6ULL
+#define GBOX_TAG_UNSET 7ULL
+#define GBOX_MAKE(TAG, PAYLOAD) (GBOX_BOXED | ((TAG) << 48) | ((uint64_t)(PAYLOAD) & GBOX_PAYLOAD))
 
+inline unsigned gbox_tag(gbox_t b){ return (b & GBOX_BOXED) == GBOX_BOXED ? (b >> 48) & 7 : 0; }
+
+inline gbox_t gb_unset(void) { return GBOX_MAKE(GBOX_TAG_UNSET, 0); }
+inline gbox_t gb_char(char v) { return GBOX_MAKE(GBOX_TAG_CHAR, (uint8_t)v); }
+inline gbox_t gb_double(double v) {
+	gbox_t b;
+	memcpy(&b, &v, sizeof b);
+	//nan with payload in boxed space is canonicalized
+	return gbox_tag(b) ? GBOX_NAN : b;
+}
+inline gbox_t gb_float(float v) { return gb_double(v); }
+inline gbox_t gb_int64(int64_t v) { return v >= GBOX_LONG_MIN && v <= GBOX_LONG_MAX ? GBOX_MAKE(GBOX_TAG_LONG, v) : gb_double(v); }
+inline gbox_t gb_int8(int8_t v) { return gb_int64(v); }
+inline gbox_t gb_int16(int16_t v) { return gb_int64(v); }
+inline gbox_t gb_int32(int32_t v) { return gb_int64(v); }
+inline gbox_t gb_uint64(uint64_t v) { return v <= GBOX_PAYLOAD ? GBOX_MAKE(GBOX_TAG_ULONG, v) : gb_double(v); }
+inline gbox_t gb_uint8(uint8_t v) { return gb_uint64(v); }
+inline gbox_t gb_uint16(uint16_t v) { return gb_uint64(v); }
+inline gbox_t gb_uint32(uint32_t v) { return gb_uint64(v); }
+inline gbox_t gb_str(char* v) { return GBOX_MAKE(GBOX_TAG_STR, (uintptr_t)v); }
+inline gbox_t gb_lstr(const char* v) {
+	const size_t len = strnlen(v, GBOX_INLINE + 1);
+	if( len > GBOX_INLINE ) return GBOX_MAKE(GBOX_TAG_STR, (uintptr_t)v | GBOX_BIT47);
+	uint64_t p = 0;
+	memcpy(&p, v, len);
+	return GBOX_MAKE(GBOX_TAG_SSO, p);
+}
+inline gbox_t gb_obj(void* v) { return GBOX_MAKE(GBOX_TAG_PTR, (uintptr_t)v); }
+inline gbox_t gb_vec(generic_s* v) { return GBOX_MAKE(GBOX_TAG_PTR, (uintptr_t)v | GBOX_BIT47); }
+
+#define GB(VALUE) _Generic((VALUE),\
+	char       : gb_char,\
+	int8_t     : gb_int8,\
+	int16_t    : gb_int16,\
+	int32_t    : gb_int32,\
+	int64_t    : gb_int64,\
+	uint8_t    : gb_uint8,\
+	uint16_t   : gb_uint16,\
+	uint32_t   : gb_uint32,\
+	uint64_t   : gb_uint64,\
+	float      : gb_float,\
+	double     : gb_double,\
+	char*      : gb_str,\
+	const char*: gb_lstr,\
+	generic_s* : gb_vec,\
+	default    : gb_obj\
+)(VALUE)
+
+inline gtype_e gbox_type(gbox_t b){
+	switch( gbox_tag(b) ){
+		default:
+		case 0: return G_FLOAT;
+		case GBOX_TAG_CHAR: return G_CHAR;
+		case GBOX_TAG_LONG: return G_LONG;
+		case GBOX_TAG_ULONG: return G_ULONG;
+		case GBOX_TAG_STR: return b & GBOX_BIT47 ? G_LSTRING : G_STRING;
+		case GBOX_TAG_SSO: return G_LSTRING;
+		case GBOX_TAG_PTR: return b & GBOX_BIT47 ? G_VECTOR : G_OBJ;
+		case GBOX_TAG_UNSET: return G_UNSET;
+	}
+}
+
+inline char gbox_c(gbox_t b){ return (char)(b & 0xFF); }
+//sign extend 48 bit
+inline long gbox_l(gbox_t b){ return gbox_tag(b) ? (long)((int64_t)(b << 16) >> 16) : (long)({ double d; memcpy(&d, &b, sizeof d); d; }); }
+inline unsigned long gbox_ul(gbox_t b){ return gbox_tag(b) ? b & GBOX_PAYLOAD : (unsigned long)({ double d; memcpy(&d, &b, sizeof d); d; }); }
+inline double gbox_f(gbox_t b){ double d; memcpy(&d, &b, sizeof d); return d; }
+inline void* gbox_ptr(gbox_t b){ return (void*)(uintptr_t)(b & (GBOX_PAYLOAD & ~GBOX_BIT47)); }
+//inline string point inside box, box need to live while string is used
+inline const char* gbox_lstr(const gbox_t* b){ return gbox_tag(*b) == GBOX_TAG_SSO ? (const char*)b : gbox_ptr(*b); }
+
+//convert from and to generic_s, inline string of generic point inside box
+inline gbox_t gbox_from(generic_s g){
+	switch( g.type ){
+		default: return gb_obj(g.obj);
+		case G_UNSET: return gb_unset();
+		case G_CHAR: return gb_char(g.c);
+		case G_LONG: return gb_int64(g.l);
+		case G_ULONG: return gb_uint64(g.ul);
+		case G_FLOAT: return gb_double(g.f);
+		case G_LSTRING: return gb_lstr(g.lstr);
+		case G_STRING: return gb_str(g.str);
+		case G_VECTOR: return gb_vec(g.vec);
+	}
+}
+
+inline generic_s gbox_generic(const gbox_t* b){
+	switch( gbox_type(*b) ){
+		default: return gi_obj(gbox_ptr(*b));
+		case G_UNSET: return gi_unset();
+		case G_CHAR: return gi_char(gbox_c(*b));
+		case G_LONG: return gi_int64(gbox_l(*b));
+		case G_ULONG: return gi_uint64(gbox_ul(*b));
+		case G_FLOAT: return gi_double(gbox_f(*b));
+		case G_LSTRING: return gi_lstr(gbox_lstr(b));
+		case G_STRING: return gi_str(gbox_ptr(*b));
+		case G_VECTOR: return gi_vec(gbox_ptr(*b));
+	}
+}
+
+/**************/
+/* generics.c */
+/**************/
+
+/* columnar vector of generic, types and payloads are in two arrays, 9 bytes for each element,
+ * scan of types read 1 byte for element and payload is read only for element of type searched
+ */
+typedef struct gcolumn gcolumn_t;
+
+gcolumn_t* gcolumn_new(size_t count);
+size_t gcolumn_count(gcolumn_t* c);
+void gcolumn_push(gcolumn_t* c, generic_s g);
+generic_s gcolumn_get(gcolumn_t* c, size_t index);
+void gcolumn_set(gcolumn_t* c, size_t index, generic_s g);
+//array of gtype_e as uint8_t and array of raw payload, valid until next push
+const uint8_t* gcolumn_types(gcolumn_t* c);
+const uint64_t* gcolumn_payloads(gcolumn_t* c);
 
 #endif
@@ -0,0 +1,33 @@
+#ifndef __NOTSTD_CORE_INTERN_H__
+#define __NOTSTD_CORE_INTERN_H__
+
+#include <notstd/core.h>
+
+/* string interning, equal strings return same pointer and can be compared by pointer
+ * strings are copied in arena of pool with hash and len before string, released only with pool
+ * hash is hash_seeded() of string, can be reused from other hash table without hash again the string
+ */
+
+//each arena of pool is of this size, longer strings have own allocation
+#define INTERN_ARENA_SIZE (1024*64)
+//initial slots of index, power of two
+#define INTERN_SLOTS_MIN 64
+
+typedef struct intern intern_t;
+
+//pool for one owner, not thread safe
+intern_t* intern_new(void);
+//return interned copy of str, len 0 use strlen
+const char* intern_add(intern_t* pool, const char* str, size_t len);
+//return interned str or NULL if not exists, never add
+const char* intern_find(intern_t* pool, const char* str, size_t len);
+size_t intern_count(intern_t* pool);
+
+//global pool, thread safe, strings live until end of process
+const char* intern(const char* str, size_t len);
+
+//only for string returned from intern or intern_add, read from header in O(1)
+uint64_t intern_hash(const char* istr);
+size_t intern_len(const char* istr);
+
+#endif
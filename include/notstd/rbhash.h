@@ -9,6 +9,41 @@
 
 typedef uint64_t(*rbhash_f)(const void* name, size_t len);
 typedef struct rbhash rbhash_t;
+typedef struct crbhash crbhash_t;
+typedef struct rbhashMap rbhashMap_t;
+
+//return bytes saved for data and set size, NULL for no bytes
+typedef const void*(*rbhashPayload_f)(void* data, size_t* size, void* ctx);
+
+//buckets moved from previous table for each add/find/remove during resize
+#define RBHASH_MIGRATE 64
+
+//crbhash default segments for each cpu
+#define CRBHASH_SEGMENT_CPU 4
+#define CRBHASH_SEGMENT_MAX 256
+//lock free read retry before wait writers in lock
+#define CRBHASH_OPTIMISTIC 16
+
+//keys hashed and prefetched ahead in rbhash_find_batch, power of two
+#define RBHASH_BATCH 16
+
+//fingerprint of slot from high bits of hash multiplied with golden ratio, 32 bit hash functions leave high bits of hash to 0
+#define RBHASH_MIX(HASH) ((uint64_t)(HASH) * UINT64_C(0x9E3779B97F4A7C15))
+//high bit is always set, 0 is empty slot
+#define RBHASH_FP(HASH) ((uint8_t)((RBHASH_MIX(HASH) >> 57) | 0x80))
+
+//distance tracked in histogram, last entry count all elements with distance >= RBHASH_HIST-1
+#define RBHASH_HIST 256
+
+typedef struct rbhashStat{
+	size_t count;             /**< elements*/
+	size_t size;              /**< buckets*/
+	size_t maxdistance;       /**< max distance from home bucket*/
+	size_t pending;           /**< elements not yet moved from previous table*/
+	double load;              /**< count / size*/
+	double probe;             /**< mean slots probed for find an existing key*/
+	size_t hist[RBHASH_HIST]; /**< hist[d] numbers of elements at distance d from home bucket*/
+}rbhashStat_s;
 
 /*************/
 /* hashalg.c */
@@ -28,17 +63,43 @@ uint64_t hash_partow(const void* key, size_t len);
 uint64_t hash64_splitmix(const void* key, __unused size_t len); //only for key as 64 bit value (no strings)
 uint64_t hash_murmur_oaat64(const void* key, const size_t len);
 uint64_t hash_murmur_oaat32(const void* key, const size_t len);
+//wyhash final 4
+uint64_t hash_wyhash(const void* key, size_t len);
+uint64_t hash_wyhash_seed(const void* key, size_t len, uint64_t seed);
+//xxh3 64 bit, input over 240 bytes use avx2 or sse2
+uint64_t hash_xxh3(const void* key, size_t len);
+uint64_t hash_xxh3_seed(const void* key, size_t len, uint64_t seed);
+//crc32c castagnoli, sse4.2 crc32 instruction when available, crc is previous value for incremental use, start with 0
+uint32_t crc32c(uint32_t crc, const void* data, size_t len);
+uint64_t hash_crc32c(const void* key, size_t len);
+//random seed generated at startup, different for each process
+uint64_t hash_seed(void);
+//wyhash with hash_seed(), use for keys from untrusted input, hash flooding can't predict collisions
+uint64_t hash_seeded(const void* key, size_t len);
+//stable id of library hash, 0 for user hash and hash_seeded, seed change on each process
+unsigned hash_id(rbhash_f fn);
 
 /************/
 /* rbhash.c */
 /************/
 
 rbhash_t* rbhash_new(size_t size, size_t min, size_t keysize, rbhash_f hashing);
+/* resize table for count elements without other resize, complete pending resize */
+void rbhash_reserve(rbhash_t* rbh, size_t count);
+/* when table grow the previous table is moved step buckets for each add/find/remove, default RBHASH_MIGRATE
+ * @param step 0 move all elements on grow, stop the world
+ */
+void rbhash_resize_step(rbhash_t* rbh, size_t step);
 int rbhash_addh(rbhash_t* rbh, uint64_t hash, const void* key, size_t len, void* data);
 int rbhash_add(rbhash_t* rbh, const void* key, size_t len, void* data);
 int rbhash_addu(rbhash_t* rbh, const void* key, size_t len, void* data);
 void* rbhash_findh(rbhash_t* rbh, uint64_t hash, const void* key, size_t len);
 void* rbhash_find(rbhash_t* rbh, const void* key, size_t len);
+/* find n keys, out[i] is data of keys[i] or NULL, memory latency of keys is overlapped
+ * @param lens len of each key, NULL all keys have keysize
+ * @return numbers of keys found
+ */
+size_t rbhash_find_batch(rbhash_t* rbh, const void** keys, const size_t* lens, size_t n, void** out);
 void* rbhash_findnx(rbhash_t* rbh, uint64_t hash, const void* key, size_t len, unsigned* scan);
 void* rbhash_removeh(rbhash_t* rbh, uint64_t hash, const void* key, size_t len);
 void* rbhash_remove(rbhash_t* ht, const void* key, size_t len);
@@ -46,7 +107,206 @@ size_t rbhash_bucket_used(rbhash_t* rbh);
 size_t rbhash_bucket_count(rbhash_t* rbh);
 size_t rbhash_collision(rbhash_t* rbh);
 size_t rbhash_distance_max(rbhash_t* rbh);
+//statistics are updated on each add/remove, this only copy them
+rbhashStat_s* rbhash_stat(rbhash_t* rbh, rbhashStat_s* st);
 void* rbhash_linear(rbhash_t* rbh, long* slot);
 
+/* persistent rbhash, file is: header, elements, metadata and payloads, all offsets are from start of file
+ * save build the image and write it with one sequential write, pending resize is completed before
+ * map is opened with mmap read only, find is zero copy and return pointer to payload in mapped file
+ * hash function is checked with hash_id, user hash can't be checked and need to be the same used on save
+ * @return 0 successfull, -1 error and errno is set
+ */
+int rbhash_save(rbhash_t* rbh, int fd, rbhashPayload_f payload, void* ctx);
+//NULL on error, EBADMSG file is not valid, EINVAL hashing is not the hash used on save, free with mem_free
+rbhashMap_t* rbhash_map_open(const char* path, rbhash_f hashing);
+//return payload of key and set size, when key is saved without payload return valid pointer and size 0
+const void* rbhash_map_findh(rbhashMap_t* map, uint64_t hash, const void* key, size_t len, size_t* size);
+const void* rbhash_map_find(rbhashMap_t* map, const void* key, size_t len, size_t* size);
+size_t rbhash_map_count(rbhashMap_t* map);
+
+/* concurrent rbhash, keys are split in segments, writers lock only own segment, readers never lock while no writer is on same segment
+ * same API of rbhash, crbhash_hash can be called one time and result used with *h functions
+ * data returned from find can be removed from other thread while is used, lifetime of data is managed from caller
+ * @param segments numbers of segments rounded to power of two, 0 use CRBHASH_SEGMENT_CPU for each cpu
+ */
+crbhash_t* crbhash_new(size_t size, size_t min, size_t keysize, unsigned segments, rbhash_f hashing);
+uint64_t crbhash_hash(crbhash_t* ch, const void* key, size_t len);
+int crbhash_addh(crbhash_t* ch, uint64_t hash, const void* key, size_t len, void* data);
+int crbhash_add(crbhash_t* ch, const void* key, size_t len, void* data);
+//find and add is atomic, return -1 and errno EEXIST if key exists
+int crbhash_adduh(crbhash_t* ch, uint64_t hash, const void* key, size_t len, void* data);
+int crbhash_addu(crbhash_t* ch, const void* key, size_t len, void* data);
+void* crbhash_findh(crbhash_t* ch, uint64_t hash, const void* key, size_t len);
+void* crbhash_find(crbhash_t* ch, const void* key, size_t len);
+void* crbhash_removeh(crbhash_t* ch, uint64_t hash, const void* key, size_t len);
+void* crbhash_remove(crbhash_t* ch, const void* key, size_t len);
+size_t crbhash_count(crbhash_t* ch);
+//elements in segment index, for check how keys are distributed
+size_t crbhash_segment_count(crbhash_t* ch, unsigned index);
+
+/***********************/
+/* type specialization */
+/***********************/
+
+/* RBHASH_DECLARE(name, keytype, valtype, hashfn, eqfn) generate a robin hood table with keys and values stored by value,
+ * hashfn(key) return uint64_t and eqfn(a, b) return not 0 when keys are equal, both are inlined.
+ * distance + 1 is stored in a parallel array, 0 is empty slot, find stop when slot is nearest to home than key, remove use backward shift
+ *
+ * RBHASH_DECLARE(u64map, uint64_t, void*, rbhash_mix64, RBHASH_EQ)
+ * u64map_t* m = u64map_new(16, 10);
+ * u64map_add(m, 42, ptr);
+ * void** v = u64map_find(m, 42);
+ * u64map_remove(m, 42, NULL);
+ *
+ * generated:
+ * name_t*        name_new(size_t size, size_t min);           min is percentage of free slot as rbhash_new
+ * int            name_add(name_t* h, keytype key, valtype val);  key can be duplicated
+ * int            name_addu(name_t* h, keytype key, valtype val); -1 and errno EEXIST if key exists
+ * valtype*       name_find(name_t* h, keytype key);              pointer to value is valid until next add or remove
+ * int            name_remove(name_t* h, keytype key, valtype* out); out can be NULL, -1 and errno ESRCH if not exists
+ * size_t         name_count(name_t* h);
+ * nameSlot_s*    name_linear(name_t* h, long* slot);           start with *slot = 0, NULL at end
+ */
+
+//splitmix64 finalizer, same of hash64_splitmix on integer
+__private inline uint64_t rbhash_mix64(uint64_t x){
+	x = (x ^ (x >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+	x = (x ^ (x >> 27)) * UINT64_C(0X94D049BB133111EB);
+	return x ^ (x >> 31);
+}
+
+#define RBHASH_EQ(A, B) ((A) == (B))
+
+//max distance + 1 stored in slot metadata
+#define RBHASH_DECLARE_DIST_MAX UINT16_MAX
+
+#define RBHASH_DECLARE(NAME, KT, VT, HASHFN, EQFN)\
+typedef struct NAME##Slot{\
+	KT key;\
+	VT val;\
+}NAME##Slot_s;\
+\
+typedef struct NAME{\
+	NAME##Slot_s* el;\
+	uint16_t* dist;\
+	size_t size;\
+	size_t count;\
+	size_t min;\
+	size_t pmin;\
+}NAME##_t;\
+\
+__unused __private void NAME##_table(NAME##_t* h, size_t size){\
+	h->size = size;\
+	h->min  = size - (size * h->pmin) / 100;\
+	h->el   = mem_gift(MANY(NAME##Slot_s, size), h);\
+	h->dist = mem_gift(MANY(uint16_t, size), h);\
+	memset(h->dist, 0, sizeof(uint16_t) * size);\
+}\
+\
+__unused __private NAME##_t* NAME##_new(size_t size, size_t min){\
+	NAME##_t* h = NEW(NAME##_t);\
+	h->pmin  = min;\
+	h->count = 0;\
+	NAME##_table(h, ROUND_UP_POW_TWO32(size < 16 ? 16 : size));\
+	return h;\
+}\
+\
+__unused __private inline void NAME##_put(NAME##_t* h, NAME##Slot_s sl){\
+	const size_t mask = h->size - 1;\
+	size_t s = HASHFN(sl.key) & mask;\
+	uint16_t d = 1;\
+	while( h->dist[s] ){\
+		if( h->dist[s] < d ){\
+			const NAME##Slot_s tsl = h->el[s];\
+			const uint16_t td = h->dist[s];\
+			h->el[s] = sl;\
+			h->dist[s] = d;\
+			sl = tsl;\
+			d = td;\
+		}\
+		s = (s + 1) & mask;\
+		if( ++d == RBHASH_DECLARE_DIST_MAX ) die("hash lose element, the hash function is degenerate");\
+	}\
+	h->el[s] = sl;\
+	h->dist[s] = d;\
+	++h->count;\
+}\
+\
+__unused __private void NAME##_grow(NAME##_t* h){\
+	NAME##Slot_s* el = h->el;\
+	uint16_t* dist = h->dist;\
+	const size_t size = h->size;\
+	NAME##_table(h, size * 2);\
+	h->count = 0;\
+	for( size_t i = 0; i < size; ++i ){\
+		if( dist[i] ) NAME##_put(h, el[i]);\
+	}\
+	mem_free(mem_give(el, h));\
+	mem_free(mem_give(dist, h));\
+}\
+\
+__unused __private inline long NAME##_slot(NAME##_t* h, KT key){\
+	const size_t mask = h->size - 1;\
+	size_t s = HASHFN(key) & mask;\
+	for( uint16_t d = 1; h->dist[s] >= d; ++d ){\
+		if( h->dist[s] == d && EQFN(h->el[s].key, key) ) return s;\
+		s = (s + 1) & mask;\
+	}\
+	return -1;\
+}\
+\
+__unused __private inline int NAME##_add(NAME##_t* h, KT key, VT val){\
+	if( h->count >= h->min ) NAME##_grow(h);\
+	NAME##_put(h, (NAME##Slot_s){ .key = key, .val = val });\
+	return 0;\
+}\
+\
+__unused __private inline int NAME##_addu(NAME##_t* h, KT key, VT val){\
+	if( NAME##_slot(h, key) != -1 ){\
+		errno = EEXIST;\
+		return -1;\
+	}\
+	return NAME##_add(h, key, val);\
+}\
+\
+__unused __private inline VT* NAME##_find(NAME##_t* h, KT key){\
+	const long s = NAME##_slot(h, key);\
+	return s == -1 ? NULL : &h->el[s].val;\
+}\
+\
+__unused __private inline int NAME##_remove(NAME##_t* h, KT key, VT* out){\
+	long s = NAME##_slot(h, key);\
+	if( s == -1 ){\
+		errno = ESRCH;\
+		return -1;\
+	}\
+	if( out ) *out = h->el[s].val;\
+	const size_t mask = h->size - 1;\
+	size_t next = (s + 1) & mask;\
+	while( h->dist[next] > 1 ){\
+		h->el[s] = h->el[next];\
+		h->dist[s] = h->dist[next] - 1;\
+		s = next;\
+		next = (next + 1) & mask;\
+	}\
+	h->dist[s] = 0;\
+	--h->count;\
+	return 0;\
+}\
+\
+__unused __private inline size_t NAME##_count(NAME##_t* h){\
+	return h->count;\
+}\
+\
+__unused __private inline NAME##Slot_s* NAME##_linear(NAME##_t* h, long* slot){\
+	if( *slot == -1 ) return NULL;\
+	while( *slot < (long)h->size ){\
+		const long s = (*slot)++;\
+		if( h->dist[s] ) return &h->el[s];\
+	}\
+	*slot = -1;\
+	return NULL;\
+}
 
 #endif
@@ -3,16 +3,52 @@
 
 #include <notstd/core.h>
 
+#define RBT_BLACK   0
+#define RBT_RED     1
+#define RBT_RAINBOW 2
+
+//intrusive node, embed in your struct and get it back with container_of
+typedef struct rbtLink{
+	struct rbtLink* parent;
+	struct rbtLink* left;
+	struct rbtLink* right;
+	int color;
+}rbtLink_s;
+
+/* augment recompute data of n from n and own children, called on each node that change children during insert, remove and rotations
+ * used for subtree size, sum aggregate, max end of interval tree
+ */
+typedef void(*rbtAugment_f)(rbtLink_s* n);
+
+//cursor live on stack, walk with successor or predecessor from cur to end excluded, NULL end walk to last
+typedef struct rbtCursor{
+	rbtLink_s* cur;
+	rbtLink_s* end;
+	int reverse;
+}rbtCursor_s;
+
+//root of intrusive tree, zero initialized is empty tree without augment
+typedef struct rbtRoot{
+	rbtLink_s* root;
+	size_t count;
+	rbtAugment_f augment;
+}rbtRoot_s;
+
 typedef struct rbtNode rbtNode_t;
 typedef struct rbtree rbtree_t;
 
 typedef struct rbtreeit rbtree_i;
 
 typedef int (*rbtCompare_f)(const void* a, const void* b);
+typedef int (*rbtLinkCmp_f)(const rbtLink_s* a, const rbtLink_s* b);
 typedef int(*rbtMap_f)(void* data, void* arg);
 
+/************/
+/* rbtree.c */
+/************/
+
 rbtNode_t* rbtree_insert(rbtree_t* rbt, rbtNode_t* n);
-rbtNode_t* rbtree_remove(rbtree_t* rbt, rbtNode_t *z); 
+rbtNode_t* rbtree_remove(rbtree_t* rbt, rbtNode_t *z);
 rbtNode_t* rbtree_find(rbtree_t* rbt, const void* data);
 rbtNode_t* rbtree_find_best(rbtree_t* rbt, const void* key);
 rbtree_t* rbtree_new(cmp_f fn);
@@ -28,13 +64,189 @@ rbtNode_t* rbtree_node_left(rbtNode_t* node);
 rbtNode_t* rbtree_node_right(rbtNode_t* node);
 rbtNode_t* rbtree_node_parent(rbtNode_t* node);
 
+//rbtree_t keep subtree size, select, rank and offset of iterator are O(log n)
+//return node at index k in order, NULL if k >= count
+rbtNode_t* rbtree_select(rbtree_t* t, size_t k);
+//return numbers of elements < key, is index of rbtree_find_best
+size_t rbtree_rank(rbtree_t* t, const void* key);
+//return index of node in order
+size_t rbtree_node_index(rbtNode_t* node);
+
+rbtNode_t* rbtree_node_next(rbtNode_t* node);
+rbtNode_t* rbtree_node_prev(rbtNode_t* node);
+//first node >= key, same of rbtree_find_best
+rbtNode_t* rbtree_lower_bound(rbtree_t* t, const void* key);
+//first node > key
+rbtNode_t* rbtree_upper_bound(rbtree_t* t, const void* key);
+
+/* cursor never allocate and use parent pointer, next node is prefetched while current is used
+ * rbtNode_t* n;
+ * rbtree_each(n, rbtree_cursor(t, 0)){ ... }
+ * rbtree_each(n, rbtree_cursor_range(rbtree_lower_bound(t, lo), rbtree_upper_bound(t, hi))){ ... } all lo <= key <= hi
+ */
+rbtCursor_s rbtree_cursor(rbtree_t* t, int reverse);
+//from begin to end excluded, NULL end walk to last
+rbtCursor_s rbtree_cursor_range(rbtNode_t* begin, rbtNode_t* end);
+rbtNode_t* rbtree_cursor_next(rbtCursor_s* c);
+#define rbtree_each(VAR, CURSOR) for( rbtCursor_s __cur__ = CURSOR; (VAR = rbtree_cursor_next(&__cur__)); )
+
+//iterator for map and foreach, one allocation for each walk and walk with cursor
 rbtree_i* rbtree_inorder_iterator(rbtree_t* t, unsigned offset, unsigned count);
 void* rbtree_inorder_iterate(void* IT);
+//from last to first, foreach(rbtree_reverse, t, node, offset, count)
+rbtree_i* rbtree_reverse_iterator(rbtree_t* t, unsigned offset, unsigned count);
+#define rbtree_reverse_iterate rbtree_inorder_iterate
+//iterate from first element >= key, foreach(rbtree_range, t, node, key, count)
+rbtree_i* rbtree_range_iterator(rbtree_t* t, const void* key, unsigned count);
+#define rbtree_range_iterate rbtree_inorder_iterate
 
 //void map_rbtree_inorder(rbtNode_t* n, rbtMap_f fn, void* arg);
 //void map_rbtree_preorder(rbtNode_t* n, rbtMap_f fn, void* arg);
 //void map_rbtree_postorder(rbtNode_t* n, rbtMap_f fn, void* arg);
 
 size_t rbtree_count(rbtree_t* t);
+//intrusive root of tree, read only, for walk or check with rbtree_link_*
+rbtRoot_s* rbtree_root(rbtree_t* t);
+
+/* build balanced tree in O(n) from data sorted with cmp of tree, node are created and gifted to t, colors are assigned without rotations
+ * @return NULL and errno ENOTEMPTY if t is not empty, EINVAL if data are not sorted
+ */
+rbtree_t* rbtree_bulk_build(rbtree_t* t, void** sorted, size_t n);
+/* move all nodes of b in a in O(n+m), b is empty after merge and is borrowed to a,
+ * nodes gifted to b are released when both a and b are freed
+ */
+rbtree_t* rbtree_merge(rbtree_t* a, rbtree_t* b);
+
+/* intrusive tree, rbtree_t is built on it
+ * link n as child of parent in *where, where is &parent->left or &parent->right or &root->root when tree is empty, and rebalance
+ */
+void rbtree_link_insert(rbtRoot_s* root, rbtLink_s* parent, rbtLink_s** where, rbtLink_s* n);
+//unlink n and rebalance, n color is RBT_RAINBOW after remove
+void rbtree_link_remove(rbtRoot_s* root, rbtLink_s* n);
+rbtLink_s* rbtree_link_first(rbtRoot_s* root);
+rbtLink_s* rbtree_link_last(rbtRoot_s* root);
+//successor and predecessor, NULL at end
+rbtLink_s* rbtree_link_next(rbtLink_s* n);
+rbtLink_s* rbtree_link_prev(rbtLink_s* n);
+rbtCursor_s rbtree_link_cursor(rbtLink_s* begin, rbtLink_s* end, int reverse);
+rbtLink_s* rbtree_link_cursor_next(rbtCursor_s* c);
+//root need to be empty, build balanced tree from n sorted links in O(n)
+void rbtree_link_build(rbtRoot_s* root, rbtLink_s** sorted, size_t n);
+//move all links of src in dst with linear merge, equal links of dst come first
+void rbtree_link_merge(rbtRoot_s* dst, rbtRoot_s* src, rbtLinkCmp_f cmp);
+
+/* RBTREE_DECLARE(name, type, link, key, cmp) generate typed function for a struct type that embed rbtLink_s link,
+ * key is member of type used as key, cmp(const keytype* a, const keytype* b) return <0, 0, >0 and is inlined.
+ * insert never allocate, lookup read only the struct of each level.
+ *
+ * typedef struct item{ rbtLink_s link; uint64_t id; }item_s;
+ * RBTREE_DECLARE(items, item_s, link, id, RBTREE_CMP)
+ * rbtRoot_s root = { NULL, 0, NULL };
+ * items_insert(&root, it);
+ * item_s* f = items_find(&root, &id);
+ *
+ * generated:
+ * type* name_find(rbtRoot_s* r, const keytype* key);
+ * type* name_find_best(rbtRoot_s* r, const keytype* key);  first element with key >= key
+ * void  name_insert(rbtRoot_s* r, type* e);                 key can be duplicated
+ * type* name_insertu(rbtRoot_s* r, type* e);                NULL if inserted, otherwise element with same key
+ * void  name_remove(rbtRoot_s* r, type* e);
+ * type* name_first(rbtRoot_s* r);  type* name_last(rbtRoot_s* r);
+ * type* name_next(type* e);        type* name_prev(type* e);
+ * void  name_build(rbtRoot_s* r, type* sorted, size_t n);    r is empty, array of n sorted elements, O(n)
+ * void  name_merge(rbtRoot_s* dst, rbtRoot_s* src);          O(n+m)
+ */
+
+#define RBTREE_CMP(A, B) ((*(A) > *(B)) - (*(A) < *(B)))
+
+#define RBTREE_DECLARE(NAME, T, LINK, KEY, CMP)\
+__unused __private inline T* NAME##_entry(rbtLink_s* l){\
+	return l ? container_of(l, T, LINK) : NULL;\
+}\
+\
+__unused __private inline T* NAME##_find(rbtRoot_s* r, const typeof(((T*)0)->KEY)* key){\
+	rbtLink_s* l = r->root;\
+	while( l ){\
+		T* e = container_of(l, T, LINK);\
+		const int c = CMP(&e->KEY, key);\
+		if( !c ) return e;\
+		l = c < 0 ? l->right : l->left;\
+	}\
+	return NULL;\
+}\
+\
+__unused __private inline T* NAME##_find_best(rbtRoot_s* r, const typeof(((T*)0)->KEY)* key){\
+	rbtLink_s* l = r->root;\
+	T* best = NULL;\
+	while( l ){\
+		T* e = container_of(l, T, LINK);\
+		if( CMP(&e->KEY, key) < 0 ){\
+			l = l->right;\
+		}\
+		else{\
+			best = e;\
+			l = l->left;\
+		}\
+	}\
+	return best;\
+}\
+\
+__unused __private inline void NAME##_insert(rbtRoot_s* r, T* e){\
+	rbtLink_s* p = NULL;\
+	rbtLink_s** w = &r->root;\
+	while( *w ){\
+		p = *w;\
+		w = CMP(&container_of(p, T, LINK)->KEY, &e->KEY) < 0 ? &p->right : &p->left;\
+	}\
+	rbtree_link_insert(r, p, w, &e->LINK);\
+}\
+\
+__unused __private inline T* NAME##_insertu(rbtRoot_s* r, T* e){\
+	rbtLink_s* p = NULL;\
+	rbtLink_s** w = &r->root;\
+	while( *w ){\
+		p = *w;\
+		T* f = container_of(p, T, LINK);\
+		const int c = CMP(&f->KEY, &e->KEY);\
+		if( !c ) return f;\
+		w = c < 0 ? &p->right : &p->left;\
+	}\
+	rbtree_link_insert(r, p, w, &e->LINK);\
+	return NULL;\
+}\
+\
+__unused __private inline void NAME##_remove(rbtRoot_s* r, T* e){\
+	rbtree_link_remove(r, &e->LINK);\
+}\
+\
+__unused __private inline T* NAME##_first(rbtRoot_s* r){\
+	return NAME##_entry(rbtree_link_first(r));\
+}\
+\
+__unused __private inline T* NAME##_last(rbtRoot_s* r){\
+	return NAME##_entry(rbtree_link_last(r));\
+}\
+\
+__unused __private inline T* NAME##_next(T* e){\
+	return NAME##_entry(rbtree_link_next(&e->LINK));\
+}\
+\
+__unused __private inline T* NAME##_prev(T* e){\
+	return NAME##_entry(rbtree_link_prev(&e->LINK));\
+}\
+\
+__unused __private void NAME##_build(rbtRoot_s* r, T* sorted, size_t n){\
+	__free rbtLink_s** v = MANY(rbtLink_s*, n ? n : 1);\
+	for( size_t i = 0; i < n; ++i ) v[i] = &sorted[i].LINK;\
+	rbtree_link_build(r, v, n);\
+}\
+\
+__unused __private int NAME##_linkcmp(const rbtLink_s* a, const rbtLink_s* b){\
+	return CMP(&container_of(a, T, LINK)->KEY, &container_of(b, T, LINK)->KEY);\
+}\
+\
+__unused __private void NAME##_merge(rbtRoot_s* dst, rbtRoot_s* src){\
+	rbtree_link_merge(dst, src, NAME##_linkcmp);\
+}
 
 #endif
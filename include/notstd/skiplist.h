@@ -0,0 +1,42 @@
+#ifndef __NOTSTD_CORE_SKIPLIST_H__
+#define __NOTSTD_CORE_SKIPLIST_H__
+
+#include <notstd/core.h>
+
+/* concurrent ordered map as lock free skip list, any numbers of threads can insert, remove, find and iterate without lock
+ * remove mark next pointers of node, marked node is unlinked from first thread that walk on it and released with epoch_retire
+ * cmp is called as cmp(data in list, key), same of rbtree_new, key is data or object compared as data
+ * list store only pointer, data returned from find can be removed from other thread while is used,
+ * lifetime of data is managed from caller, data removed can be released with epoch_retire
+ */
+
+//max height of tower, each level has probability 1/4, enough for 4^24 elements
+#define SKIPLIST_LEVEL_MAX 24
+
+typedef struct skiplist skiplist_t;
+typedef struct skiplistit skiplist_i;
+
+//free of list is not thread safe, all other threads need to have ended to use it
+skiplist_t* skiplist_new(cmp_f fn);
+//return -1 and errno EEXIST if data with same key exists
+int skiplist_insert(skiplist_t* sl, void* data);
+//return data of key or NULL
+void* skiplist_find(skiplist_t* sl, const void* key);
+//return first data >= key, NULL if not exists
+void* skiplist_find_best(skiplist_t* sl, const void* key);
+//return removed data or NULL, only one of threads that remove same key get data
+void* skiplist_remove(skiplist_t* sl, const void* key);
+//is approximate while other threads change the list
+size_t skiplist_count(skiplist_t* sl);
+
+/* iterator enter in epoch and leave when is released, need to be used and released from same thread
+ * data removed while iterate can be returned and data inserted can be not visible, order is always preserved
+ * foreach(skiplist_inorder, sl, data, 0, 0)
+ */
+skiplist_i* skiplist_inorder_iterator(skiplist_t* sl, unsigned offset, unsigned count);
+void* skiplist_inorder_iterate(void* IT);
+//iterate from first data >= key, foreach(skiplist_range, sl, data, key, count)
+skiplist_i* skiplist_range_iterator(skiplist_t* sl, const void* key, unsigned count);
+#define skiplist_range_iterate skiplist_inorder_iterate
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <notstd/core.h>
 #include <notstd/list.h>
+#include <notstd/topology.h>
 
 /********************/
 /*** generic lock ***/
@@ -58,6 +59,81 @@ int mutex_trylock(glock_s* mtx);
 
 #define mutex_guard(MTX) for( int _guard_ = mutex_lock(MTX); _guard_; _guard_ = 0, mutex_unlock(MTX) )
 
+/*****************/
+/*** condition ***/
+/*****************/
+
+/* condition variable, all waiters need to use same mutex, can't be used with glock_anyof/waitv */
+glock_s* cond_ctor(glock_s* cond, int sharedProcess);
+
+/* unlock mutex and wait signal, on return mutex is locked, spurious wakeup can happen, always recheck your condition
+ * mutex_guard(&mtx){
+ *	while( !ready ) cond_wait(&cond, &mtx);
+ * }
+ */
+void cond_wait(glock_s* cond, glock_s* mtx);
+
+/* wake one waiter */
+void cond_signal(glock_s* cond);
+
+/* wake one waiter and move all others on mutex futex, each waiter is wake from mutex_unlock without thundering herd */
+void cond_broadcast(glock_s* cond);
+
+/******************/
+/*** queue lock ***/
+/******************/
+
+//spin before sleep on futex while wait in queue
+#define QLOCK_SPIN 256
+//max consecutive handoff inside same numa node before release global lock
+#define COHORT_PASS 64
+
+typedef struct mcsNode mcsNode_s;
+
+//each thread in queue wait on own node, node live on stack of thread for all time of lock
+struct mcsNode{
+	mcsNode_s* next;
+	int locked;
+	int cohort;
+	unsigned node;
+};
+
+typedef struct mcs{
+	mcsNode_s* tail;
+	int private;
+}mcs_s;
+
+typedef struct cohort cohort_t;
+
+/* mcs queue lock, fifo and each waiter spin on own cache line */
+mcs_s* mcs_ctor(mcs_s* l, int sharedProcess);
+
+/* lock, qn is node of current thread and need to pass same node to mcs_unlock
+ * @return qn
+ */
+mcsNode_s* mcs_lock(mcs_s* l, mcsNode_s* qn);
+
+/* try to lock
+ * @return 0 if lock, -1 if other thread have lock
+ */
+int mcs_trylock(mcs_s* l, mcsNode_s* qn);
+
+void mcs_unlock(mcs_s* l, mcsNode_s* qn);
+
+#define mcs_guard(L) for( mcsNode_s _qnode_, *_guard_ = mcs_lock(L, &_qnode_); _guard_; _guard_ = NULL, mcs_unlock(L, &_qnode_) )
+
+/* numa cohort lock, one mcs for each numa node and global lock,
+ * the lock is passed to waiter on same node up to maxpass times before release global lock
+ * @param maxpass 0 use COHORT_PASS
+ */
+cohort_t* cohort_new(unsigned maxpass);
+
+mcsNode_s* cohort_lock(cohort_t* c, mcsNode_s* qn);
+
+void cohort_unlock(cohort_t* c, mcsNode_s* qn);
+
+#define cohort_guard(C) for( mcsNode_s _qnode_, *_guard_ = cohort_lock(C, &_qnode_); _guard_; _guard_ = NULL, cohort_unlock(C, &_qnode_) )
+
 /*****************/
 /*** semaphore ***/
 /*****************/
@@ -125,6 +201,9 @@ void event_fd_write(int fd, uint64_t val);
 /*** thread ***/
 /**************/
 
+//max parked os threads waiting to be reused from thr_new
+#define THR_POOL_PARKED 64
+
 typedef enum { THR_STATE_STOP, THR_STATE_RUN } thr_e;
 
 typedef struct thr thr_t;
@@ -133,26 +212,45 @@ typedef struct thr thr_t;
 typedef void(*thr_f)(thr_t* self, void* ctx);
 
 /* create and run new thread
+ * with stackSize and oncpu 0 the thread is taked from pool of parked os threads, when fn return the os thread is parked for next thr_new
  * @param fn function where start new thread
  * @param arg argument passed to fn
  * @param stackSize the stacksize, 0 use default value
- * @param oncpu assign thread to cpu, 0 auto
- * @param detach 1 set not joinable thread, 0 for joinable
+ * @param oncpu assign thread to cpu, 0 auto, decimal digits are cpu 1 to 9 (12 is cpu 0 and 1), use thr_new_mask for any cpu
+ * @param detach 1 set not joinable thread, 0 for joinable, ignored for pooled thread that are always joinable only with thr_wait
  * @return thread or NULL for error
  */
 thr_t* thr_new(thr_f fn, void* arg, unsigned stackSize, unsigned oncpu, int detach);
 
+/* same thr_new but with any cpu mask, thread with mask are never taked from pool
+ * @param mask cpu mask, NULL not set affinity
+ */
+thr_t* thr_new_mask(thr_f fn, void* arg, unsigned stackSize, const cpu_set_t* mask, int detach);
+
+/* same thr_new but cpu mask is build from topology with affinity policy
+ * @param policy see cpuAffinity_e
+ * @param index worker index, examples index 0..N for N worker in scatter mode
+ */
+thr_t* thr_new_affinity(thr_f fn, void* arg, unsigned stackSize, cpuAffinity_e policy, unsigned index, int detach);
+
 #define START(FN, ARG) thr_new(FN, ARG, 0, 0, 0)
+#define START_ON(FN, ARG, POLICY, INDEX) thr_new_affinity(FN, ARG, 0, POLICY, INDEX, 0)
 
 #define treturn(SELF, VAL) do{ thr_retval(SELF, VAL); return; }while(0)
 
 /* change thread cpu
  * @param thr thread
- * @param cpu cpu 1 to N
- * @return 0 successfull -1 error
+ * @param cpu decimal digits are cpu 1 to 9, 12 is cpu 0 and 1, for others cpu use thr_cpu_mask
  */
 void thr_cpu_set(thr_t* thr, unsigned cpu);
 
+/* change thread cpu with any mask, no effect after thread is ended,
+ * affinity of pooled thread is reset to process affinity when os thread is parked
+ * @param thr thread
+ * @param mask cpu mask
+ */
+void thr_cpu_mask(thr_t* thr, const cpu_set_t* mask);
+
 /* wait, aka join, a thread and return value in out
  * @param thr a thread
  * @param out return value of thread
@@ -192,4 +290,40 @@ unsigned long thr_id(thr_t* thr);
 
 void thr_retval(thr_t* thr, void* val);
 
+/* set max numbers of os threads parked in pool, exceeding parked threads are released
+ * @param max 0 disable pool
+ */
+void thr_pool_parked(unsigned max);
+
+/* numbers of os threads parked and ready to be reused */
+unsigned thr_pool_count(void);
+
+/*************/
+/*** epoch ***/
+/*************/
+
+/* epoch based reclamation for lock free structures, thread enter before read shared memory and leave after,
+ * writer unlink memory and retire it, retired memory is released when no thread in epoch can still reference it.
+ * enter and leave can be nested, each thread have own record created at first use and reused when thread end
+ */
+
+//elements retired from thread before try to advance epoch and release
+#define EPOCH_RETIRE_BATCH 64
+
+void epoch_enter(void);
+void epoch_leave(void);
+
+/* addr is released with fn when all threads have leave epoch where is retired, fn NULL is mem_free
+ * fn can't call epoch_retire
+ */
+void epoch_retire(void* addr, mcleanup_f fn);
+
+//try to advance epoch and release memory retired from this thread, return numbers of elements still waiting
+size_t epoch_reclaim(void);
+
+//wait until all memory retired from this thread is released, can't be called between enter and leave
+void epoch_barrier(void);
+
+#define epoch_guard() for( int _guard_ = (epoch_enter(), 1); _guard_; _guard_ = 0, epoch_leave() )
+
 #endif
@@ -0,0 +1,91 @@
+#ifndef __NOTSTD_CORE_TOPOLOGY_H__
+#define __NOTSTD_CORE_TOPOLOGY_H__
+
+#include <notstd/core.h>
+#include <sched.h>
+
+/* cpu topology readed from sysfs, only cpu online and usable from process are reported */
+
+//max cache level tracked for each cpu
+#define TOPOLOGY_CACHE_LEVEL 4
+
+typedef struct cpuCache{
+	unsigned level;    /**< 1 L1, 2 L2, ...*/
+	char type;         /**< 'D' data, 'I' instruction, 'U' unified*/
+	size_t size;       /**< size in bytes*/
+	unsigned line;     /**< coherency line size*/
+	cpu_set_t shared;  /**< cpus that share this cache*/
+}cpuCache_s;
+
+typedef struct cpuInfo{
+	unsigned id;                      /**< logical cpu, same id used in cpu_set_t*/
+	unsigned core;                    /**< index of physical core, unique on all packages*/
+	unsigned package;                 /**< physical package id*/
+	unsigned node;                    /**< numa node id*/
+	unsigned smt;                     /**< index of hardware thread inside the core*/
+	int cache[TOPOLOGY_CACHE_LEVEL];  /**< index of data or unified cache for level 1..N, -1 if not exists*/
+}cpuInfo_s;
+
+typedef struct topology{
+	cpuInfo_s* cpu;      /**< vector of cpu, compact order: node, package, core, smt*/
+	unsigned* scatter;   /**< vector of index of cpu, scatter order: smt, core, node*/
+	unsigned* node;      /**< vector of numa node id*/
+	unsigned* nodeof;    /**< vector indexed by logical cpu, index of node in node vector*/
+	cpuCache_s* cache;   /**< vector of distinct cache*/
+	unsigned cores;      /**< numbers of physical core*/
+	unsigned packages;   /**< numbers of packages*/
+}topology_s;
+
+typedef enum {
+	CPU_AFFINITY_NONE,    /**< no affinity, mask contains all usable cpu*/
+	CPU_AFFINITY_COMPACT, /**< index fill one cpu after other, smt siblings first*/
+	CPU_AFFINITY_SCATTER, /**< index spread on node and core before use smt siblings*/
+	CPU_AFFINITY_CORE,    /**< one physical core for index, mask contains all smt siblings*/
+	CPU_AFFINITY_NODE     /**< one numa node for index, mask contains all cpu of node*/
+}cpuAffinity_e;
+
+/* get topology, is loaded only at first call and is threads safe
+ * @return topology, never free it
+ */
+const topology_s* topology(void);
+
+/* numbers of usable cpu */
+unsigned topology_cpu_count(void);
+
+/* numbers of physical core */
+unsigned topology_core_count(void);
+
+/* numbers of numa node */
+unsigned topology_node_count(void);
+
+/* find info of logical cpu
+ * @param id logical cpu
+ * @return info or NULL if cpu is not usable
+ */
+const cpuInfo_s* topology_cpu(unsigned id);
+
+/* index of numa node in topology()->node for logical cpu, fast enough for call on each lock
+ * @param id logical cpu, examples sched_getcpu()
+ * @return index of node, 0 if cpu is unknown
+ */
+unsigned topology_node_index(unsigned id);
+
+/* print topology to stdout */
+void topology_dump(void);
+
+/* build mask for the worker index using policy, index is wrapped on numbers of cpu/core/node
+ * @param mask output
+ * @param policy affinity policy
+ * @param index worker index
+ * @return mask
+ */
+cpu_set_t* topology_affinity(cpu_set_t* mask, cpuAffinity_e policy, unsigned index);
+
+/* parse cpu list as kernel format, "0-3,8,10-11"
+ * @param set output, is zeroed before parse
+ * @param list string
+ * @return 0 successfull, -1 error and errno = EINVAL
+ */
+int cpuset_parse(cpu_set_t* set, const char* list);
+
+#endif
@@ -3,10 +3,21 @@
 
 #include <notstd/core.h>
 
+/* TRIE_EDGE, each node has vector of edges with interned label, edges are searched linearly, iterate in insertion order,
+ *            removed labels stay in pool until remove find more than twice labels of edges, then pool is rebuilt
+ *            walking all trie, memory is bounded to ~2x of live labels at cost of an O(edges) remove now and then
+ * TRIE_ART,  adaptive radix tree, nodes of 4, 16, 48 or 256 children indexed by byte with compressed path,
+ *            find is O(len) and read one byte for level, key is copied in leaf, iterate in byte order
+ */
+typedef enum { TRIE_EDGE, TRIE_ART } trieMode_e;
+
 typedef struct trie trie_t;
 typedef struct trieit trie_i;
 
+//same of trie_new_mode(TRIE_EDGE)
 trie_t* trie_new(void);
+trie_t* trie_new_mode(trieMode_e mode);
+trieMode_e trie_mode(trie_t* tr);
 int trie_insert(trie_t* tr, const char* str, unsigned len, void* data);
 void* trie_find(trie_t* tr, const char* str, unsigned len);
 int trie_remove(trie_t* tr,  const char* str, unsigned len);
@@ -0,0 +1,133 @@
+#include <notstd/threads.h>
+#include <notstd/vector.h>
+
+#include <pthread.h>
+
+/* global epoch advance only when all active records have seen it,
+ * memory retired in epoch e is released when global epoch is e+2,
+ * at this point all threads that could have a reference are leaved.
+ * record state is epoch << 1 | active, records are never released and are reused from new threads
+ * with memory still retired from the dead thread
+ */
+
+typedef struct epochItem{
+	void* addr;
+	mcleanup_f fn;
+	uint64_t epoch;
+}epochItem_s;
+
+typedef struct epochRecord epochRecord_s;
+
+struct epochRecord{
+	uint64_t state;
+	epochRecord_s* next;
+	int used;
+	unsigned nested;
+	size_t mark;
+	epochItem_s* retired;
+}__cacheline;
+
+__private struct{
+	uint64_t epoch;
+	epochRecord_s* records;
+	pthread_key_t key;
+}EPOCH;
+
+__private __thread epochRecord_s* EPOCHREC;
+
+/*** record ***/
+
+__private void epoch_thread_end(void* ctx){
+	epochRecord_s* rec = ctx;
+	rec->nested = 0;
+	__atomic_store_n(&rec->state, 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&rec->used, 0, __ATOMIC_RELEASE);
+}
+
+__ctor __private void epoch_ctor(void){
+	if( pthread_key_create(&EPOCH.key, epoch_thread_end) ) die("epoch key");
+}
+
+__private epochRecord_s* epoch_record_new(void){
+	uint8_t* raw = MANY(uint8_t, sizeof(epochRecord_s) + CACHE_LINE_SIZE);
+	epochRecord_s* rec = (epochRecord_s*)ROUND_UP(ADDR(raw), CACHE_LINE_SIZE);
+	rec->state   = 0;
+	rec->used    = 1;
+	rec->nested  = 0;
+	rec->mark    = 0;
+	rec->retired = VECTOR(epochItem_s, EPOCH_RETIRE_BATCH);
+	rec->next    = __atomic_load_n(&EPOCH.records, __ATOMIC_RELAXED);
+	while( !__atomic_compare_exchange_n(&EPOCH.records, &rec->next, rec, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED) );
+	return rec;
+}
+
+__private epochRecord_s* epoch_record(void){
+	if( EPOCHREC ) return EPOCHREC;
+	epochRecord_s* rec;
+	for( rec = __atomic_load_n(&EPOCH.records, __ATOMIC_ACQUIRE); rec; rec = rec->next ){
+		int unused = 0;
+		if( !__atomic_load_n(&rec->used, __ATOMIC_RELAXED) && __atomic_compare_exchange_n(&rec->used, &unused, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) ) break;
+	}
+	if( !rec ) rec = epoch_record_new();
+	pthread_setspecific(EPOCH.key, rec);
+	return EPOCHREC = rec;
+}
+
+/*** epoch ***/
+
+void epoch_enter(void){
+	epochRecord_s* rec = epoch_record();
+	if( rec->nested++ ) return;
+	const uint64_t e = __atomic_load_n(&EPOCH.epoch, __ATOMIC_ACQUIRE);
+	//full barrier, state is visible before any read of shared memory
+	__atomic_store_n(&rec->state, (e << 1) | 1, __ATOMIC_SEQ_CST);
+}
+
+void epoch_leave(void){
+	epochRecord_s* rec = EPOCHREC;
+	iassert( rec && rec->nested );
+	if( --rec->nested ) return;
+	__atomic_store_n(&rec->state, 0, __ATOMIC_RELEASE);
+}
+
+//return current epoch, advanced by one if all active threads have seen it
+__private uint64_t epoch_advance(void){
+	uint64_t e = __atomic_load_n(&EPOCH.epoch, __ATOMIC_SEQ_CST);
+	for( epochRecord_s* rec = __atomic_load_n(&EPOCH.records, __ATOMIC_ACQUIRE); rec; rec = rec->next ){
+		const uint64_t s = __atomic_load_n(&rec->state, __ATOMIC_SEQ_CST);
+		if( (s & 1) && (s >> 1) != e ) return e;
+	}
+	if( __atomic_compare_exchange_n(&EPOCH.epoch, &e, e + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) ) return e + 1;
+	return e;
+}
+
+size_t epoch_reclaim(void){
+	epochRecord_s* rec = epoch_record();
+	const uint64_t e = epoch_advance();
+	const size_t count = vector_count(&rec->retired);
+	size_t keep = 0;
+	for( size_t i = 0; i < count; ++i ){
+		epochItem_s* it = &rec->retired[i];
+		if( it->epoch + 2 <= e ) it->fn(it->addr);
+		else rec->retired[keep++] = *it;
+	}
+	vector_clear(&rec->retired);
+	vector_reserve(&rec->retired, keep);
+	rec->mark = keep;
+	return keep;
+}
+
+void epoch_retire(void* addr, mcleanup_f fn){
+	epochRecord_s* rec = epoch_record();
+	const size_t i = vector_fetch(&rec->retired);
+	rec->retired[i].addr  = addr;
+	rec->retired[i].fn    = fn ? fn : mem_free;
+	rec->retired[i].epoch = __atomic_load_n(&EPOCH.epoch, __ATOMIC_SEQ_CST);
+	//mark is count after last reclaim, elements blocked from slow thread are not scanned at each retire
+	if( i + 1 >= rec->mark + EPOCH_RETIRE_BATCH ) epoch_reclaim();
+}
+
+void epoch_barrier(void){
+	iassert( !EPOCHREC || !EPOCHREC->nested );
+	while( epoch_reclaim() ) thr_yield();
+}
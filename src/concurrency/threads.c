@@ -185,6 +185,164 @@ int mutex_trylock(glock_s* mtx){
 	return 0;
 }
 
+/*****************/
+/*** condition ***/
+/*****************/
+
+glock_s* cond_ctor(glock_s* cond, int sharedProcess){
+	return glock_ctor(cond, 0, sharedProcess, NULL);
+}
+
+//waiter can be requeued on mutex futex, need to lock in contended state otherwise next requeued waiter never wake
+__private void mutex_lock_contended(glock_s* mtx){
+	while( __atomic_exchange_n(&mtx->futex, 2, __ATOMIC_ACQUIRE) ){
+		glock_wait(mtx, 2);
+	}
+}
+
+void cond_wait(glock_s* cond, glock_s* mtx){
+	int seq = __atomic_load_n(&cond->futex, __ATOMIC_ACQUIRE);
+	if( cond->ctx != mtx ) __atomic_store_n(&cond->ctx, mtx, __ATOMIC_RELEASE);
+	mutex_unlock(mtx);
+	glock_wait(cond, seq);
+	mutex_lock_contended(mtx);
+}
+
+void cond_signal(glock_s* cond){
+	__atomic_add_fetch(&cond->futex, 1, __ATOMIC_RELEASE);
+	glock_wake(cond);
+}
+
+void cond_broadcast(glock_s* cond){
+	glock_s* mtx = __atomic_load_n(&cond->ctx, __ATOMIC_ACQUIRE);
+	if( !mtx ){
+		__atomic_add_fetch(&cond->futex, 1, __ATOMIC_RELEASE);
+		glock_broadcast(cond);
+		return;
+	}
+	unsigned const op = FUTEX_CMP_REQUEUE | cond->private;
+	int seq = __atomic_add_fetch(&cond->futex, 1, __ATOMIC_RELEASE);
+	//wake one, others are moved on mutex and wake one by one from mutex_unlock
+	while( futex(&cond->futex, op, 1, (unsigned)INT_MAX, &mtx->futex, seq) == -1 && errno == EAGAIN ){
+		seq = __atomic_load_n(&cond->futex, __ATOMIC_ACQUIRE);
+	}
+}
+
+/******************/
+/*** queue lock ***/
+/******************/
+
+mcs_s* mcs_ctor(mcs_s* l, int sharedProcess){
+	l->tail    = NULL;
+	l->private = sharedProcess ? 0 : FUTEX_PRIVATE_FLAG;
+	return l;
+}
+
+//locked: 0 owner, 1 spin, 2 sleep on futex
+__private void mcs_node_wait(mcsNode_s* qn, int private){
+	for( unsigned i = 0; i < QLOCK_SPIN; ++i ){
+		if( !__atomic_load_n(&qn->locked, __ATOMIC_ACQUIRE) ) return;
+		cpu_relax();
+	}
+	if( !__sync_bool_compare_and_swap(&qn->locked, 1, 2) ) return;
+	while( __atomic_load_n(&qn->locked, __ATOMIC_ACQUIRE) == 2 ){
+		futex(&qn->locked, FUTEX_WAIT | private, 2, NULL, NULL, 0);
+	}
+}
+
+__private int mcs_waiter(mcs_s* l, mcsNode_s* qn){
+	return __atomic_load_n(&qn->next, __ATOMIC_ACQUIRE) || __atomic_load_n(&l->tail, __ATOMIC_ACQUIRE) != qn;
+}
+
+__private void mcs_release(mcs_s* l, mcsNode_s* qn, int cohort){
+	mcsNode_s* next = __atomic_load_n(&qn->next, __ATOMIC_ACQUIRE);
+	if( !next ){
+		mcsNode_s* expected = qn;
+		if( __atomic_compare_exchange_n(&l->tail, &expected, NULL, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED) ) return;
+		//successor is enqueuing
+		while( !(next = __atomic_load_n(&qn->next, __ATOMIC_ACQUIRE)) ) cpu_relax();
+	}
+	next->cohort = cohort;
+	//after store next can return and release stack, futex on released address wake nobody
+	if( __atomic_exchange_n(&next->locked, 0, __ATOMIC_RELEASE) == 2 ){
+		futex(&next->locked, FUTEX_WAKE | l->private, 1, NULL, NULL, 0);
+	}
+}
+
+mcsNode_s* mcs_lock(mcs_s* l, mcsNode_s* qn){
+	qn->next   = NULL;
+	qn->locked = 1;
+	qn->cohort = 0;
+	mcsNode_s* prev = __atomic_exchange_n(&l->tail, qn, __ATOMIC_ACQ_REL);
+	if( prev ){
+		__atomic_store_n(&prev->next, qn, __ATOMIC_RELEASE);
+		mcs_node_wait(qn, l->private);
+	}
+	return qn;
+}
+
+int mcs_trylock(mcs_s* l, mcsNode_s* qn){
+	qn->next   = NULL;
+	qn->locked = 0;
+	qn->cohort = 0;
+	mcsNode_s* expected = NULL;
+	return __atomic_compare_exchange_n(&l->tail, &expected, qn, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) ? 0 : -1;
+}
+
+void mcs_unlock(mcs_s* l, mcsNode_s* qn){
+	mcs_release(l, qn, 0);
+}
+
+typedef struct cohortLocal{
+	mcs_s lock;
+	unsigned pass;
+}__cacheline cohortLocal_s;
+
+struct cohort{
+	glock_s global;
+	unsigned maxpass;
+	unsigned count;
+	cohortLocal_s* local;
+};
+
+cohort_t* cohort_new(unsigned maxpass){
+	cohort_t* c = NEW(cohort_t);
+	mutex_ctor(&c->global, 0);
+	c->maxpass = maxpass ? maxpass : COHORT_PASS;
+	c->count   = topology_node_count();
+	//one more element for realign to cache line
+	void* local = mem_gift(MANY(cohortLocal_s, c->count + 1), c);
+	c->local   = (cohortLocal_s*)ROUND_UP(ADDR(local), CACHE_LINE_SIZE);
+	for( unsigned i = 0; i < c->count; ++i ){
+		mcs_ctor(&c->local[i].lock, 0);
+		c->local[i].pass = 0;
+	}
+	return c;
+}
+
+mcsNode_s* cohort_lock(cohort_t* c, mcsNode_s* qn){
+	int cpu = sched_getcpu();
+	unsigned node = c->count > 1 && cpu >= 0 ? topology_node_index(cpu) : 0;
+	if( node >= c->count ) node = 0;
+	mcs_lock(&c->local[node].lock, qn);
+	qn->node = node;
+	//global lock is passed from previous owner on same node
+	if( !qn->cohort ) mutex_lock(&c->global);
+	return qn;
+}
+
+void cohort_unlock(cohort_t* c, mcsNode_s* qn){
+	cohortLocal_s* local = &c->local[qn->node];
+	if( local->pass < c->maxpass && mcs_waiter(&local->lock, qn) ){
+		++local->pass;
+		mcs_release(&local->lock, qn, 1);
+		return;
+	}
+	local->pass = 0;
+	mutex_unlock(&c->global);
+	mcs_release(&local->lock, qn, 0);
+}
+
 /*****************/
 /*** semaphore ***/
 /*****************/
@@ -295,84 +453,222 @@ void event_fd_write(int fd, uint64_t val){
 /*** thread ***/
 /**************/
 
+//evstop.futex store thr_e, join only read the state and never consume the event
 typedef struct thr{
-	pthread_t id;
-    pthread_attr_t attr;
-	thr_e state;
 	glock_s evstop;
+	pthread_t id;
 	thr_f fn;
 	void* arg;
 	void* ret;
+	struct thrWorker* worker;
 }thr_t;
 
-__private cpu_set_t* thr_setcpu(unsigned mcpu){
-	static cpu_set_t cpu;
-	CPU_ZERO(&cpu);
-	if (mcpu == 0 ) return &cpu;
+typedef struct thrWorker thrWorker_s;
+
+//os thread parked in pool, wait a job on evjob, job NULL for exit, pinned when job change affinity
+struct thrWorker{
+	thrWorker_s* next;
+	pthread_t id;
+	glock_s evjob;
+	thr_t* job;
+	int pinned;
+};
+
+//lock protect also affinity of pooled jobs, job that end not change more affinity of worker
+__private struct{
+	glock_s lock;
+	thrWorker_s* parked;
+	unsigned count;
+	unsigned max;
+	cpu_set_t mask;
+}THRPOOL = {
+	.lock = { .futex = 0, .private = FUTEX_PRIVATE_FLAG, .wait = mutex_glock_event },
+	.parked = NULL,
+	.count = 0,
+	.max = THR_POOL_PARKED
+};
+
+//affinity of process, parked worker return to this mask
+__ctor __private void thr_pool_ctor(void){
+	if( sched_getaffinity(0, sizeof(cpu_set_t), &THRPOOL.mask) ) die("sched get affinity");
+}
+
+__private cpu_set_t* thr_setcpu(cpu_set_t* cpu, unsigned mcpu){
+	CPU_ZERO(cpu);
+	if (mcpu == 0 ) return cpu;
 	unsigned s;
 	while ( (s = mcpu % 10) ){
-		CPU_SET(s - 1,&cpu);
+		CPU_SET(s - 1, cpu);
 		mcpu /= 10;
 	}
-	return &cpu;
+	return cpu;
+}
+
+__private void thr_end(thr_t* t){
+	//after cas joiner can release t, not touch more than futex address
+	unsigned const op = FUTEX_WAKE | t->evstop.private;
+	if( __sync_bool_compare_and_swap(&t->evstop.futex, THR_STATE_RUN, THR_STATE_STOP) ){
+		futex(&t->evstop.futex, op, INT_MAX, NULL, NULL, 0);
+		return;
+	}
+	//thr_stop win the race and cancel is on the way
+	forever() pthread_testcancel();
 }
 
 __private void* pthr_wrap(void* ctx){
 	thr_t* t = ctx;
-	mem_acquire_write(t){
-		t->state = THR_STATE_RUN;
-	}
-	
 	t->fn(t, t->arg);
+	thr_end(t);
+	return NULL;
+}
 
-	mem_acquire_write(t){
-		t->state = THR_STATE_STOP;
+__private int thr_park(thrWorker_s* w){
+	int park = 0;
+	mutex_guard(&THRPOOL.lock){
+		if( w->pinned ){
+			if( pthread_setaffinity_np(w->id, sizeof(cpu_set_t), &THRPOOL.mask) ) die("pthread set affinity");
+			w->pinned = 0;
+		}
+		if( THRPOOL.count < THRPOOL.max ){
+			w->next = THRPOOL.parked;
+			THRPOOL.parked = w;
+			++THRPOOL.count;
+			park = 1;
+		}
 	}
+	return park;
+}
 
-	event_broadcast(&t->evstop);
-	return t->ret;
+__private thrWorker_s* thr_unpark(void){
+	thrWorker_s* w = NULL;
+	mutex_guard(&THRPOOL.lock){
+		if( (w = THRPOOL.parked) ){
+			THRPOOL.parked = w->next;
+			--THRPOOL.count;
+		}
+	}
+	return w;
+}
+
+__private void thr_worker_cleanup(void* ctx){
+	mem_free(ctx);
+}
+
+__private void* thr_worker(void* ctx){
+	thrWorker_s* w = ctx;
+	w->id = pthread_self();
+	pthread_cleanup_push(thr_worker_cleanup, w);
+	do{
+		event_wait(&w->evjob);
+		thr_t* t = w->job;
+		if( !t ) break;
+		w->job = NULL;
+		t->fn(t, t->arg);
+		thr_end(t);
+	}while( thr_park(w) );
+	pthread_cleanup_pop(1);
+	return NULL;
+}
+
+__private void thr_pooled(thr_t* thr){
+	thrWorker_s* w = thr_unpark();
+	if( w ){
+		thr->id = w->id;
+		thr->worker = w;
+		w->job = thr;
+		event_raise(&w->evjob);
+		return;
+	}
+
+	w = NEW(thrWorker_s);
+	event_ctor(&w->evjob, 0);
+	w->evjob.futex = 1;
+	w->job = thr;
+	w->next = NULL;
+	w->pinned = 0;
+	thr->worker = w;
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	if( pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) ) die("pthread detach state");
+	if( pthread_create(&thr->id, &attr, thr_worker, w) ) die("pthread create");
+	pthread_attr_destroy(&attr);
+}
+
+__private void thr_dedicated(thr_t* thr, unsigned stackSize, const cpu_set_t* mask, int detach){
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	if( stackSize > 0 && pthread_attr_setstacksize(&attr, stackSize) ) die("pthread stack size");
+	if( mask && pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), mask) ) die("pthread set affinity");
+	if( pthread_attr_setdetachstate(&attr, detach ? PTHREAD_CREATE_DETACHED : PTHREAD_CREATE_JOINABLE) ) die("pthread detach state");
+	if( pthread_create(&thr->id, &attr, pthr_wrap, thr) ) die("pthread create");
+	pthread_attr_destroy(&attr);
 }
 
 __private void thr_dtor(thr_t* thr){
 	thr_stop(thr);
-	pthread_attr_destroy(&thr->attr);
-	free(thr);
 }
 
 __private int thr_glock_event(glock_s* gl, int* waitval){
-	if( !event_glock_event(gl, waitval) ) return 0;
-	thr_t* t = gl->ctx;
-	thr_e  s = THR_STATE_RUN;
-	mem_acquire_read(t){
-		s = t->state;
-	}
-	return s == THR_STATE_STOP ? 1 : 0;
+	if( __atomic_load_n(&gl->futex, __ATOMIC_ACQUIRE) == THR_STATE_STOP ) return 1;
+	*waitval = THR_STATE_RUN;
+	return 0;
 }
 
-thr_t* thr_new(thr_f fn, void* arg, unsigned stackSize, unsigned oncpu, int detach){
+__private thr_t* thr_handle(thr_f fn, void* arg){
 	thr_t* thr = NEW(thr_t);
 	mem_cleanup(thr, (mcleanup_f)thr_dtor);
-	event_ctor(&thr->evstop, 0);
-	thr->evstop.wait = thr_glock_event;
+	glock_ctor(&thr->evstop, THR_STATE_RUN, 0, thr_glock_event);
 	thr->evstop.ctx = thr;
-	thr->state = THR_STATE_RUN;
 	thr->fn = fn;
 	thr->arg = arg;
 	thr->ret = NULL;
+	thr->worker = NULL;
+	return thr;
+}
 
-	pthread_attr_init(&thr->attr);
-    if ( stackSize > 0 && pthread_attr_setstacksize(&thr->attr, stackSize) ) die("pthread stack size");
-	thr_cpu_set(thr, oncpu);
-	if( pthread_attr_setdetachstate(&thr->attr, detach ? PTHREAD_CREATE_DETACHED : PTHREAD_CREATE_JOINABLE) ) die("pthread detach state");
-	if( pthread_create(&thr->id, &thr->attr, pthr_wrap, thr) ) die("pthread create");
+thr_t* thr_new(thr_f fn, void* arg, unsigned stackSize, unsigned oncpu, int detach){
+	thr_t* thr = thr_handle(fn, arg);
+	if( !stackSize && !oncpu ){
+		thr_pooled(thr);
+	}
+	else{
+		cpu_set_t ncpu;
+		thr_dedicated(thr, stackSize, oncpu ? thr_setcpu(&ncpu, oncpu) : NULL, detach);
+	}
+	return thr;
+}
 
+thr_t* thr_new_mask(thr_f fn, void* arg, unsigned stackSize, const cpu_set_t* mask, int detach){
+	thr_t* thr = thr_handle(fn, arg);
+	if( !stackSize && !mask ){
+		thr_pooled(thr);
+	}
+	else{
+		thr_dedicated(thr, stackSize, mask, detach);
+	}
 	return thr;
 }
 
+thr_t* thr_new_affinity(thr_f fn, void* arg, unsigned stackSize, cpuAffinity_e policy, unsigned index, int detach){
+	if( policy == CPU_AFFINITY_NONE ) return thr_new_mask(fn, arg, stackSize, NULL, detach);
+	cpu_set_t mask;
+	return thr_new_mask(fn, arg, stackSize, topology_affinity(&mask, policy, index), detach);
+}
+
 void thr_cpu_set(thr_t* thr, unsigned cpu){
 	if( cpu > 0 ){
-		cpu_set_t* ncpu = thr_setcpu(cpu);
-		if( pthread_attr_setaffinity_np(&thr->attr, CPU_SETSIZE, ncpu) ) die("pthread set affinity");
+		cpu_set_t ncpu;
+		thr_cpu_mask(thr, thr_setcpu(&ncpu, cpu));
+	}
+}
+
+//ended pooled job has id of worker that can run other job
+void thr_cpu_mask(thr_t* thr, const cpu_set_t* mask){
+	mutex_guard(&THRPOOL.lock){
+		if( thr_check(thr) == THR_STATE_RUN ){
+			if( pthread_setaffinity_np(thr->id, sizeof(cpu_set_t), mask) ) die("pthread set affinity");
+			if( thr->worker ) thr->worker->pinned = 1;
+		}
 	}
 }
 
@@ -381,11 +677,7 @@ void thr_wait(thr_t* thr){
 }
 
 thr_e thr_check(thr_t* thr){
-	thr_e state = THR_STATE_RUN;
-	mem_acquire_read(thr){
-		state = thr->state;
-	}
-	return state;
+	return __atomic_load_n(&thr->evstop.futex, __ATOMIC_ACQUIRE);
 }
 
 void thr_waitv(thr_t** thr, unsigned count){
@@ -405,12 +697,9 @@ thr_t* thr_anyof(thr_t** thr, unsigned count){
 }
 
 void thr_stop(thr_t* thr){
-	mem_acquire_write(thr){
-		if( thr->state != THR_STATE_STOP ){
-			if( pthread_cancel(thr->id) ) die("pthread cancel");
-			thr->state = THR_STATE_STOP;
-			event_broadcast(&thr->evstop);
-		}
+	if( __sync_bool_compare_and_swap(&thr->evstop.futex, THR_STATE_RUN, THR_STATE_STOP) ){
+		if( pthread_cancel(thr->id) ) die("pthread cancel");
+		glock_broadcast(&thr->evstop);
 	}
 }
 
@@ -426,3 +715,26 @@ void thr_retval(thr_t* thr, void* val){
 	thr->ret = val;
 }
 
+void thr_pool_parked(unsigned max){
+	thrWorker_s* exited = NULL;
+	mutex_guard(&THRPOOL.lock){
+		THRPOOL.max = max;
+		while( THRPOOL.count > THRPOOL.max ){
+			thrWorker_s* w = THRPOOL.parked;
+			THRPOOL.parked = w->next;
+			--THRPOOL.count;
+			w->next = exited;
+			exited = w;
+		}
+	}
+	while( exited ){
+		thrWorker_s* w = exited;
+		exited = w->next;
+		w->job = NULL;
+		event_raise(&w->evjob);
+	}
+}
+
+unsigned thr_pool_count(void){
+	return __atomic_load_n(&THRPOOL.count, __ATOMIC_RELAXED);
+}
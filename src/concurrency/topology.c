@@ -0,0 +1,329 @@
+#include <notstd/topology.h>
+#include <notstd/vector.h>
+
+#include <dirent.h>
+
+#define SYS_CPU  "/sys/devices/system/cpu"
+#define SYS_NODE "/sys/devices/system/node"
+
+__private topology_s TOPOLOGY;
+__private pthread_once_t TOPOLOGY_ONCE = PTHREAD_ONCE_INIT;
+
+__private int sys_read(char* buf, size_t size, const char* format, ...){
+	char path[PATH_MAX];
+	va_list ap;
+	va_start(ap, format);
+	vsnprintf(path, PATH_MAX, format, ap);
+	va_end(ap);
+
+	int fd = open(path, O_RDONLY);
+	if( fd == -1 ) return -1;
+	ssize_t nr = read(fd, buf, size-1);
+	close(fd);
+	if( nr < 0 ) return -1;
+	while( nr > 0 && isspace(buf[nr-1]) ) --nr;
+	buf[nr] = 0;
+	return 0;
+}
+
+__private long sys_read_long(long def, const char* format, unsigned a, unsigned b){
+	char buf[64];
+	if( sys_read(buf, sizeof buf, format, a, b) ) return def;
+	char* end;
+	long v = strtol(buf, &end, 10);
+	if( end == buf ) return def;
+	switch( *end ){
+		case 'K': v *= KiB; break;
+		case 'M': v *= MiB; break;
+	}
+	return v;
+}
+
+int cpuset_parse(cpu_set_t* set, const char* list){
+	CPU_ZERO(set);
+	while( *list ){
+		char* end;
+		unsigned long a = strtoul(list, &end, 10);
+		if( end == list ) goto ONERR;
+		unsigned long b = a;
+		list = end;
+		if( *list == '-' ){
+			b = strtoul(++list, &end, 10);
+			if( end == list || b < a ) goto ONERR;
+			list = end;
+		}
+		if( b >= CPU_SETSIZE ) goto ONERR;
+		for( ; a <= b; ++a ) CPU_SET(a, set);
+		if( *list == ',' ) ++list;
+		else if( *list && !isspace(*list) ) goto ONERR;
+		else break;
+	}
+	return 0;
+ONERR:
+	errno = EINVAL;
+	return -1;
+}
+
+__private int cpu_cmp_compact(const void* A, const void* B){
+	const cpuInfo_s* a = A;
+	const cpuInfo_s* b = B;
+	if( a->node != b->node ) return a->node < b->node ? -1 : 1;
+	if( a->package != b->package ) return a->package < b->package ? -1 : 1;
+	if( a->core != b->core ) return a->core < b->core ? -1 : 1;
+	return a->id < b->id ? -1 : a->id > b->id;
+}
+
+__private int cpu_cmp_scatter(const void* A, const void* B, void* KEY){
+	const unsigned a = *(const unsigned*)A;
+	const unsigned b = *(const unsigned*)B;
+	const unsigned* key = KEY;
+	if( key[a] != key[b] ) return key[a] < key[b] ? -1 : 1;
+	return a < b ? -1 : a > b;
+}
+
+__private int cache_find(cpuCache_s* cache, unsigned level, char type, cpu_set_t* shared){
+	foreach_vector(cache, i){
+		if( cache[i].level == level && cache[i].type == type && CPU_EQUAL(&cache[i].shared, shared) ) return i;
+	}
+	return -1;
+}
+
+__private void cpu_cache_load(topology_s* tp, cpuInfo_s* ci){
+	char buf[256];
+	for( unsigned i = 0; i < TOPOLOGY_CACHE_LEVEL; ++i ) ci->cache[i] = -1;
+	for( unsigned index = 0; ; ++index ){
+		if( sys_read(buf, sizeof buf, SYS_CPU "/cpu%u/cache/index%u/type", ci->id, index) ) break;
+		char type = buf[0];
+		long level = sys_read_long(0, SYS_CPU "/cpu%u/cache/index%u/level", ci->id, index);
+		if( level < 1 || level > TOPOLOGY_CACHE_LEVEL ) continue;
+		cpu_set_t shared;
+		if( sys_read(buf, sizeof buf, SYS_CPU "/cpu%u/cache/index%u/shared_cpu_list", ci->id, index) || cpuset_parse(&shared, buf) ){
+			CPU_ZERO(&shared);
+			CPU_SET(ci->id, &shared);
+		}
+		int id = cache_find(tp->cache, level, type, &shared);
+		if( id == -1 ){
+			cpuCache_s* c = vector_push(&tp->cache, NULL);
+			c->level  = level;
+			c->type   = type;
+			c->size   = sys_read_long(0, SYS_CPU "/cpu%u/cache/index%u/size", ci->id, index);
+			c->line   = sys_read_long(64, SYS_CPU "/cpu%u/cache/index%u/coherency_line_size", ci->id, index);
+			c->shared = shared;
+			id = vector_count(&tp->cache) - 1;
+		}
+		if( type != 'I' ) ci->cache[level-1] = id;
+	}
+}
+
+__private void node_load(topology_s* tp){
+	char buf[4096];
+	DIR* d = opendir(SYS_NODE);
+	if( d ){
+		struct dirent* de;
+		while( (de = readdir(d)) ){
+			unsigned node;
+			if( sscanf(de->d_name, "node%u", &node) != 1 ) continue;
+			cpu_set_t set;
+			if( sys_read(buf, sizeof buf, SYS_NODE "/node%u/cpulist", node) || cpuset_parse(&set, buf) ) continue;
+			int used = 0;
+			foreach_vector(tp->cpu, i){
+				if( CPU_ISSET(tp->cpu[i].id, &set) ){
+					tp->cpu[i].node = node;
+					used = 1;
+				}
+			}
+			if( used ) vector_push(&tp->node, &node);
+		}
+		closedir(d);
+	}
+	if( !vector_count(&tp->node) ){
+		unsigned node = 0;
+		vector_push(&tp->node, &node);
+	}
+}
+
+__private int uint_cmp(const void* A, const void* B){
+	const unsigned a = *(const unsigned*)A;
+	const unsigned b = *(const unsigned*)B;
+	return a < b ? -1 : a > b;
+}
+
+__private void topology_load(void){
+	topology_s* tp = &TOPOLOGY;
+	char buf[4096];
+	cpu_set_t usable;
+	cpu_set_t online;
+
+	if( sched_getaffinity(0, sizeof(cpu_set_t), &usable) ){
+		CPU_ZERO(&usable);
+		for( long i = 0; i < sysconf(_SC_NPROCESSORS_ONLN) && i < CPU_SETSIZE; ++i ) CPU_SET(i, &usable);
+	}
+	if( !sys_read(buf, sizeof buf, SYS_CPU "/online") && !cpuset_parse(&online, buf) ){
+		CPU_AND(&usable, &usable, &online);
+	}
+
+	tp->cpu   = VECTOR(cpuInfo_s, CPU_COUNT(&usable));
+	tp->cache = VECTOR(cpuCache_s, 8);
+	tp->node  = VECTOR(unsigned, 2);
+
+	for( unsigned id = 0; id < CPU_SETSIZE; ++id ){
+		if( !CPU_ISSET(id, &usable) ) continue;
+		cpuInfo_s* ci = vector_push(&tp->cpu, NULL);
+		ci->id      = id;
+		ci->package = sys_read_long(0, SYS_CPU "/cpu%u/topology/physical_package_id", id, 0);
+		//core_id is unique only in package, temporary use it
+		ci->core    = sys_read_long(id, SYS_CPU "/cpu%u/topology/core_id", id, 0);
+		ci->node    = 0;
+		ci->smt     = 0;
+		cpu_cache_load(tp, ci);
+	}
+
+	node_load(tp);
+	vector_qsort(&tp->node, uint_cmp);
+	vector_qsort(&tp->cpu, cpu_cmp_compact);
+
+	//renumber core as unique index, smt as index inside core
+	const unsigned count = vector_count(&tp->cpu);
+	cpu_set_t packages;
+	CPU_ZERO(&packages);
+	unsigned core = 0;
+	unsigned smt = 0;
+	unsigned prevcore = 0;
+	for( unsigned i = 0; i < count; ++i ){
+		cpuInfo_s* ci = &tp->cpu[i];
+		const unsigned coreid = ci->core;
+		if( i > 0 ){
+			cpuInfo_s* prev = &tp->cpu[i-1];
+			if( prev->node == ci->node && prev->package == ci->package && prevcore == coreid ){
+				++smt;
+			}
+			else{
+				++core;
+				smt = 0;
+			}
+		}
+		prevcore = coreid;
+		ci->core = core;
+		ci->smt  = smt;
+		if( ci->package < CPU_SETSIZE ) CPU_SET(ci->package, &packages);
+	}
+	tp->cores = count ? core + 1 : 0;
+	tp->packages = CPU_COUNT(&packages);
+
+	//scatter key: smt first, then rank of core inside node, then node
+	__free unsigned* key = MANY(unsigned, count ? count : 1);
+	const unsigned nodes = vector_count(&tp->node);
+	unsigned rank = 0;
+	unsigned nodeindex = 0;
+	for( unsigned i = 0; i < count; ++i ){
+		if( i > 0 && tp->cpu[i].node != tp->cpu[i-1].node ){
+			rank = 0;
+			++nodeindex;
+		}
+		else if( i > 0 && tp->cpu[i].smt == 0 ){
+			++rank;
+		}
+		key[i] = (tp->cpu[i].smt * count + rank) * nodes + nodeindex;
+	}
+	tp->scatter = VECTOR(unsigned, count ? count : 1);
+	for( unsigned i = 0; i < count; ++i ) vector_push(&tp->scatter, &i);
+	qsort_r(tp->scatter, count, sizeof(unsigned), cpu_cmp_scatter, key);
+
+	unsigned maxid = 0;
+	for( unsigned i = 0; i < count; ++i ) if( tp->cpu[i].id > maxid ) maxid = tp->cpu[i].id;
+	tp->nodeof = VECTOR(unsigned, maxid+1);
+	for( unsigned i = 0; i <= maxid; ++i ) *(unsigned*)vector_push(&tp->nodeof, NULL) = 0;
+	nodeindex = 0;
+	for( unsigned i = 0; i < count; ++i ){
+		if( i > 0 && tp->cpu[i].node != tp->cpu[i-1].node ) ++nodeindex;
+		tp->nodeof[tp->cpu[i].id] = nodeindex;
+	}
+}
+
+const topology_s* topology(void){
+	pthread_once(&TOPOLOGY_ONCE, topology_load);
+	return &TOPOLOGY;
+}
+
+unsigned topology_cpu_count(void){
+	const topology_s* tp = topology();
+	return vector_count(&tp->cpu);
+}
+
+unsigned topology_core_count(void){
+	return topology()->cores;
+}
+
+unsigned topology_node_count(void){
+	const topology_s* tp = topology();
+	return vector_count(&tp->node);
+}
+
+const cpuInfo_s* topology_cpu(unsigned id){
+	const topology_s* tp = topology();
+	foreach_vector(tp->cpu, i){
+		if( tp->cpu[i].id == id ) return &tp->cpu[i];
+	}
+	return NULL;
+}
+
+unsigned topology_node_index(unsigned id){
+	const topology_s* tp = topology();
+	if( id >= vector_count(&tp->nodeof) ) return 0;
+	return tp->nodeof[id];
+}
+
+cpu_set_t* topology_affinity(cpu_set_t* mask, cpuAffinity_e policy, unsigned index){
+	const topology_s* tp = topology();
+	const unsigned count = vector_count(&tp->cpu);
+	CPU_ZERO(mask);
+	if( !count ) return mask;
+
+	switch( policy ){
+		default: case CPU_AFFINITY_NONE:
+			foreach_vector(tp->cpu, i) CPU_SET(tp->cpu[i].id, mask);
+		break;
+
+		case CPU_AFFINITY_COMPACT:
+			CPU_SET(tp->cpu[index % count].id, mask);
+		break;
+
+		case CPU_AFFINITY_SCATTER:
+			CPU_SET(tp->cpu[tp->scatter[index % count]].id, mask);
+		break;
+
+		case CPU_AFFINITY_CORE:{
+			const unsigned core = index % tp->cores;
+			foreach_vector(tp->cpu, i){
+				if( tp->cpu[i].core == core ) CPU_SET(tp->cpu[i].id, mask);
+			}
+		}
+		break;
+
+		case CPU_AFFINITY_NODE:{
+			const unsigned node = tp->node[index % vector_count(&tp->node)];
+			foreach_vector(tp->cpu, i){
+				if( tp->cpu[i].node == node ) CPU_SET(tp->cpu[i].id, mask);
+			}
+		}
+		break;
+	}
+	return mask;
+}
+
+void topology_dump(void){
+	const topology_s* tp = topology();
+	printf("cpu:%u core:%u package:%u node:%u\n", topology_cpu_count(), tp->cores, tp->packages, topology_node_count());
+	foreach_vector(tp->cpu, i){
+		const cpuInfo_s* ci = &tp->cpu[i];
+		printf("cpu%-4u core:%-4u smt:%u package:%u node:%u cache:", ci->id, ci->core, ci->smt, ci->package, ci->node);
+		for( unsigned l = 0; l < TOPOLOGY_CACHE_LEVEL; ++l ){
+			if( ci->cache[l] != -1 ) printf(" L%u#%d", l+1, ci->cache[l]);
+		}
+		putchar('\n');
+	}
+	foreach_vector(tp->cache, i){
+		const cpuCache_s* c = &tp->cache[i];
+		printf("cache#%-3lu L%u%c size:%lu line:%u shared:%d\n", i, c->level, c->type, c->size, c->line, CPU_COUNT(&c->shared));
+	}
+}
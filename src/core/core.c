@@ -1,9 +1,11 @@
 #include <notstd/core.h>
 #include <notstd/mth.h>
+#include <notstd/delay.h>
 
 __ctor void notstd_begin(void){
 	mth_random_begin();
 	page_begin();
+	time_begin();
 	//deadpoll_begin();
 }
 
@@ -0,0 +1,480 @@
+#include <notstd/btree.h>
+
+/* node is header and body, body of leaf is keys[lcap] and data[lcap], body of inner is keys[icap] and child[icap+1]
+ * inner child[i] have keys < keys[i] and >= keys[i-1], separator is copy of first key of right subtree
+ * keys are packed at start of body, lookup touch only cache line of keys
+ */
+typedef struct btNode{
+	uint16_t count;
+	uint16_t leaf;
+	uint32_t reserved;
+	struct btNode* next;
+	struct btNode* prev;
+	uint8_t body[];
+}btNode_s;
+
+typedef struct btPath{
+	btNode_s* node;
+	unsigned  index;
+}btPath_s;
+
+struct btree{
+	btNode_s* root;
+	btNode_s* first;
+	btNode_s* free;
+	cmp_f cmp;
+	size_t count;
+	unsigned keysize;
+	unsigned nodesize;
+	unsigned lcap;
+	unsigned icap;
+	unsigned ldata;
+	unsigned ichild;
+	unsigned depth;
+	uint8_t* scratch;
+};
+
+struct btreeit{
+	btNode_s* leaf;
+	btree_t* t;
+	unsigned index;
+	unsigned count;
+	btreeEntry_s entry;
+};
+
+#define bt_key(T,N,I)   ((N)->body + (size_t)(I) * (T)->keysize)
+#define bt_data(T,N)    ((void**)((N)->body + (T)->ldata))
+#define bt_child(T,N)   ((btNode_s**)((N)->body + (T)->ichild))
+#define bt_lmin(T)      ((T)->lcap / 2)
+#define bt_imin(T)      ((T)->icap / 2)
+
+/*** nodes ***/
+
+__private void bt_slab(btree_t* t){
+	const unsigned n = BTREE_SLAB_SIZE / t->nodesize ? BTREE_SLAB_SIZE / t->nodesize : 1;
+	uint8_t* slab = mem_gift(MANY(uint8_t, (size_t)n * t->nodesize + CACHE_LINE_SIZE), t);
+	uint8_t* base = (uint8_t*)ROUND_UP(ADDR(slab), CACHE_LINE_SIZE);
+	for( unsigned i = 0; i < n; ++i ){
+		btNode_s* node = (btNode_s*)(base + (size_t)i * t->nodesize);
+		node->next = t->free;
+		t->free = node;
+	}
+}
+
+__private btNode_s* bt_node_new(btree_t* t, int leaf){
+	if( !t->free ) bt_slab(t);
+	btNode_s* node = t->free;
+	t->free  = node->next;
+	node->count = 0;
+	node->leaf  = leaf;
+	node->next  = node->prev = NULL;
+	return node;
+}
+
+__private void bt_node_free(btree_t* t, btNode_s* node){
+	node->next = t->free;
+	t->free = node;
+}
+
+/*** search ***/
+
+//first index with key >= key
+__private unsigned bt_lower(btree_t* t, btNode_s* n, const void* key, int* eq){
+	unsigned lo = 0;
+	unsigned hi = n->count;
+	*eq = 0;
+	while( lo < hi ){
+		const unsigned mid = (lo + hi) / 2;
+		const int c = t->cmp(bt_key(t, n, mid), key);
+		if( c < 0 ){
+			lo = mid + 1;
+		}
+		else{
+			if( !c ) *eq = 1;
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+//first index with key > key, is child to descend
+__private unsigned bt_upper(btree_t* t, btNode_s* n, const void* key){
+	unsigned lo = 0;
+	unsigned hi = n->count;
+	while( lo < hi ){
+		const unsigned mid = (lo + hi) / 2;
+		if( t->cmp(bt_key(t, n, mid), key) <= 0 ) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+__private btNode_s* bt_leaf(btree_t* t, const void* key, btPath_s* path, unsigned* depth){
+	btNode_s* n = t->root;
+	unsigned d = 0;
+	while( !n->leaf ){
+		const unsigned i = bt_upper(t, n, key);
+		if( path ){
+			path[d].node  = n;
+			path[d].index = i;
+		}
+		++d;
+		n = bt_child(t, n)[i];
+	}
+	if( depth ) *depth = d;
+	return n;
+}
+
+/*** insert ***/
+
+__private void bt_leaf_put(btree_t* t, btNode_s* n, unsigned i, const void* key, void* data){
+	const unsigned ks = t->keysize;
+	void** d = bt_data(t, n);
+	memmove(bt_key(t, n, i+1), bt_key(t, n, i), (size_t)(n->count - i) * ks);
+	memmove(&d[i+1], &d[i], (n->count - i) * sizeof(void*));
+	memcpy(bt_key(t, n, i), key, ks);
+	d[i] = data;
+	++n->count;
+}
+
+//key at i and child at i+1
+__private void bt_inner_put(btree_t* t, btNode_s* n, unsigned i, const void* key, btNode_s* child){
+	const unsigned ks = t->keysize;
+	btNode_s** c = bt_child(t, n);
+	memmove(bt_key(t, n, i+1), bt_key(t, n, i), (size_t)(n->count - i) * ks);
+	memmove(&c[i+2], &c[i+1], (n->count - i) * sizeof(btNode_s*));
+	memcpy(bt_key(t, n, i), key, ks);
+	c[i+1] = child;
+	++n->count;
+}
+
+//split full leaf and insert, sep is first key of new right leaf
+__private btNode_s* bt_leaf_split(btree_t* t, btNode_s* n, unsigned i, const void* key, void* data, uint8_t* sep){
+	btNode_s* r = bt_node_new(t, 1);
+	const unsigned mid = n->count / 2;
+	const unsigned move = n->count - mid;
+	memcpy(bt_key(t, r, 0), bt_key(t, n, mid), (size_t)move * t->keysize);
+	memcpy(bt_data(t, r), &bt_data(t, n)[mid], move * sizeof(void*));
+	r->count = move;
+	n->count = mid;
+	r->next = n->next;
+	r->prev = n;
+	if( n->next ) n->next->prev = r;
+	n->next = r;
+	if( i <= mid ) bt_leaf_put(t, n, i, key, data);
+	else bt_leaf_put(t, r, i - mid, key, data);
+	memcpy(sep, bt_key(t, r, 0), t->keysize);
+	return r;
+}
+
+//split full inner and insert key/child, median key go up in sep
+__private btNode_s* bt_inner_split(btree_t* t, btNode_s* n, unsigned i, const void* key, btNode_s* child, uint8_t* sep){
+	btNode_s* r = bt_node_new(t, 0);
+	const unsigned mid = n->count / 2;
+	const unsigned move = n->count - mid - 1;
+	memcpy(sep, bt_key(t, n, mid), t->keysize);
+	memcpy(bt_key(t, r, 0), bt_key(t, n, mid+1), (size_t)move * t->keysize);
+	memcpy(bt_child(t, r), &bt_child(t, n)[mid+1], (move+1) * sizeof(btNode_s*));
+	r->count = move;
+	n->count = mid;
+	if( i <= mid ) bt_inner_put(t, n, i, key, child);
+	else bt_inner_put(t, r, i - mid - 1, key, child);
+	return r;
+}
+
+int btree_insert(btree_t* t, const void* key, void* data){
+	if( !t->root ){
+		t->root = t->first = bt_node_new(t, 1);
+		t->depth = 1;
+	}
+
+	btPath_s path[BTREE_DEPTH_MAX];
+	unsigned d;
+	btNode_s* n = bt_leaf(t, key, path, &d);
+	int eq;
+	unsigned i = bt_lower(t, n, key, &eq);
+	if( eq ){
+		errno = EEXIST;
+		return -1;
+	}
+	++t->count;
+	if( n->count < t->lcap ){
+		bt_leaf_put(t, n, i, key, data);
+		return 0;
+	}
+
+	//scratch has two keys, separator from child is inserted while median of split go in other
+	uint8_t* sep = t->scratch;
+	uint8_t* up  = t->scratch + t->keysize;
+	btNode_s* child = bt_leaf_split(t, n, i, key, data, sep);
+	while( d --> 0 ){
+		n = path[d].node;
+		i = path[d].index;
+		if( n->count < t->icap ){
+			bt_inner_put(t, n, i, sep, child);
+			return 0;
+		}
+		child = bt_inner_split(t, n, i, sep, child, up);
+		swap(sep, up);
+	}
+
+	btNode_s* root = bt_node_new(t, 0);
+	memcpy(bt_key(t, root, 0), sep, t->keysize);
+	bt_child(t, root)[0] = t->root;
+	bt_child(t, root)[1] = child;
+	root->count = 1;
+	t->root = root;
+	++t->depth;
+	iassert( t->depth < BTREE_DEPTH_MAX );
+	return 0;
+}
+
+/*** remove ***/
+
+__private void bt_leaf_del(btree_t* t, btNode_s* n, unsigned i){
+	void** d = bt_data(t, n);
+	--n->count;
+	memmove(bt_key(t, n, i), bt_key(t, n, i+1), (size_t)(n->count - i) * t->keysize);
+	memmove(&d[i], &d[i+1], (n->count - i) * sizeof(void*));
+}
+
+//remove key at i and child at i+1
+__private void bt_inner_del(btree_t* t, btNode_s* n, unsigned i){
+	btNode_s** c = bt_child(t, n);
+	--n->count;
+	memmove(bt_key(t, n, i), bt_key(t, n, i+1), (size_t)(n->count - i) * t->keysize);
+	memmove(&c[i+1], &c[i+2], (n->count - i) * sizeof(btNode_s*));
+}
+
+//append all elements of r in l and release r
+__private void bt_leaf_merge(btree_t* t, btNode_s* l, btNode_s* r){
+	memcpy(bt_key(t, l, l->count), bt_key(t, r, 0), (size_t)r->count * t->keysize);
+	memcpy(&bt_data(t, l)[l->count], bt_data(t, r), r->count * sizeof(void*));
+	l->count += r->count;
+	l->next = r->next;
+	if( r->next ) r->next->prev = l;
+	bt_node_free(t, r);
+}
+
+//separator of parent go down between keys of l and r
+__private void bt_inner_merge(btree_t* t, btNode_s* l, const void* sep, btNode_s* r){
+	memcpy(bt_key(t, l, l->count), sep, t->keysize);
+	memcpy(bt_key(t, l, l->count+1), bt_key(t, r, 0), (size_t)r->count * t->keysize);
+	memcpy(&bt_child(t, l)[l->count+1], bt_child(t, r), (r->count+1) * sizeof(btNode_s*));
+	l->count += r->count + 1;
+	bt_node_free(t, r);
+}
+
+//n is leaf child i of p with less than lmin keys, borrow from sibling or merge, return 1 if p need rebalance
+__private int bt_leaf_fix(btree_t* t, btNode_s* p, unsigned i, btNode_s* n){
+	btNode_s** c = bt_child(t, p);
+	btNode_s* ls = i > 0 ? c[i-1] : NULL;
+	btNode_s* rs = i < p->count ? c[i+1] : NULL;
+	if( ls && ls->count > bt_lmin(t) ){
+		--ls->count;
+		bt_leaf_put(t, n, 0, bt_key(t, ls, ls->count), bt_data(t, ls)[ls->count]);
+		memcpy(bt_key(t, p, i-1), bt_key(t, n, 0), t->keysize);
+		return 0;
+	}
+	if( rs && rs->count > bt_lmin(t) ){
+		bt_leaf_put(t, n, n->count, bt_key(t, rs, 0), bt_data(t, rs)[0]);
+		bt_leaf_del(t, rs, 0);
+		memcpy(bt_key(t, p, i), bt_key(t, rs, 0), t->keysize);
+		return 0;
+	}
+	if( ls ){
+		bt_leaf_merge(t, ls, n);
+		bt_inner_del(t, p, i-1);
+	}
+	else{
+		bt_leaf_merge(t, n, rs);
+		bt_inner_del(t, p, i);
+	}
+	return p->count < bt_imin(t);
+}
+
+//same of leaf but separator rotate through parent
+__private int bt_inner_fix(btree_t* t, btNode_s* p, unsigned i, btNode_s* n){
+	btNode_s** c = bt_child(t, p);
+	btNode_s* ls = i > 0 ? c[i-1] : NULL;
+	btNode_s* rs = i < p->count ? c[i+1] : NULL;
+	if( ls && ls->count > bt_imin(t) ){
+		btNode_s** nc = bt_child(t, n);
+		memmove(bt_key(t, n, 1), bt_key(t, n, 0), (size_t)n->count * t->keysize);
+		memmove(&nc[1], &nc[0], (n->count+1) * sizeof(btNode_s*));
+		memcpy(bt_key(t, n, 0), bt_key(t, p, i-1), t->keysize);
+		nc[0] = bt_child(t, ls)[ls->count];
+		++n->count;
+		--ls->count;
+		memcpy(bt_key(t, p, i-1), bt_key(t, ls, ls->count), t->keysize);
+		return 0;
+	}
+	if( rs && rs->count > bt_imin(t) ){
+		btNode_s** rc = bt_child(t, rs);
+		memcpy(bt_key(t, n, n->count), bt_key(t, p, i), t->keysize);
+		bt_child(t, n)[n->count+1] = rc[0];
+		++n->count;
+		memcpy(bt_key(t, p, i), bt_key(t, rs, 0), t->keysize);
+		--rs->count;
+		memmove(bt_key(t, rs, 0), bt_key(t, rs, 1), (size_t)rs->count * t->keysize);
+		memmove(&rc[0], &rc[1], (rs->count+1) * sizeof(btNode_s*));
+		return 0;
+	}
+	if( ls ){
+		bt_inner_merge(t, ls, bt_key(t, p, i-1), n);
+		bt_inner_del(t, p, i-1);
+	}
+	else{
+		bt_inner_merge(t, n, bt_key(t, p, i), rs);
+		bt_inner_del(t, p, i);
+	}
+	return p->count < bt_imin(t);
+}
+
+void* btree_remove(btree_t* t, const void* key){
+	if( !t->root ) return NULL;
+	btPath_s path[BTREE_DEPTH_MAX];
+	unsigned d;
+	btNode_s* n = bt_leaf(t, key, path, &d);
+	int eq;
+	unsigned i = bt_lower(t, n, key, &eq);
+	if( !eq ) return NULL;
+
+	void* data = bt_data(t, n)[i];
+	bt_leaf_del(t, n, i);
+	--t->count;
+
+	if( !d ){
+		if( !n->count ){
+			bt_node_free(t, n);
+			t->root = t->first = NULL;
+			t->depth = 0;
+		}
+		return data;
+	}
+	if( n->count >= bt_lmin(t) ) return data;
+
+	int fix = bt_leaf_fix(t, path[d-1].node, path[d-1].index, n);
+	while( fix && --d > 0 ){
+		fix = bt_inner_fix(t, path[d-1].node, path[d-1].index, path[d].node);
+	}
+
+	if( !t->root->count ){
+		btNode_s* old = t->root;
+		t->root = bt_child(t, old)[0];
+		bt_node_free(t, old);
+		--t->depth;
+	}
+	return data;
+}
+
+/*** find ***/
+
+void* btree_find(btree_t* t, const void* key){
+	if( !t->root ) return NULL;
+	btNode_s* n = bt_leaf(t, key, NULL, NULL);
+	int eq;
+	const unsigned i = bt_lower(t, n, key, &eq);
+	return eq ? bt_data(t, n)[i] : NULL;
+}
+
+__private btNode_s* bt_best(btree_t* t, const void* key, unsigned* index){
+	if( !t->root ) return NULL;
+	btNode_s* n = bt_leaf(t, key, NULL, NULL);
+	int eq;
+	unsigned i = bt_lower(t, n, key, &eq);
+	if( i == n->count ){
+		n = n->next;
+		i = 0;
+	}
+	*index = i;
+	return n;
+}
+
+void* btree_find_best(btree_t* t, const void* key, void* out){
+	unsigned i;
+	btNode_s* n = bt_best(t, key, &i);
+	if( !n ) return NULL;
+	if( out ) memcpy(out, bt_key(t, n, i), t->keysize);
+	return bt_data(t, n)[i];
+}
+
+/*** tree ***/
+
+btree_t* btree_new(unsigned keysize, unsigned nodesize, cmp_f fn){
+	iassert( keysize );
+	btree_t* t = NEW(btree_t);
+	if( !nodesize ) nodesize = BTREE_NODE_SIZE;
+	nodesize = ROUND_UP(nodesize, CACHE_LINE_SIZE);
+	const unsigned kd = ROUND_UP(keysize, sizeof(void*));
+	//node hold always 4 keys, otherwise split and merge can't work
+	while( (nodesize - sizeof(btNode_s)) / (kd + sizeof(void*)) < 4 ) nodesize += CACHE_LINE_SIZE;
+
+	const unsigned body = nodesize - sizeof(btNode_s);
+	t->lcap = body / (keysize + sizeof(void*));
+	while( ROUND_UP(t->lcap * keysize, sizeof(void*)) + t->lcap * sizeof(void*) > body ) --t->lcap;
+	t->icap = (body - sizeof(void*)) / (keysize + sizeof(void*));
+	while( ROUND_UP(t->icap * keysize, sizeof(void*)) + (t->icap+1) * sizeof(void*) > body ) --t->icap;
+	if( t->lcap > UINT16_MAX ) t->lcap = UINT16_MAX;
+	if( t->icap > UINT16_MAX - 1 ) t->icap = UINT16_MAX - 1;
+	t->ldata    = ROUND_UP(t->lcap * keysize, sizeof(void*));
+	t->ichild   = ROUND_UP(t->icap * keysize, sizeof(void*));
+	t->keysize  = keysize;
+	t->nodesize = nodesize;
+	t->cmp      = fn;
+	t->root     = NULL;
+	t->first    = NULL;
+	t->free     = NULL;
+	t->count    = 0;
+	t->depth    = 0;
+	t->scratch  = mem_gift(MANY(uint8_t, keysize * 2), t);
+	return t;
+}
+
+size_t btree_count(btree_t* t){
+	return t->count;
+}
+
+unsigned btree_depth(btree_t* t){
+	return t->depth;
+}
+
+/*** iterator ***/
+
+__private btree_i* bt_iterator(btree_t* t, btNode_s* leaf, unsigned index, unsigned count){
+	btree_i* it = NEW(btree_i);
+	it->t     = t;
+	it->leaf  = leaf;
+	it->index = index;
+	it->count = count ? count : UINT_MAX;
+	return it;
+}
+
+btree_i* btree_inorder_iterator(btree_t* t, unsigned offset, unsigned count){
+	btNode_s* n = t->first;
+	while( n && offset >= n->count ){
+		offset -= n->count;
+		n = n->next;
+	}
+	return bt_iterator(t, n, offset, count);
+}
+
+btree_i* btree_range_iterator(btree_t* t, const void* key, unsigned count){
+	unsigned i = 0;
+	btNode_s* n = bt_best(t, key, &i);
+	return bt_iterator(t, n, i, count);
+}
+
+void* btree_inorder_iterate(void* IT){
+	btree_i* it = IT;
+	if( !it->count || !it->leaf ) return NULL;
+	btree_t* t = it->t;
+	it->entry.key  = bt_key(t, it->leaf, it->index);
+	it->entry.data = bt_data(t, it->leaf)[it->index];
+	--it->count;
+	if( ++it->index >= it->leaf->count ){
+		it->leaf  = it->leaf->next;
+		it->index = 0;
+	}
+	return &it->entry;
+}
@@ -1,102 +1,367 @@
 #include <notstd/dict.h>
 #include <notstd/rbtree.h>
+#include <notstd/rbhash.h>
+#include <notstd/intern.h>
+
+//pair is embedded in node of tree, one allocation for each key
+typedef struct dictNode{
+	rbtLink_s link;
+	dictPair_s pair;
+}dictNode_s;
+
+/* DICT_HASH, pairs are inline in dense array in insertion order, index is open addressing with linear probe
+ * slot store entry+1 and low 32 bits of hash, home slot and grow never hash again the keys
+ * removed entry have key unset and is dropped when index is rebuilt
+ * string keys are copied and owned from dict as G_STRING, key added with dictk is G_LSTRING from intern() and is not copied,
+ * interned key compared with G_LSTRING key never need strcmp
+ */
+#define DICT_HASH_MIN  8
+#define DICT_SLOT_DEL  UINT32_MAX
+
+typedef struct dictSlot{
+	uint32_t entry;
+	uint32_t hash;
+}dictSlot_s;
+
+typedef struct dictHash{
+	dictPair_s* entry;
+	dictSlot_s* slot;
+	size_t mask;
+	size_t size;
+	size_t used;
+	size_t count;
+}dictHash_s;
 
 struct dict{
-	rbtree_t* itree;
-	rbtree_t* stree;
+	rbtRoot_s itree;
+	rbtRoot_s stree;
+	dictHash_s* hash;
 };
 
-__private int icmp(const void* a, const void* b){
-	const dictPair_s* ea = a;
-	const dictPair_s* eb = b;
-	return ea->key.l - eb->key.l;
+#define dict_strcmp(A, B) strcmp(*(A), *(B))
+
+RBTREE_DECLARE(ditree, dictNode_s, link, pair.key.l, RBTREE_CMP)
+RBTREE_DECLARE(dstree, dictNode_s, link, pair.key.lstr, dict_strcmp)
+
+__private int dict_strkey(const dictPair_s* p){
+	return p->key.type == G_STRING || p->key.type == G_LSTRING;
 }
 
-__private int scmp(const void* a, const void* b){
-	const dictPair_s* ea = a;
-	const dictPair_s* eb = b;
-	return strcmp(ea->key.lstr, eb->key.lstr);
+/*** hash ***/
+
+__private void dh_alloc(dictHash_s* h, size_t slots){
+	h->slot  = MANY(dictSlot_s, slots);
+	memset(h->slot, 0, sizeof(dictSlot_s) * slots);
+	h->mask  = slots - 1;
+	h->size  = slots - slots / 4;
+	h->entry = MANY(dictPair_s, h->size);
+	h->used  = 0;
 }
 
+__private dictSlot_s* dh_probe(dictHash_s* h, uint32_t hash, const dictPair_s* key, int interned, int* found){
+	dictSlot_s* ins = NULL;
+	const int str = dict_strkey(key);
+	for( size_t i = hash & h->mask;; i = (i + 1) & h->mask ){
+		dictSlot_s* s = &h->slot[i];
+		if( !s->entry ){
+			*found = 0;
+			return ins ? ins : s;
+		}
+		if( s->entry == DICT_SLOT_DEL ){
+			if( !ins ) ins = s;
+			continue;
+		}
+		if( s->hash != hash ) continue;
+		const dictPair_s* e = &h->entry[s->entry - 1];
+		const int eq = str ?
+			dict_strkey(e) && (e->key.lstr == key->key.lstr || (!(interned && e->key.type == G_LSTRING) && !strcmp(e->key.lstr, key->key.lstr))):
+			!dict_strkey(e) && e->key.l == key->key.l;
+		if( eq ){
+			*found = 1;
+			return s;
+		}
+	}
+}
 
-dict_t* dict_new(void){
+//index is rebuilt from old slots, entries are compacted and removed are dropped
+__private void dh_rebuild(dictHash_s* h, size_t slots){
+	dictPair_s* oentry = h->entry;
+	dictSlot_s* oslot = h->slot;
+	const size_t oslots = h->mask + 1;
+	const size_t oused = h->used;
+	__free uint32_t* remap = MANY(uint32_t, oused + 1);
+	dh_alloc(h, slots);
+	for( size_t i = 0; i < oused; ++i ){
+		if( oentry[i].key.type == G_UNSET ) continue;
+		h->entry[h->used] = oentry[i];
+		remap[i] = ++h->used;
+	}
+	for( size_t i = 0; i < oslots; ++i ){
+		if( !oslot[i].entry || oslot[i].entry == DICT_SLOT_DEL ) continue;
+		size_t j = oslot[i].hash & h->mask;
+		while( h->slot[j].entry ) j = (j + 1) & h->mask;
+		h->slot[j].entry = remap[oslot[i].entry - 1];
+		h->slot[j].hash  = oslot[i].hash;
+	}
+	mem_free(oentry);
+	mem_free(oslot);
+}
+
+//return pair of key, new pair is inserted with value unset and *add is set
+__private dictPair_s* dh_get(dictHash_s* h, uint32_t hash, const dictPair_s* key, int interned, int* add){
+	int found;
+	dictSlot_s* s = dh_probe(h, hash, key, interned, &found);
+	if( found ){
+		*add = 0;
+		return &h->entry[s->entry - 1];
+	}
+	if( h->used == h->size ){
+		dh_rebuild(h, h->count < h->size / 2 ? h->mask + 1 : (h->mask + 1) * 2);
+		s = dh_probe(h, hash, key, interned, &found);
+	}
+	dictPair_s* e = &h->entry[h->used++];
+	*e = *key;
+	s->entry = h->used;
+	s->hash  = hash;
+	++h->count;
+	*add = 1;
+	return e;
+}
+
+__private int dh_remove(dictHash_s* h, uint32_t hash, const dictPair_s* key, int interned){
+	int found;
+	dictSlot_s* s = dh_probe(h, hash, key, interned, &found);
+	if( !found ){
+		errno = ESRCH;
+		return -1;
+	}
+	dictPair_s* e = &h->entry[s->entry - 1];
+	if( e->key.type == G_STRING ) mem_free(e->key.str);
+	e->key   = gi_unset();
+	e->value = gi_unset();
+	s->entry = DICT_SLOT_DEL;
+	--h->count;
+	return 0;
+}
+
+__private uint32_t dh_hashi(long key){
+	return hash64_splitmix(&key, sizeof key);
+}
+
+//keys can come from untrusted input, seeded hash avoid flooding, is same hash of intern pool
+__private uint32_t dh_hashs(const char* key, size_t len){
+	return hash_seeded(key, len);
+}
+
+//string keys are owned from dict, released on remove
+__private void dh_own(dictPair_s* e, size_t len){
+	char* k = MANY(char, len + 1);
+	memcpy(k, e->key.lstr, len + 1);
+	e->key = gi_str(k);
+}
+
+__private void dh_release(dictHash_s* h){
+	for( size_t i = 0; i < h->used; ++i ){
+		if( h->entry[i].key.type == G_STRING ) mem_free(h->entry[i].key.str);
+	}
+	mem_free(h->entry);
+	mem_free(h->slot);
+}
+
+//children are freed before cleanup, hash is not gifted to dict
+__private void dh_dtor(void* ctx){
+	dict_t* d = ctx;
+	dh_release(d->hash);
+	mem_free(d->hash);
+}
+
+//pairs in any order, index is sized one time, duplicate key leave dict empty
+__private int dh_load(dictHash_s* h, const dictPair_s* pairs, size_t n){
+	size_t slots = DICT_HASH_MIN;
+	while( slots - slots / 4 < n ) slots *= 2;
+	if( slots != h->mask + 1 ) dh_rebuild(h, slots);
+	for( size_t i = 0; i < n; ++i ){
+		int add;
+		const int str = dict_strkey(&pairs[i]);
+		const uint32_t hash = str ? dh_hashs(pairs[i].key.lstr, strlen(pairs[i].key.lstr)) : dh_hashi(pairs[i].key.l);
+		dictPair_s* e = dh_get(h, hash, &pairs[i], 0, &add);
+		if( !add ){
+			dh_release(h);
+			h->count = 0;
+			dh_alloc(h, DICT_HASH_MIN);
+			errno = EINVAL;
+			return -1;
+		}
+		if( str ) dh_own(e, strlen(e->key.lstr));
+	}
+	return 0;
+}
+
+/*** dict ***/
+
+dict_t* dict_new_mode(dictMode_e mode){
 	dict_t* d = NEW(dict_t);
-	d->itree = rbtree_new(icmp);
-	d->stree = rbtree_new(scmp);
+	d->itree = (rbtRoot_s){ NULL, 0, NULL };
+	d->stree = (rbtRoot_s){ NULL, 0, NULL };
+	d->hash  = NULL;
+	if( mode == DICT_HASH ){
+		d->hash = NEW(dictHash_s);
+		d->hash->count = 0;
+		dh_alloc(d->hash, DICT_HASH_MIN);
+		mem_cleanup(d, dh_dtor);
+	}
 	return d;
 }
 
+dict_t* dict_new(void){
+	return dict_new_mode(DICT_ORDERED);
+}
+
+dictMode_e dict_mode(dict_t* d){
+	return d->hash ? DICT_HASH : DICT_ORDERED;
+}
+
 generic_s* dicti(dict_t* d, long key){
-	dictPair_s e = { .key.type = G_LONG, .key.l = key };
-	rbtNode_t* node = rbtree_find(d->itree, &e);
+	if( d->hash ){
+		int add;
+		const dictPair_s p = { GI(key), gi_unset() };
+		return &dh_get(d->hash, dh_hashi(key), &p, 0, &add)->value;
+	}
+	dictNode_s* node = ditree_find(&d->itree, &key);
 	if( !node ){
-		dictPair_s* n = NEW(dictPair_s);
-		n->key = GI(key);
-		n->value = gi_unset();
-		rbtNode_t* node = rbtree_node_new(n);
-		mem_gift(n, node);
-		rbtree_insert(d->itree, mem_gift(node, d->itree));
-		return &n->value;
+		node = mem_gift(NEW(dictNode_s), d);
+		node->pair.key   = GI(key);
+		node->pair.value = gi_unset();
+		ditree_insert(&d->itree, node);
 	}
-	dictPair_s* f = rbtree_node_data(node);
-	return &f->value;
+	return &node->pair.value;
 }
 
 generic_s* dicts(dict_t* d, const char* key){
-	dictPair_s e = { .key.type = G_STRING, .key.lstr = key };
-	rbtNode_t* node = rbtree_find(d->stree, &e);
+	if( d->hash ){
+		int add;
+		const size_t len = strlen(key);
+		const dictPair_s p = { GI(key), gi_unset() };
+		dictPair_s* e = dh_get(d->hash, dh_hashs(key, len), &p, 0, &add);
+		if( add ) dh_own(e, len);
+		return &e->value;
+	}
+	dictNode_s* node = dstree_find(&d->stree, &key);
 	if( !node ){
-		dictPair_s* n = NEW(dictPair_s);
-		n->key = GI(key);
-		n->value = gi_unset();
-		rbtNode_t* node = rbtree_node_new(n);
-		mem_gift(n, node);
-		rbtree_insert(d->stree, mem_gift(node, d->stree));
-		return &n->value;
+		node = mem_gift(NEW(dictNode_s), d);
+		node->pair.key   = GI(key);
+		node->pair.value = gi_unset();
+		dstree_insert(&d->stree, node);
 	}
-	dictPair_s* f = rbtree_node_data(node);
-	return &f->value;
+	return &node->pair.value;
+}
+
+//interned key is never released and is stored without copy
+generic_s* dictk(dict_t* d, const char* ikey){
+	if( !d->hash ) return dicts(d, ikey);
+	int add;
+	const dictPair_s p = { GI(ikey), gi_unset() };
+	return &dh_get(d->hash, intern_hash(ikey), &p, 1, &add)->value;
+}
+
+int dictkrm(dict_t* d, const char* ikey){
+	if( !d->hash ) return dictsrm(d, ikey);
+	const dictPair_s p = { GI(ikey), gi_unset() };
+	return dh_remove(d->hash, intern_hash(ikey), &p, 1);
 }
 
 int dictirm(dict_t* d, long key){
-	dictPair_s e = { .key.type = G_LONG, .key.l = key };
-	rbtNode_t* node = rbtree_find(d->itree, &e);
+	if( d->hash ){
+		const dictPair_s p = { GI(key), gi_unset() };
+		return dh_remove(d->hash, dh_hashi(key), &p, 0);
+	}
+	dictNode_s* node = ditree_find(&d->itree, &key);
 	if( !node ){
 		errno = ESRCH;
 		return -1;
 	}
-	mem_free(mem_give(rbtree_remove(d->itree, node), d->itree));
+	ditree_remove(&d->itree, node);
+	mem_free(mem_give(node, d));
 	return 0;
 }
 
 int dictsrm(dict_t* d, const char* key){
-	dictPair_s e = { .key.type = G_LSTRING, .key.lstr = key };
-	rbtNode_t* node = rbtree_find(d->stree, &e);
+	if( d->hash ){
+		const dictPair_s p = { GI(key), gi_unset() };
+		return dh_remove(d->hash, dh_hashs(key, strlen(key)), &p, 0);
+	}
+	dictNode_s* node = dstree_find(&d->stree, &key);
 	if( !node ){
 		errno = ESRCH;
 		return -1;
 	}
-	mem_free(mem_give(rbtree_remove(d->stree, node), d->stree));
+	dstree_remove(&d->stree, node);
+	mem_free(mem_give(node, d));
+	return 0;
+}
+
+int dict_load(dict_t* d, const dictPair_s* pairs, size_t n){
+	if( dict_count(d) ){
+		errno = ENOTEMPTY;
+		return -1;
+	}
+	if( d->hash ) return dh_load(d->hash, pairs, n);
+	size_t ni = 0;
+	const dictPair_s* li = NULL;
+	const dictPair_s* ls = NULL;
+	for( size_t i = 0; i < n; ++i ){
+		if( dict_strkey(&pairs[i]) ){
+			if( ls && strcmp(ls->key.lstr, pairs[i].key.lstr) >= 0 ){
+				errno = EINVAL;
+				return -1;
+			}
+			ls = &pairs[i];
+		}
+		else{
+			if( li && li->key.l >= pairs[i].key.l ){
+				errno = EINVAL;
+				return -1;
+			}
+			li = &pairs[i];
+			++ni;
+		}
+	}
+
+	__free rbtLink_s** vi = MANY(rbtLink_s*, ni + 1);
+	__free rbtLink_s** vs = MANY(rbtLink_s*, n - ni + 1);
+	size_t ci = 0, cs = 0;
+	for( size_t i = 0; i < n; ++i ){
+		dictNode_s* node = mem_gift(NEW(dictNode_s), d);
+		node->pair = pairs[i];
+		if( dict_strkey(&pairs[i]) ) vs[cs++] = &node->link;
+		else vi[ci++] = &node->link;
+	}
+	rbtree_link_build(&d->itree, vi, ci);
+	rbtree_link_build(&d->stree, vs, cs);
 	return 0;
 }
 
 unsigned long dict_count(dict_t* dic){
-	return rbtree_count(dic->itree) + rbtree_count(dic->stree);
+	if( dic->hash ) return dic->hash->count;
+	return dic->itree.count + dic->stree.count;
 }
 
+//walk integer keys and after string keys with successor, no stack, DICT_HASH walk entries in insertion order
 struct dictit{
 	unsigned long count;
-	rbtree_i* it;
-	rbtree_i* iti;
-	rbtree_i* its;
+	dict_t* dic;
+	rbtLink_s* cur;
+	size_t index;
+	int str;
 };
 
 dict_i* dict_iterator(dict_t* dic, unsigned offset, unsigned count){
 	dict_i* it = NEW(dict_i);
 	if( count == 0 ) count = dict_count(dic);
-	it->iti = mem_gift(rbtree_inorder_iterator(dic->itree, 0, 0), it);
-	it->its = mem_gift(rbtree_inorder_iterator(dic->stree, 0, 0), it);
-	it->it = it->iti;
+	it->dic = dic;
+	it->index = 0;
+	it->str = 0;
+	it->cur = rbtree_link_first(&dic->itree);
 	it->count = dict_count(dic);
 	while( offset --> 0 ) dict_iterate(it);
 	it->count = count;
@@ -106,12 +371,20 @@ dict_i* dict_iterator(dict_t* dic, unsigned offset, unsigned count){
 void* dict_iterate(void* IT){
 	dict_i* it = IT;
 	if( !it->count ) return NULL;
-	rbtNode_t* n = rbtree_inorder_iterate(it->it);
-	if( !n ){
-		it->it = it->its;
-		n = rbtree_inorder_iterate(it->it);
+	dictHash_s* h = it->dic->hash;
+	if( h ){
+		while( it->index < h->used && h->entry[it->index].key.type == G_UNSET ) ++it->index;
+		if( it->index >= h->used ) return NULL;
+		--it->count;
+		return &h->entry[it->index++];
+	}
+	if( !it->cur && !it->str ){
+		it->str = 1;
+		it->cur = rbtree_link_first(&it->dic->stree);
 	}
-	return n ? rbtree_node_data(n) : NULL;
+	if( !it->cur ) return NULL;
+	dictNode_s* n = container_of(it->cur, dictNode_s, link);
+	it->cur = rbtree_link_next(it->cur);
+	--it->count;
+	return &n->pair;
 }
-
-
@@ -0,0 +1,92 @@
+#include <notstd/generics.h>
+
+//external definition of gbox inline functions, used when compiler not inline
+extern inline unsigned gbox_tag(gbox_t b);
+extern inline gbox_t gb_unset(void);
+extern inline gbox_t gb_char(char v);
+extern inline gbox_t gb_double(double v);
+extern inline gbox_t gb_float(float v);
+extern inline gbox_t gb_int64(int64_t v);
+extern inline gbox_t gb_int8(int8_t v);
+extern inline gbox_t gb_int16(int16_t v);
+extern inline gbox_t gb_int32(int32_t v);
+extern inline gbox_t gb_uint64(uint64_t v);
+extern inline gbox_t gb_uint8(uint8_t v);
+extern inline gbox_t gb_uint16(uint16_t v);
+extern inline gbox_t gb_uint32(uint32_t v);
+extern inline gbox_t gb_str(char* v);
+extern inline gbox_t gb_lstr(const char* v);
+extern inline gbox_t gb_obj(void* v);
+extern inline gbox_t gb_vec(generic_s* v);
+extern inline gtype_e gbox_type(gbox_t b);
+extern inline char gbox_c(gbox_t b);
+extern inline long gbox_l(gbox_t b);
+extern inline unsigned long gbox_ul(gbox_t b);
+extern inline double gbox_f(gbox_t b);
+extern inline void* gbox_ptr(gbox_t b);
+extern inline const char* gbox_lstr(const gbox_t* b);
+extern inline gbox_t gbox_from(generic_s g);
+extern inline generic_s gbox_generic(const gbox_t* b);
+
+/*** column ***/
+
+#define GCOLUMN_MIN 16
+
+//types and payloads are not gifted, are resized and released in cleanup
+struct gcolumn{
+	uint8_t* types;
+	uint64_t* payloads;
+	size_t count;
+	size_t max;
+};
+
+__private void gcolumn_dtor(void* ctx){
+	gcolumn_t* c = ctx;
+	mem_free(c->types);
+	mem_free(c->payloads);
+}
+
+gcolumn_t* gcolumn_new(size_t count){
+	if( count < GCOLUMN_MIN ) count = GCOLUMN_MIN;
+	gcolumn_t* c = NEW(gcolumn_t);
+	c->types    = MANY(uint8_t, count);
+	c->payloads = MANY(uint64_t, count);
+	c->count    = 0;
+	c->max      = count;
+	mem_cleanup(c, gcolumn_dtor);
+	return c;
+}
+
+size_t gcolumn_count(gcolumn_t* c){
+	return c->count;
+}
+
+void gcolumn_push(gcolumn_t* c, generic_s g){
+	if( c->count >= c->max ){
+		c->max *= 2;
+		c->types    = RESIZE(uint8_t, c->types, c->max);
+		c->payloads = RESIZE(uint64_t, c->payloads, c->max);
+	}
+	c->types[c->count]    = g.type;
+	c->payloads[c->count] = g.assign;
+	++c->count;
+}
+
+generic_s gcolumn_get(gcolumn_t* c, size_t index){
+	iassert( index < c->count );
+	return (generic_s){ .type = c->types[index], .assign = c->payloads[index] };
+}
+
+void gcolumn_set(gcolumn_t* c, size_t index, generic_s g){
+	iassert( index < c->count );
+	c->types[index]    = g.type;
+	c->payloads[index] = g.assign;
+}
+
+const uint8_t* gcolumn_types(gcolumn_t* c){
+	return c->types;
+}
+
+const uint64_t* gcolumn_payloads(gcolumn_t* c){
+	return c->payloads;
+}
@@ -1,4 +1,8 @@
 #include <notstd/core.h>
+#include <notstd/rbhash.h>
+#include <immintrin.h>
+#include <sys/random.h>
+#include <time.h>
 
 /*****************************/
 /*** Jenkins ONE AT A TIME ***/
@@ -276,4 +280,408 @@ uint64_t hash_murmur_oaat32(const void* key, const size_t len){
 	return h;
 }
 
+/*************************/
+/*** helper 8/16 bytes ***/
+/*************************/
 
+__private inline uint64_t h_r8(const uint8_t* p){
+	uint64_t v;
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+__private inline uint64_t h_r4(const uint8_t* p){
+	uint32_t v;
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+__private inline uint64_t h_rotl(uint64_t v, unsigned r){
+	return (v << r) | (v >> (64 - r));
+}
+
+__private inline void h_mum(uint64_t* a, uint64_t* b){
+	const unsigned __int128 r = (unsigned __int128)*a * *b;
+	*a = (uint64_t)r;
+	*b = (uint64_t)(r >> 64);
+}
+
+//128 bit product folded to 64
+__private inline uint64_t h_mix(uint64_t a, uint64_t b){
+	h_mum(&a, &b);
+	return a ^ b;
+}
+
+/**************/
+/*** wyhash ***/
+/**************/
+
+//wyhash final 4, 48 bytes for each round on 3 independent lanes
+__private const uint64_t WYSECRET[4] = { 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL };
+
+uint64_t hash_wyhash_seed(const void* key, size_t len, uint64_t seed){
+	const uint8_t* p = key;
+	const uint64_t* s = WYSECRET;
+	seed ^= h_mix(seed ^ s[0], s[1]);
+	uint64_t a, b;
+	if( len <= 16 ){
+		if( len >= 4 ){
+			a = (h_r4(p) << 32) | h_r4(p + ((len >> 3) << 2));
+			b = (h_r4(p + len - 4) << 32) | h_r4(p + len - 4 - ((len >> 3) << 2));
+		}
+		else if( len > 0 ){
+			a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+			b = 0;
+		}
+		else{
+			a = b = 0;
+		}
+	}
+	else{
+		size_t i = len;
+		if( i >= 48 ){
+			uint64_t see1 = seed;
+			uint64_t see2 = seed;
+			do{
+				seed = h_mix(h_r8(p) ^ s[1], h_r8(p + 8) ^ seed);
+				see1 = h_mix(h_r8(p + 16) ^ s[2], h_r8(p + 24) ^ see1);
+				see2 = h_mix(h_r8(p + 32) ^ s[3], h_r8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			}while( i >= 48 );
+			seed ^= see1 ^ see2;
+		}
+		while( i > 16 ){
+			seed = h_mix(h_r8(p) ^ s[1], h_r8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = h_r8(p + i - 16);
+		b = h_r8(p + i - 8);
+	}
+	a ^= s[1];
+	b ^= seed;
+	h_mum(&a, &b);
+	return h_mix(a ^ s[0] ^ len, b ^ s[1]);
+}
+
+uint64_t hash_wyhash(const void* key, size_t len){
+	return hash_wyhash_seed(key, len, 0);
+}
+
+/************/
+/*** xxh3 ***/
+/************/
+
+#define XXH_PRIME32_1 0x9E3779B1U
+#define XXH_PRIME32_2 0x85EBCA77U
+#define XXH_PRIME32_3 0xC2B2AE3DU
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+#define XXH_PRIME_MX1 0x165667919E3779F9ULL
+#define XXH_PRIME_MX2 0x9FB21C651E98DF25ULL
+#define XXH_SECRET_SIZE 192
+#define XXH_STRIPE 64
+#define XXH_STRIPE_BLOCK ((XXH_SECRET_SIZE - XXH_STRIPE) / 8)
+#define XXH_BLOCK (XXH_STRIPE * XXH_STRIPE_BLOCK)
+
+__private const uint8_t XXHSECRET[XXH_SECRET_SIZE] __aligneda(64) = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+__private inline uint64_t xxh64_avalanche(uint64_t h){
+	h ^= h >> 33;
+	h *= XXH_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH_PRIME64_3;
+	return h ^ (h >> 32);
+}
+
+__private inline uint64_t xxh3_avalanche(uint64_t h){
+	h ^= h >> 37;
+	h *= XXH_PRIME_MX1;
+	return h ^ (h >> 32);
+}
+
+__private inline uint64_t xxh3_mix16(const uint8_t* p, const uint8_t* sec, uint64_t seed){
+	return h_mix(h_r8(p) ^ (h_r8(sec) + seed), h_r8(p + 8) ^ (h_r8(sec + 8) - seed));
+}
+
+__private uint64_t xxh3_short(const uint8_t* p, size_t len, uint64_t seed){
+	const uint8_t* sec = XXHSECRET;
+	if( len > 8 ){
+		const uint64_t lo = h_r8(p) ^ ((h_r8(sec + 24) ^ h_r8(sec + 32)) + seed);
+		const uint64_t hi = h_r8(p + len - 8) ^ ((h_r8(sec + 40) ^ h_r8(sec + 48)) - seed);
+		return xxh3_avalanche(len + __builtin_bswap64(lo) + hi + h_mix(lo, hi));
+	}
+	if( len >= 4 ){
+		seed ^= (uint64_t)__builtin_bswap32((uint32_t)seed) << 32;
+		const uint64_t in = h_r4(p + len - 4) + (h_r4(p) << 32);
+		uint64_t h = in ^ ((h_r8(sec + 8) ^ h_r8(sec + 16)) - seed);
+		h ^= h_rotl(h, 49) ^ h_rotl(h, 24);
+		h *= XXH_PRIME_MX2;
+		h ^= (h >> 35) + len;
+		h *= XXH_PRIME_MX2;
+		return h ^ (h >> 28);
+	}
+	if( len ){
+		const uint32_t c = ((uint32_t)p[0] << 16) | ((uint32_t)p[len >> 1] << 24) | p[len - 1] | ((uint32_t)len << 8);
+		return xxh64_avalanche(c ^ ((h_r4(sec) ^ h_r4(sec + 4)) + seed));
+	}
+	return xxh64_avalanche(seed ^ h_r8(sec + 56) ^ h_r8(sec + 64));
+}
+
+__private uint64_t xxh3_medium(const uint8_t* p, size_t len, uint64_t seed){
+	const uint8_t* sec = XXHSECRET;
+	uint64_t acc = len * XXH_PRIME64_1;
+	if( len <= 128 ){
+		if( len > 32 ){
+			if( len > 64 ){
+				if( len > 96 ){
+					acc += xxh3_mix16(p + 48, sec + 96, seed);
+					acc += xxh3_mix16(p + len - 64, sec + 112, seed);
+				}
+				acc += xxh3_mix16(p + 32, sec + 64, seed);
+				acc += xxh3_mix16(p + len - 48, sec + 80, seed);
+			}
+			acc += xxh3_mix16(p + 16, sec + 32, seed);
+			acc += xxh3_mix16(p + len - 32, sec + 48, seed);
+		}
+		acc += xxh3_mix16(p, sec, seed);
+		acc += xxh3_mix16(p + len - 16, sec + 16, seed);
+		return xxh3_avalanche(acc);
+	}
+	for( size_t i = 0; i < 8; ++i ) acc += xxh3_mix16(p + 16 * i, sec + 16 * i, seed);
+	acc = xxh3_avalanche(acc);
+	const size_t rounds = len / 16;
+	for( size_t i = 8; i < rounds; ++i ) acc += xxh3_mix16(p + 16 * i, sec + 16 * (i - 8) + 3, seed);
+	acc += xxh3_mix16(p + len - 16, sec + 136 - 17, seed);
+	return xxh3_avalanche(acc);
+}
+
+__private void xxh3_accumulate_sse2(uint64_t* acc, const uint8_t* p, const uint8_t* sec, size_t stripes){
+	__m128i* xacc = (__m128i*)acc;
+	for( size_t n = 0; n < stripes; ++n ){
+		const uint8_t* in = p + n * XXH_STRIPE;
+		const uint8_t* key = sec + n * 8;
+		for( size_t i = 0; i < 4; ++i ){
+			const __m128i data = _mm_loadu_si128((const __m128i*)in + i);
+			const __m128i dkey = _mm_xor_si128(data, _mm_loadu_si128((const __m128i*)key + i));
+			const __m128i product = _mm_mul_epu32(dkey, _mm_shuffle_epi32(dkey, _MM_SHUFFLE(0, 3, 0, 1)));
+			const __m128i sum = _mm_add_epi64(xacc[i], _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2)));
+			xacc[i] = _mm_add_epi64(product, sum);
+		}
+	}
+}
+
+__private void xxh3_scramble_sse2(uint64_t* acc, const uint8_t* sec){
+	__m128i* xacc = (__m128i*)acc;
+	const __m128i prime = _mm_set1_epi32(XXH_PRIME32_1);
+	for( size_t i = 0; i < 4; ++i ){
+		const __m128i data = _mm_xor_si128(xacc[i], _mm_srli_epi64(xacc[i], 47));
+		const __m128i dkey = _mm_xor_si128(data, _mm_loadu_si128((const __m128i*)sec + i));
+		const __m128i lo = _mm_mul_epu32(dkey, prime);
+		const __m128i hi = _mm_mul_epu32(_mm_shuffle_epi32(dkey, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+		xacc[i] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+	}
+}
+
+__target("avx2") __private void xxh3_accumulate_avx2(uint64_t* acc, const uint8_t* p, const uint8_t* sec, size_t stripes){
+	__m256i* xacc = (__m256i*)acc;
+	for( size_t n = 0; n < stripes; ++n ){
+		const uint8_t* in = p + n * XXH_STRIPE;
+		const uint8_t* key = sec + n * 8;
+		for( size_t i = 0; i < 2; ++i ){
+			const __m256i data = _mm256_loadu_si256((const __m256i*)in + i);
+			const __m256i dkey = _mm256_xor_si256(data, _mm256_loadu_si256((const __m256i*)key + i));
+			const __m256i product = _mm256_mul_epu32(dkey, _mm256_shuffle_epi32(dkey, _MM_SHUFFLE(0, 3, 0, 1)));
+			const __m256i sum = _mm256_add_epi64(xacc[i], _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2)));
+			xacc[i] = _mm256_add_epi64(product, sum);
+		}
+	}
+}
+
+__target("avx2") __private void xxh3_scramble_avx2(uint64_t* acc, const uint8_t* sec){
+	__m256i* xacc = (__m256i*)acc;
+	const __m256i prime = _mm256_set1_epi32(XXH_PRIME32_1);
+	for( size_t i = 0; i < 2; ++i ){
+		const __m256i data = _mm256_xor_si256(xacc[i], _mm256_srli_epi64(xacc[i], 47));
+		const __m256i dkey = _mm256_xor_si256(data, _mm256_loadu_si256((const __m256i*)sec + i));
+		const __m256i lo = _mm256_mul_epu32(dkey, prime);
+		const __m256i hi = _mm256_mul_epu32(_mm256_shuffle_epi32(dkey, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+		xacc[i] = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+	}
+}
+
+//blocks of 16 stripes of 64 bytes, accumulators are scrambled after each block
+#define XXH3_LONG(ACCUMULATE, SCRAMBLE) do{\
+	const size_t blocks = (len - 1) / XXH_BLOCK;\
+	for( size_t b = 0; b < blocks; ++b ){\
+		ACCUMULATE(acc, p + b * XXH_BLOCK, sec, XXH_STRIPE_BLOCK);\
+		SCRAMBLE(acc, sec + XXH_SECRET_SIZE - XXH_STRIPE);\
+	}\
+	ACCUMULATE(acc, p + blocks * XXH_BLOCK, sec, ((len - 1) - blocks * XXH_BLOCK) / XXH_STRIPE);\
+	ACCUMULATE(acc, p + len - XXH_STRIPE, sec + XXH_SECRET_SIZE - XXH_STRIPE - 7, 1);\
+}while(0)
+
+__private void xxh3_long_sse2(uint64_t* acc, const uint8_t* p, size_t len, const uint8_t* sec){
+	XXH3_LONG(xxh3_accumulate_sse2, xxh3_scramble_sse2);
+}
+
+__target("avx2") __private void xxh3_long_avx2(uint64_t* acc, const uint8_t* p, size_t len, const uint8_t* sec){
+	XXH3_LONG(xxh3_accumulate_avx2, xxh3_scramble_avx2);
+}
+
+typedef void(*xxh3Long_f)(uint64_t* acc, const uint8_t* p, size_t len, const uint8_t* sec);
+
+__private xxh3Long_f xxh3_long_select(void){
+	__cpu_init();
+	return __builtin_cpu_supports("avx2") ? xxh3_long_avx2 : xxh3_long_sse2;
+}
+
+__private void xxh3_long(uint64_t* acc, const uint8_t* p, size_t len, const uint8_t* sec) __resolver(xxh3_long_select);
+
+__private uint64_t xxh3_hash_long(const uint8_t* p, size_t len, uint64_t seed){
+	uint64_t acc[8] __aligneda(32) = { XXH_PRIME32_3, XXH_PRIME64_1, XXH_PRIME64_2, XXH_PRIME64_3, XXH_PRIME64_4, XXH_PRIME32_2, XXH_PRIME64_5, XXH_PRIME32_1 };
+	const uint8_t* sec = XXHSECRET;
+	uint8_t custom[XXH_SECRET_SIZE] __aligneda(32);
+	if( seed ){
+		for( size_t i = 0; i < XXH_SECRET_SIZE; i += 16 ){
+			const uint64_t lo = h_r8(XXHSECRET + i) + seed;
+			const uint64_t hi = h_r8(XXHSECRET + i + 8) - seed;
+			memcpy(custom + i, &lo, sizeof lo);
+			memcpy(custom + i + 8, &hi, sizeof hi);
+		}
+		sec = custom;
+	}
+	xxh3_long(acc, p, len, sec);
+	uint64_t h = len * XXH_PRIME64_1;
+	for( size_t i = 0; i < 4; ++i ) h += h_mix(acc[2 * i] ^ h_r8(sec + 11 + 16 * i), acc[2 * i + 1] ^ h_r8(sec + 11 + 16 * i + 8));
+	return xxh3_avalanche(h);
+}
+
+uint64_t hash_xxh3_seed(const void* key, size_t len, uint64_t seed){
+	if( len <= 16 ) return xxh3_short(key, len, seed);
+	if( len <= 240 ) return xxh3_medium(key, len, seed);
+	return xxh3_hash_long(key, len, seed);
+}
+
+uint64_t hash_xxh3(const void* key, size_t len){
+	return hash_xxh3_seed(key, len, 0);
+}
+
+/**************/
+/*** crc32c ***/
+/**************/
+
+//castagnoli reflected polynomial
+#define CRC32C_POLY 0x82F63B78U
+
+__private uint32_t CRC32CTABLE[256];
+
+__ctor __private void crc32c_table_ctor(void){
+	for( uint32_t i = 0; i < 256; ++i ){
+		uint32_t c = i;
+		for( unsigned k = 0; k < 8; ++k ) c = c & 1 ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+		CRC32CTABLE[i] = c;
+	}
+}
+
+__private uint32_t crc32c_sw(uint32_t crc, const uint8_t* p, size_t len){
+	while( len-- ) crc = CRC32CTABLE[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+
+__target("sse4.2") __private uint32_t crc32c_sse42(uint32_t crc, const uint8_t* p, size_t len){
+	uint64_t c = crc;
+	for( ; len >= 8; len -= 8, p += 8 ) c = _mm_crc32_u64(c, h_r8(p));
+	crc = c;
+	while( len-- ) crc = _mm_crc32_u8(crc, *p++);
+	return crc;
+}
+
+typedef uint32_t(*crc32c_f)(uint32_t crc, const uint8_t* p, size_t len);
+
+__private crc32c_f crc32c_select(void){
+	__cpu_init();
+	return __builtin_cpu_supports("sse4.2") ? crc32c_sse42 : crc32c_sw;
+}
+
+__private uint32_t crc32c_update(uint32_t crc, const uint8_t* p, size_t len) __resolver(crc32c_select);
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t len){
+	return ~crc32c_update(~crc, data, len);
+}
+
+uint64_t hash_crc32c(const void* key, size_t len){
+	return crc32c(0, key, len);
+}
+
+/**************/
+/*** seeded ***/
+/**************/
+
+__private uint64_t HASHSEED;
+
+//getrandom can fail only on very old kernel or early boot, fallback is weak but still different for each process
+__ctor __private void hash_seed_ctor(void){
+	if( getrandom(&HASHSEED, sizeof HASHSEED, GRND_NONBLOCK) == sizeof HASHSEED ) return;
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	HASHSEED = h_mix(((uint64_t)ts.tv_sec << 32) ^ ts.tv_nsec ^ ADDR(&ts), (uint64_t)getpid() * XXH_PRIME64_1);
+}
+
+uint64_t hash_seed(void){
+	return HASHSEED;
+}
+
+uint64_t hash_seeded(const void* key, size_t len){
+	return hash_wyhash_seed(key, len, HASHSEED);
+}
+
+/**********/
+/*** id ***/
+/**********/
+
+//stable id stored in persistent table, only append new hash
+__private const rbhash_f HASHID[] = {
+	NULL,
+	hash_one_at_a_time,
+	hash_fasthash,
+	hash_kr,
+	hash_sedgewicks,
+	hash_sobel,
+	hash_weinberger,
+	hash_elf,
+	hash_sdbm,
+	hash_bernstein,
+	hash_knuth,
+	hash_partow,
+	hash64_splitmix,
+	hash_murmur_oaat64,
+	hash_murmur_oaat32,
+	hash_wyhash,
+	hash_xxh3,
+	hash_crc32c
+};
+
+unsigned hash_id(rbhash_f fn){
+	for( unsigned i = 1; i < sizeof_vector(HASHID); ++i ){
+		if( HASHID[i] == fn ) return i;
+	}
+	return 0;
+}
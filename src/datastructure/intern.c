@@ -0,0 +1,128 @@
+#include <notstd/intern.h>
+#include <notstd/rbhash.h>
+#include <notstd/threads.h>
+
+//header of each string in arena, str is terminated with 0
+typedef struct internStr{
+	uint64_t hash;
+	uint64_t len;
+	char str[];
+}internStr_s;
+
+//index is open addressing with linear probe on pointer to string, load is max 1/2
+struct intern{
+	const char** slot;
+	uint8_t* arena;
+	size_t avail;
+	size_t mask;
+	size_t count;
+};
+
+#define istr_header(S) container_of((char*)(S), internStr_s, str)
+
+/*** arena ***/
+
+__private internStr_s* intern_alloc(intern_t* pool, size_t len){
+	const size_t size = ROUND_UP(sizeof(internStr_s) + len + 1, sizeof(uint64_t));
+	if( size > INTERN_ARENA_SIZE / 4 ) return mem_gift(mem_alloc(size, 0, 0, NULL, 0, NULL), pool);
+	if( size > pool->avail ){
+		pool->arena = mem_gift(MANY(uint8_t, INTERN_ARENA_SIZE), pool);
+		pool->avail = INTERN_ARENA_SIZE;
+	}
+	internStr_s* is = (internStr_s*)pool->arena;
+	pool->arena += size;
+	pool->avail -= size;
+	return is;
+}
+
+/*** index ***/
+
+__private const char** intern_slot(intern_t* pool, uint64_t hash, const char* str, size_t len){
+	for( size_t i = hash & pool->mask;; i = (i + 1) & pool->mask ){
+		const char** s = &pool->slot[i];
+		if( !*s ) return s;
+		const internStr_s* is = istr_header(*s);
+		if( is->hash == hash && is->len == len && !memcmp(is->str, str, len) ) return s;
+	}
+}
+
+__private void intern_grow(intern_t* pool){
+	const size_t oslots = pool->mask + 1;
+	const char** old = pool->slot;
+	pool->mask  = oslots * 2 - 1;
+	pool->slot  = mem_gift(MANY(const char*, oslots * 2), pool);
+	memset(pool->slot, 0, sizeof(const char*) * oslots * 2);
+	for( size_t i = 0; i < oslots; ++i ){
+		if( !old[i] ) continue;
+		size_t j = istr_header(old[i])->hash & pool->mask;
+		while( pool->slot[j] ) j = (j + 1) & pool->mask;
+		pool->slot[j] = old[i];
+	}
+	mem_free(mem_give(old, pool));
+}
+
+/*** intern ***/
+
+intern_t* intern_new(void){
+	intern_t* pool = NEW(intern_t);
+	pool->slot  = mem_gift(MANY(const char*, INTERN_SLOTS_MIN), pool);
+	memset(pool->slot, 0, sizeof(const char*) * INTERN_SLOTS_MIN);
+	pool->mask  = INTERN_SLOTS_MIN - 1;
+	pool->arena = NULL;
+	pool->avail = 0;
+	pool->count = 0;
+	return pool;
+}
+
+const char* intern_add(intern_t* pool, const char* str, size_t len){
+	if( !len ) len = strlen(str);
+	const uint64_t hash = hash_seeded(str, len);
+	const char** s = intern_slot(pool, hash, str, len);
+	if( *s ) return *s;
+	if( (pool->count + 1) * 2 > pool->mask + 1 ){
+		intern_grow(pool);
+		s = intern_slot(pool, hash, str, len);
+	}
+	internStr_s* is = intern_alloc(pool, len);
+	is->hash = hash;
+	is->len  = len;
+	memcpy(is->str, str, len);
+	is->str[len] = 0;
+	++pool->count;
+	return *s = is->str;
+}
+
+const char* intern_find(intern_t* pool, const char* str, size_t len){
+	if( !len ) len = strlen(str);
+	return *intern_slot(pool, hash_seeded(str, len), str, len);
+}
+
+size_t intern_count(intern_t* pool){
+	return pool->count;
+}
+
+uint64_t intern_hash(const char* istr){
+	return istr_header(istr)->hash;
+}
+
+size_t intern_len(const char* istr){
+	return istr_header(istr)->len;
+}
+
+/*** global ***/
+
+__private glock_s INTERNLOCK;
+__private intern_t* INTERNPOOL;
+
+__ctor __private void intern_ctor(void){
+	mutex_ctor(&INTERNLOCK, 0);
+}
+
+const char* intern(const char* str, size_t len){
+	const char* ret = NULL;
+	mutex_guard(&INTERNLOCK){
+		if( !INTERNPOOL ) INTERNPOOL = intern_new();
+		ret = intern_add(INTERNPOOL, str, len);
+	}
+	return ret;
+}
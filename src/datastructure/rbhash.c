@@ -1,5 +1,16 @@
 #include "notstd/core/memory.h"
 #include <notstd/rbhash.h>
+#include <notstd/threads.h>
+#include <immintrin.h>
+#include <sys/mman.h>
+
+//slots probed for each simd compare, first RBHASH_GROUP slots of metadata are mirrored after the end of table
+#define RBHASH_GROUP 32
+//fingerprint of slot already moved in new table during incremental resize, is not empty but never match
+#define RBHASH_MOVED 0x01
+#define rbhash_fp_used(FP) ((FP) & 0x80)
+//distance stored in metadata and histogram is saturated to this value
+#define RBHASH_DIST_MAX (RBHASH_HIST - 1)
 
 typedef struct rbhElement{
 	void* data;        /**< user data*/
@@ -9,14 +20,25 @@ typedef struct rbhElement{
 	char key[];        /**< flexible key*/
 }rbhElement_s;
 
+typedef struct rbhTable{
+	rbhElement_s* el;         /**< elements, one more slot is used for swap*/
+	uint8_t* fp;              /**< fingerprint for each slot, is also the allocation of dist*/
+	uint8_t* dist;            /**< distance for each slot, saturated to RBHASH_DIST_MAX*/
+	size_t size;              /**< total bucket of table*/
+	size_t count;             /**< elements in table*/
+	size_t maxdistance;       /**< max distance from hash*/
+	size_t hist[RBHASH_HIST]; /**< numbers of elements for each distance*/
+}rbhTable_s;
+
 typedef struct rbhash{
-	rbhElement_s* table; /**< hash table*/
-	size_t size;            /**< total bucket of table*/
+	rbhTable_s tbl;         /**< hash table, new elements are added here*/
+	rbhTable_s old;         /**< previous table during incremental resize, old.el is NULL when not resizing*/
+	size_t migrate;         /**< next bucket of old to move*/
+	size_t step;            /**< buckets moved for each operation, 0 resize all at once*/
 	size_t elementSize;     /**< sizeof rbhashElement*/
-	size_t count;           /**< bucket used*/
+	size_t count;           /**< elements in both tables*/
 	size_t pmin;            /**< percentage elements of free bucket*/
 	size_t min;             /**< min elements of free bucket*/
-	size_t maxdistance;     /**< max distance from hash*/
 	size_t keySize;         /**< key size*/
 	rbhash_f hashing;       /**< function calcolate hash*/
 }rbhash_t;
@@ -25,71 +47,154 @@ typedef struct rbhash{
 #define rbhash_slot_next(SLOT, SIZE) (rbhash_slot((SLOT)+1,SIZE))
 #define rbhash_element_slot(TABLE, ESZ, SLOT) ((rbhElement_s*)(ADDR(TABLE) + ((ESZ) * (SLOT))))
 #define rbhash_element_next(TABLE, ESZ) ((rbhElement_s*)(ADDR(TABLE) + (ESZ)))
-#define rbhash_minel(RBH) (((RBH)->size * (RBH)->pmin)/100)
+#define rbhash_minel(RBH) (((RBH)->tbl.size * (RBH)->pmin)/100)
+#define rbhash_dist_sat(D) ((D) > RBHASH_DIST_MAX ? RBHASH_DIST_MAX : (D))
+
+//alloc table and metadata, all slot are empty, empty is read only from metadata then elements are not initialized
+__private void rbhash_table_ctor(rbhTable_s* t, size_t size, size_t esize){
+	t->size = size;
+	t->count = 0;
+	t->maxdistance = 0;
+	memset(t->hist, 0, sizeof t->hist);
+	t->el = mem_alloc(esize * (size+1), 0, 0, NULL, 0, NULL);
+	t->fp = MANY(uint8_t, (size + RBHASH_GROUP) * 2);
+	memset(t->fp, 0, (size + RBHASH_GROUP) * 2);
+	t->dist = t->fp + size + RBHASH_GROUP;
+}
+
+__private void rbhash_table_release(rbhash_t* rbh, rbhTable_s* t){
+	mem_free(mem_give(t->el, rbh));
+	mem_free(mem_give(t->fp, rbh));
+	t->el = NULL;
+	t->fp = t->dist = NULL;
+	t->size = t->count = t->maxdistance = 0;
+	memset(t->hist, 0, sizeof t->hist);
+}
+
+__private inline void rbhash_meta_put(rbhTable_s* t, size_t slot, uint8_t f, uint8_t d){
+	t->fp[slot] = f;
+	t->dist[slot] = d;
+	if( slot < RBHASH_GROUP ){
+		t->fp[t->size + slot] = f;
+		t->dist[t->size + slot] = d;
+	}
+}
+
+//el NULL for empty slot
+__private inline void rbhash_meta_set(rbhTable_s* t, size_t slot, const rbhElement_s* el){
+	if( el ) rbhash_meta_put(t, slot, RBHASH_FP(el->hash), rbhash_dist_sat(el->distance));
+	else rbhash_meta_put(t, slot, 0, 0);
+}
+
+__private inline void rbhash_hist_add(rbhTable_s* t, size_t distance){
+	++t->hist[rbhash_dist_sat(distance)];
+	if( distance > t->maxdistance ) t->maxdistance = distance;
+}
+
+//maxdistance decrease when last element with max distance is removed, over RBHASH_DIST_MAX is never decreased until last saturated is removed
+__private inline void rbhash_hist_del(rbhTable_s* t, size_t distance){
+	iassert( t->hist[rbhash_dist_sat(distance)] );
+	--t->hist[rbhash_dist_sat(distance)];
+	while( t->maxdistance && !t->hist[rbhash_dist_sat(t->maxdistance)] ){
+		t->maxdistance = t->maxdistance > RBHASH_DIST_MAX ? RBHASH_DIST_MAX - 1 : t->maxdistance - 1;
+	}
+}
 
 rbhash_t* rbhash_new(size_t size, size_t min, size_t keysize, rbhash_f hashing){
 	rbhash_t* rbh = NEW(rbhash_t);
-	rbh->size = ROUND_UP_POW_TWO32(size);
 	rbh->pmin = min;
-	rbh->min  = rbh->size - rbhash_minel(rbh);
 	rbh->hashing = hashing;
 	rbh->count = 0;
-	rbh->maxdistance = 0;
 	rbh->keySize = keysize;
+	rbh->step = RBHASH_MIGRATE;
+	rbh->migrate = 0;
 	rbh->elementSize = ROUND_UP(sizeof(rbhElement_s), sizeof(void*));
 	rbh->elementSize = ROUND_UP(rbh->elementSize + keysize, sizeof(void*));
 	iassert((rbh->elementSize % sizeof(void*)) == 0);
-	rbh->table = mem_gift(mem_alloc(rbh->elementSize * (rbh->size+1), 0, 0, NULL, 0, NULL), rbh);
-
-	rbhElement_s* table = rbh->table;
-	for( size_t i = 0; i < rbh->size; ++i, table = rbhash_element_next(table, rbh->elementSize)){
-		table->len = 0;
-	}
+	//simd load never wrap more than one time
+	rbhash_table_ctor(&rbh->tbl, ROUND_UP_POW_TWO32(size < RBHASH_GROUP ? RBHASH_GROUP : size), rbh->elementSize);
+	mem_gift(rbh->tbl.el, rbh);
+	mem_gift(rbh->tbl.fp, rbh);
+	memset(&rbh->old, 0, sizeof rbh->old);
+	rbh->min  = rbh->tbl.size - rbhash_minel(rbh);
 	return rbh;
 }
 
-__private void rbhash_swapdown(rbhElement_s* table, const size_t size, const size_t esize, size_t* maxdistance, rbhElement_s* nw){
-	uint64_t bucket = rbhash_slot(nw->hash, size);
-	rbhElement_s* tbl = rbhash_element_slot(table, esize, bucket);
+__private void rbhash_swapdown(rbhTable_s* t, const size_t esize, rbhElement_s* nw){
+	uint64_t bucket = rbhash_slot(nw->hash, t->size);
+	rbhElement_s* tbl = rbhash_element_slot(t->el, esize, bucket);
 	size_t i = 0;
-	while( i < size && tbl->len != 0 ){
+	while( i < t->size && t->fp[bucket] ){
 		if(  nw->distance > tbl->distance ){
 			//dbg_info("swap %.*s(%p) -> %.*s(%p)", tbl->len, tbl->key, tbl->data, nw->len, nw->key, nw->data);
+			rbhash_hist_add(t, nw->distance);
+			rbhash_hist_del(t, tbl->distance);
 			memswap(tbl, sizeof(rbhElement_s) + tbl->len, nw, sizeof(rbhElement_s) + nw->len);
+			rbhash_meta_set(t, bucket, tbl);
 			//dbg_info("ok   %.*s(%p) <> %.*s(%p)", tbl->len, tbl->key, tbl->data, nw->len, nw->key, nw->data);
 		}
 		++nw->distance;
-		bucket = rbhash_slot_next(bucket, size);
-		tbl = rbhash_element_slot(table, esize, bucket);
+		bucket = rbhash_slot_next(bucket, t->size);
+		tbl = rbhash_element_slot(t->el, esize, bucket);
 		++i;
-		if( nw->distance > *maxdistance ) *maxdistance = nw->distance;
 	}
-	if( tbl->len != 0 ) die("hash lose element, the hash table is to small");
+	if( t->fp[bucket] ) die("hash lose element, the hash table is to small");
 	memcpy(tbl, nw, sizeof(rbhElement_s) + nw->len);
+	rbhash_hist_add(t, tbl->distance);
+	rbhash_meta_set(t, bucket, tbl);
+	++t->count;
+}
+
+/* move up to n buckets from old table to current, old table is released when all buckets are moved
+ * moved slot keep distance and remain occupied, old table preserve robin hood invariant for find and remove
+ */
+__private void rbhash_migrate(rbhash_t* rbh, size_t n){
+	rbhTable_s* o = &rbh->old;
+	if( !o->el ) return;
+	const size_t end = n >= o->size - rbh->migrate ? o->size : rbh->migrate + n;
+	rbhElement_s* scratch = rbhash_element_slot(rbh->tbl.el, rbh->elementSize, rbh->tbl.size);
+	for( ; rbh->migrate < end && o->count; ++rbh->migrate ){
+		const size_t slot = rbh->migrate;
+		if( !rbhash_fp_used(o->fp[slot]) ) continue;
+		rbhElement_s* el = rbhash_element_slot(o->el, rbh->elementSize, slot);
+		memcpy(scratch, el, sizeof(rbhElement_s) + el->len);
+		scratch->distance = 0;
+		rbhash_swapdown(&rbh->tbl, rbh->elementSize, scratch);
+		rbhash_hist_del(o, el->distance);
+		rbhash_meta_put(o, slot, RBHASH_MOVED, o->dist[slot]);
+		--o->count;
+	}
+	if( !o->count ) rbhash_table_release(rbh, o);
+}
+
+//start resize to newsize, previous resize is completed before
+__private void rbhash_grow(rbhash_t* rbh, size_t newsize, size_t step){
+	rbhash_migrate(rbh, SIZE_MAX);
+	iassert( !rbh->old.el );
+	rbh->old = rbh->tbl;
+	rbhash_table_ctor(&rbh->tbl, newsize, rbh->elementSize);
+	mem_gift(rbh->tbl.el, rbh);
+	mem_gift(rbh->tbl.fp, rbh);
+	rbh->migrate = 0;
+	rbh->min  = rbh->tbl.size - rbhash_minel(rbh);
+	rbhash_migrate(rbh, step);
 }
 
 __private void rbhash_upsize(rbhash_t* rbh){
 	if( rbh->count < rbh->min ) return;
-	size_t newsize = rbh->size * 2 + rbhash_minel(rbh);
-	newsize = ROUND_UP_POW_TWO32(newsize);
+	rbhash_grow(rbh, ROUND_UP_POW_TWO32(rbh->tbl.size * 2 + rbhash_minel(rbh)), rbh->step ? rbh->step : SIZE_MAX);
+}
 
-	rbhElement_s* newtable = mem_alloc(rbh->elementSize * (newsize+1), 0, 0, NULL, 0, NULL);
-	rbhElement_s* table = newtable;
-	for( size_t i = 0; i < newsize; ++i, table = rbhash_element_next(table,rbh->elementSize)){
-		table->len = 0;
-	}
+void rbhash_reserve(rbhash_t* rbh, size_t count){
+	size_t size = rbh->tbl.size;
+	while( count >= size - (size * rbh->pmin) / 100 ) size *= 2;
+	if( size > rbh->tbl.size ) rbhash_grow(rbh, size, SIZE_MAX);
+	else rbhash_migrate(rbh, SIZE_MAX);
+}
 
-	rbh->maxdistance = 0;
-	table = rbh->table;
-	for(size_t i = 0; i < rbh->size; ++i, table = rbhash_element_next(table,rbh->elementSize)){
-		if( table->len == 0 ) continue;
-		table->distance = 0;
-		rbhash_swapdown(newtable, newsize, rbh->elementSize, &rbh->maxdistance, table);
-	}
-	mem_free(mem_give(rbh->table, rbh));
-	rbh->table = mem_gift(newtable, rbh);
-	rbh->size = newsize;
-	rbh->min  = rbh->size - rbhash_minel(rbh);
+void rbhash_resize_step(rbhash_t* rbh, size_t step){
+	rbh->step = step;
+	if( !step ) rbhash_migrate(rbh, SIZE_MAX);
 }
 
 int rbhash_addh(rbhash_t* rbh, uint64_t hash, const void* key, size_t len, void* data){
@@ -97,13 +202,14 @@ int rbhash_addh(rbhash_t* rbh, uint64_t hash, const void* key, size_t len, void*
 		errno = EFBIG;
 		return -1;
 	}
-	rbhElement_s* el = rbhash_element_slot(rbh->table, rbh->elementSize, rbh->size);
+	rbhash_migrate(rbh, rbh->step);
+	rbhElement_s* el = rbhash_element_slot(rbh->tbl.el, rbh->elementSize, rbh->tbl.size);
 	el->data = data;
 	el->distance = 0;
 	el->hash = hash;
 	el->len = len;
 	memcpy(el->key, key, len);
-	rbhash_swapdown(rbh->table, rbh->size, rbh->elementSize, &rbh->maxdistance, el);
+	rbhash_swapdown(&rbh->tbl, rbh->elementSize, el);
 	++rbh->count;
 	rbhash_upsize(rbh);
 	return 0;
@@ -118,45 +224,103 @@ int rbhash_addu(rbhash_t* rbh, const void* key, size_t len, void* data){
 	return rbhash_add(rbh, key, len, data);
 }
 
-__private long rbhash_find_bucket(rbhash_t* rbh, uint64_t hash, const void* key, size_t len, unsigned* prevscan){
-	uint64_t slot = rbhash_slot(hash, rbh->size);
-	size_t maxscan;
-	if( prevscan ){
-		if( *prevscan >= rbh->maxdistance + 1 ){
-			errno = ESRCH;
-			return -1; 
+/* probe maxscan slots from slot, only slots with same fingerprint and distance touch the element
+ * scan stop on empty slot or when element is nearest to own home than key, robin hood invariant
+ * @param base distance of slot from home of hash
+ * @return index of scan where key is find, -1 not find
+ */
+__private long rbhash_probe_sse2(const rbhTable_s* t, size_t esize, uint64_t hash, const void* key, size_t len, uint64_t slot, size_t base, size_t maxscan){
+	const __m128i fp = _mm_set1_epi8(RBHASH_FP(hash));
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lane = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	for( size_t iscan = 0; iscan < maxscan; iscan += 16 ){
+		const uint64_t s = rbhash_slot(slot + iscan, t->size);
+		const __m128i vfp = _mm_loadu_si128((const __m128i*)&t->fp[s]);
+		const __m128i vdist = _mm_loadu_si128((const __m128i*)&t->dist[s]);
+		const __m128i expect = _mm_adds_epu8(_mm_set1_epi8(rbhash_dist_sat(base + iscan)), lane);
+		unsigned m = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(vfp, fp), _mm_cmpeq_epi8(vdist, expect)));
+		//empty or distance < expected
+		const unsigned stop = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(vfp, zero), _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(expect, vdist), zero), _mm_set1_epi8(-1))));
+		if( stop ) m &= (stop & -stop) - 1;
+		if( maxscan - iscan < 16 ) m &= (1U << (maxscan - iscan)) - 1;
+		while( m ){
+			const unsigned i = __builtin_ctz(m);
+			const rbhElement_s* el = rbhash_element_slot(t->el, esize, rbhash_slot(s + i, t->size));
+			if( el->hash == hash && el->len == len && !memcmp(key, el->key, len) ) return iscan + i;
+			m &= m - 1;
 		}
-		slot = rbhash_slot(slot+*prevscan, rbh->size);
-		maxscan = (rbh->maxdistance + 1) - *prevscan;
-	}
-	else{
-		maxscan = rbh->maxdistance + 1;
+		if( stop ) return -1;
 	}
+	return -1;
+}
 
-	rbhElement_s* table = rbhash_element_slot(rbh->table, rbh->elementSize, slot);
-	for( unsigned iscan = 0; iscan < maxscan; ++iscan ){
-		//dbg_info("slot:%lu", slot);
-		if( table->len == len && table->hash == hash && !memcmp(key, table->key, len) ){
-			if( prevscan ) *prevscan += iscan;
-			//dbg_info("onslot:%lu %.*s == %.*s", slot, (int)len, (char*)key, (int)len, (char*)table->key);
-			return slot;
+__target("avx2") __private long rbhash_probe_avx2(const rbhTable_s* t, size_t esize, uint64_t hash, const void* key, size_t len, uint64_t slot, size_t base, size_t maxscan){
+	const __m256i fp = _mm256_set1_epi8(RBHASH_FP(hash));
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i lane = _mm256_setr_epi8(
+		 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
+		16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31
+	);
+	for( size_t iscan = 0; iscan < maxscan; iscan += 32 ){
+		const uint64_t s = rbhash_slot(slot + iscan, t->size);
+		const __m256i vfp = _mm256_loadu_si256((const __m256i*)&t->fp[s]);
+		const __m256i vdist = _mm256_loadu_si256((const __m256i*)&t->dist[s]);
+		const __m256i expect = _mm256_adds_epu8(_mm256_set1_epi8(rbhash_dist_sat(base + iscan)), lane);
+		uint32_t m = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(vfp, fp), _mm256_cmpeq_epi8(vdist, expect)));
+		const uint32_t stop = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(vfp, zero), _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_subs_epu8(expect, vdist), zero), _mm256_set1_epi8(-1))));
+		if( stop ) m &= (stop & -stop) - 1;
+		if( maxscan - iscan < 32 ) m &= (1U << (maxscan - iscan)) - 1;
+		while( m ){
+			const unsigned i = __builtin_ctz(m);
+			const rbhElement_s* el = rbhash_element_slot(t->el, esize, rbhash_slot(s + i, t->size));
+			if( el->hash == hash && el->len == len && !memcmp(key, el->key, len) ) return iscan + i;
+			m &= m - 1;
 		}
-		slot = rbhash_slot_next(slot, rbh->size);
-		table = rbhash_element_slot(rbh->table, rbh->elementSize, slot);
+		if( stop ) return -1;
 	}
-	dbg_error("ESRCH");
-	errno = ESRCH;
 	return -1;
 }
 
-__private rbhElement_s* rbhash_find_hash_raw(rbhash_t* rbh, uint64_t hash, const void* key, size_t len){
-	long bucket;
-	if( (bucket = rbhash_find_bucket(rbh, hash, key, len, NULL)) == -1 ) return NULL;
-	return rbhash_element_slot(rbh->table, rbh->elementSize, bucket);
+typedef long(*rbhProbe_f)(const rbhTable_s* t, size_t esize, uint64_t hash, const void* key, size_t len, uint64_t slot, size_t base, size_t maxscan);
+
+__private rbhProbe_f rbhash_probe_select(void){
+	__cpu_init();
+	return __builtin_cpu_supports("avx2") ? rbhash_probe_avx2 : rbhash_probe_sse2;
+}
+
+__private long rbhash_probe(const rbhTable_s* t, size_t esize, uint64_t hash, const void* key, size_t len, uint64_t slot, size_t base, size_t maxscan) __resolver(rbhash_probe_select);
+
+//find slot of key in table, prevscan is distance where start scan and return distance of key
+__private long rbhash_table_find(const rbhTable_s* t, size_t esize, uint64_t hash, const void* key, size_t len, unsigned* prevscan){
+	const size_t base = prevscan ? *prevscan : 0;
+	if( base >= t->maxdistance + 1 ) return -1; 
+	const uint64_t slot = rbhash_slot(hash + base, t->size);
+	const long iscan = rbhash_probe(t, esize, hash, key, len, slot, base, (t->maxdistance + 1) - base);
+	if( iscan == -1 ) return -1;
+	if( prevscan ) *prevscan += iscan;
+	return rbhash_slot(slot + iscan, t->size);
+}
+
+//find element in current table and after in the table in resizing
+__private rbhElement_s* rbhash_lookup(rbhash_t* rbh, uint64_t hash, const void* key, size_t len, rbhTable_s** owner, long* slot){
+	rbhash_migrate(rbh, rbh->step);
+	rbhTable_s* t = &rbh->tbl;
+	long s = rbhash_table_find(t, rbh->elementSize, hash, key, len, NULL);
+	if( s == -1 && rbh->old.el ){
+		t = &rbh->old;
+		s = rbhash_table_find(t, rbh->elementSize, hash, key, len, NULL);
+	}
+	if( s == -1 ){
+		errno = ESRCH;
+		return NULL;
+	}
+	if( owner ) *owner = t;
+	if( slot ) *slot = s;
+	return rbhash_element_slot(t->el, rbh->elementSize, s);
 }
 
 void* rbhash_findh(rbhash_t* rbh, uint64_t hash, const void* key, size_t len){
-	rbhElement_s* el = rbhash_find_hash_raw(rbh, hash, key, len);
+	rbhElement_s* el = rbhash_lookup(rbh, hash, key, len, NULL, NULL);
 	return el ? el->data : NULL;
 }
 
@@ -164,38 +328,96 @@ void* rbhash_find(rbhash_t* rbh, const void* key, size_t len){
 	return rbhash_findh(rbh, rbh->hashing(key, len), key, len);
 }
 
-void* rbhash_findnx(rbhash_t* rbh, uint64_t hash, const void* key, size_t len, unsigned* scan){
-	long bucket;
-	if( (bucket = rbhash_find_bucket(rbh, hash, key, len, scan)) == -1 ) return NULL;
-	return rbhash_element_slot(rbh->table, rbh->elementSize, bucket);
+//prefetch metadata and home element of hash, they are the first lines touched from probe
+__private inline void rbhash_prefetch(const rbhTable_s* t, size_t esize, uint64_t hash){
+	const uint64_t slot = rbhash_slot(hash, t->size);
+	__builtin_prefetch(&t->fp[slot]);
+	__builtin_prefetch(&t->dist[slot]);
+	__builtin_prefetch(rbhash_element_slot(t->el, esize, slot));
+}
 
+/* software pipeline in three stage, key i+2*RBHASH_BATCH is prefetched, key i+RBHASH_BATCH is hashed and slot prefetched, key i is probed
+ * cache miss of RBHASH_BATCH keys are in flight at same time
+ * incremental resize is not advanced, key not find in current table is searched in previous
+ */
+size_t rbhash_find_batch(rbhash_t* rbh, const void** keys, const size_t* lens, size_t n, void** out){
+	const size_t esize = rbh->elementSize;
+	const rbhTable_s* t = &rbh->tbl;
+	uint64_t hash[RBHASH_BATCH];
+	size_t found = 0;
+	const size_t window = n < RBHASH_BATCH ? n : RBHASH_BATCH;
+	for( size_t i = window; i < n && i < window * 2; ++i ) __builtin_prefetch(keys[i]);
+	for( size_t i = 0; i < window; ++i ){
+		hash[i] = rbh->hashing(keys[i], lens ? lens[i] : rbh->keySize);
+		rbhash_prefetch(t, esize, hash[i]);
+	}
+	for( size_t i = 0; i < n; ++i ){
+		const uint64_t h = hash[i & (RBHASH_BATCH - 1)];
+		const size_t next = i + RBHASH_BATCH;
+		if( next + RBHASH_BATCH < n ) __builtin_prefetch(keys[next + RBHASH_BATCH]);
+		if( next < n ){
+			const uint64_t nh = rbh->hashing(keys[next], lens ? lens[next] : rbh->keySize);
+			hash[next & (RBHASH_BATCH - 1)] = nh;
+			rbhash_prefetch(t, esize, nh);
+		}
+		const size_t len = lens ? lens[i] : rbh->keySize;
+		out[i] = NULL;
+		long s = rbhash_table_find(t, esize, h, keys[i], len, NULL);
+		if( s != -1 ){
+			out[i] = rbhash_element_slot(t->el, esize, s)->data;
+		}
+		else if( rbh->old.el && (s = rbhash_table_find(&rbh->old, esize, h, keys[i], len, NULL)) != -1 ){
+			out[i] = rbhash_element_slot(rbh->old.el, esize, s)->data;
+		}
+		if( out[i] ) ++found;
+	}
+	return found;
 }
 
-__private void rbhash_swapup(rbhElement_s* table, size_t size, size_t esize, size_t bucket){
-	size_t bucketfit = bucket;
-	bucket = rbhash_slot_next(bucket, size);
-	rbhElement_s* tbl = rbhash_element_slot(table, esize, bucket);
+//scan is a distance in a single table, resize need to be completed
+void* rbhash_findnx(rbhash_t* rbh, uint64_t hash, const void* key, size_t len, unsigned* scan){
+	rbhash_migrate(rbh, SIZE_MAX);
+	long bucket;
+	if( (bucket = rbhash_table_find(&rbh->tbl, rbh->elementSize, hash, key, len, scan)) == -1 ){
+		errno = ESRCH;
+		return NULL;
+	}
+	return rbhash_element_slot(rbh->tbl.el, rbh->elementSize, bucket);
+}
 
-	while( tbl->len != 0 && tbl->distance ){
-		rbhElement_s* tblfit = rbhash_element_slot(table, esize, bucketfit);
-		memcpy(tblfit, tbl, esize);
-		tbl->len = 0;
-		tbl->data = NULL;
-		bucketfit = bucket;
-		bucket = rbhash_slot_next(bucket, size);
-		table = rbhash_element_slot(table, esize, bucket);
+//backward shift, next elements are moved one slot back until empty or element on own home, no tombstone, never used on old table
+__private void rbhash_swapup(rbhTable_s* t, size_t esize, uint64_t bucket){
+	uint64_t next = rbhash_slot_next(bucket, t->size);
+	rbhElement_s* nel = rbhash_element_slot(t->el, esize, next);
+	while( t->fp[next] && nel->distance ){
+		const uint8_t f = t->fp[next];
+		rbhElement_s* el = rbhash_element_slot(t->el, esize, bucket);
+		rbhash_hist_del(t, nel->distance);
+		memcpy(el, nel, sizeof(rbhElement_s) + nel->len);
+		--el->distance;
+		rbhash_hist_add(t, el->distance);
+		rbhash_meta_put(t, bucket, f, rbhash_dist_sat(el->distance));
+		bucket = next;
+		next = rbhash_slot_next(next, t->size);
+		nel = rbhash_element_slot(t->el, esize, next);
 	}
+	rbhash_element_slot(t->el, esize, bucket)->data = NULL;
+	rbhash_meta_set(t, bucket, NULL);
 }
 
 void* rbhash_removeh(rbhash_t* rbh, uint64_t hash, const void* key, size_t len){
-	long bucket = rbhash_find_bucket(rbh, hash, key, len, NULL);
-	if( bucket == -1 ) return NULL;
-	rbhElement_s* el = rbhash_element_slot(rbh->table, rbh->elementSize, bucket);
+	rbhTable_s* t;
+	long bucket;
+	rbhElement_s* el = rbhash_lookup(rbh, hash, key, len, &t, &bucket);
+	if( !el ) return NULL;
 	void* ret = el->data;
-	el->len = 0;
-	el->data = 0;
-	rbhash_swapup(rbh->table, rbh->size, rbh->elementSize, bucket);
+	rbhash_hist_del(t, el->distance);
+	//backward shift on old table can wrap element not yet moved behind migrate cursor, mark as moved
+	if( t == &rbh->old ) rbhash_meta_put(t, bucket, RBHASH_MOVED, t->dist[bucket]);
+	else rbhash_swapup(t, rbh->elementSize, bucket);
+	--t->count;
 	--rbh->count;
+	if( t == &rbh->old && !t->count ) rbhash_table_release(rbh, t);
 	return ret;	
 }
 
@@ -208,31 +430,453 @@ size_t rbhash_bucket_used(rbhash_t* rbh){
 }
 
 size_t rbhash_bucket_count(rbhash_t* rbh){
-	return rbh->size;
+	return rbh->tbl.size;
 }
 
 size_t rbhash_collision(rbhash_t* rbh){
-	rbhElement_s* tbl = rbh->table;
-	size_t collision = 0;
-	for(size_t i =0; i < rbh->size; ++i, tbl = rbhash_element_next(tbl,rbh->elementSize)){
-		if( tbl->len != 0 && tbl->distance != 0 ) ++collision;
-	}
-	return collision;
+	return (rbh->tbl.count - rbh->tbl.hist[0]) + (rbh->old.count - rbh->old.hist[0]);
 }
 
 size_t rbhash_distance_max(rbhash_t* rbh){
-	return rbh->maxdistance;
+	return rbh->tbl.maxdistance > rbh->old.maxdistance ? rbh->tbl.maxdistance : rbh->old.maxdistance;
+}
+
+rbhashStat_s* rbhash_stat(rbhash_t* rbh, rbhashStat_s* st){
+	st->count = rbh->count;
+	st->size = rbh->tbl.size;
+	st->pending = rbh->old.count;
+	st->maxdistance = rbhash_distance_max(rbh);
+	size_t sum = 0;
+	for( size_t i = 0; i < RBHASH_HIST; ++i ){
+		st->hist[i] = rbh->tbl.hist[i] + rbh->old.hist[i];
+		sum += st->hist[i] * (i + 1);
+	}
+	st->probe = rbh->count ? (double)sum / rbh->count : 0.0;
+	st->load = (double)rbh->count / rbh->tbl.size;
+	return st;
 }
 
 void* rbhash_linear(rbhash_t* rbh, long* slot){
 	if( *slot == -1 ) return NULL;
-	while( *slot < (long)rbh->size){
-		rbhElement_s* bucket = rbhash_element_slot(rbh->table, rbh->elementSize, *slot);
-		++(*slot);
-		if( bucket->len ) return bucket->data;
+	rbhash_migrate(rbh, SIZE_MAX);
+	while( *slot < (long)rbh->tbl.size){
+		const long s = (*slot)++;
+		if( rbh->tbl.fp[s] ) return rbhash_element_slot(rbh->tbl.el, rbh->elementSize, s)->data;
 	}
 	*slot = -1;
 	return NULL;
 }
 
 
+
+/* persistent rbhash
+ * the file is a copy of table, slot data is offset of payload record, payload record is len and bytes aligned to 8
+ * metadata layout depend on RBHASH_GROUP and fingerprint, version change when they change
+ */
+
+#define RBHASH_FILE_MAGIC   "RBHASH\0\0"
+#define RBHASH_FILE_VERSION ((2U << 16) | RBHASH_GROUP)
+#define RBHASH_FILE_ALIGN   64
+
+typedef struct rbhFileHeader{
+	char magic[8];
+	uint32_t version;
+	uint32_t hashid;
+	uint64_t size;
+	uint64_t count;
+	uint64_t elementSize;
+	uint64_t keySize;
+	uint64_t maxdistance;
+	uint64_t offel;
+	uint64_t offmeta;
+	uint64_t offpayload;
+	uint64_t filesize;
+}rbhFileHeader_s;
+
+typedef struct rbhFilePayload{
+	const void* bytes;
+	size_t size;
+}rbhFilePayload_s;
+
+struct rbhashMap{
+	rbhTable_s tbl;         /**< table over mapped file*/
+	const uint8_t* base;    /**< mapped file*/
+	size_t filesize;        /**< mapped size*/
+	size_t elementSize;     /**< sizeof rbhashElement*/
+	size_t keySize;         /**< key size*/
+	rbhash_f hashing;       /**< function calcolate hash*/
+};
+
+__private size_t rbhash_file_write(int fd, const void* buf, size_t size){
+	const uint8_t* p = buf;
+	size_t w = 0;
+	while( w < size ){
+		const ssize_t nw = write(fd, p + w, size - w);
+		if( nw < 0 ){
+			if( errno == EINTR ) continue;
+			return w;
+		}
+		w += nw;
+	}
+	return w;
+}
+
+int rbhash_save(rbhash_t* rbh, int fd, rbhashPayload_f payload, void* ctx){
+	rbhash_migrate(rbh, SIZE_MAX);
+	const rbhTable_s* t = &rbh->tbl;
+	const size_t esize = rbh->elementSize;
+	const size_t metasize = (t->size + RBHASH_GROUP) * 2;
+	
+	//payload is requested one time for each element, offsets are known before build image
+	__free rbhFilePayload_s* pl = MANY(rbhFilePayload_s, t->size);
+	size_t psize = 0;
+	for( size_t i = 0; i < t->size; ++i ){
+		if( !t->fp[i] ) continue;
+		pl[i].size = 0;
+		pl[i].bytes = payload ? payload(rbhash_element_slot(t->el, esize, i)->data, &pl[i].size, ctx) : NULL;
+		if( !pl[i].bytes ) pl[i].size = 0;
+		psize += sizeof(uint64_t) + ROUND_UP(pl[i].size, sizeof(uint64_t));
+	}
+	
+	rbhFileHeader_s hdr = {
+		.version     = RBHASH_FILE_VERSION,
+		.hashid      = hash_id(rbh->hashing),
+		.size        = t->size,
+		.count       = rbh->count,
+		.elementSize = esize,
+		.keySize     = rbh->keySize,
+		.maxdistance = t->maxdistance
+	};
+	memcpy(hdr.magic, RBHASH_FILE_MAGIC, sizeof hdr.magic);
+	hdr.offel      = ROUND_UP(sizeof hdr, RBHASH_FILE_ALIGN);
+	hdr.offmeta    = ROUND_UP(hdr.offel + esize * t->size, RBHASH_FILE_ALIGN);
+	hdr.offpayload = ROUND_UP(hdr.offmeta + metasize, RBHASH_FILE_ALIGN);
+	hdr.filesize   = hdr.offpayload + psize;
+	
+	__free uint8_t* img = MANY(uint8_t, hdr.filesize);
+	memset(img, 0, hdr.offpayload);
+	memcpy(img, &hdr, sizeof hdr);
+	memcpy(img + hdr.offmeta, t->fp, metasize);
+	size_t off = hdr.offpayload;
+	for( size_t i = 0; i < t->size; ++i ){
+		if( !t->fp[i] ) continue;
+		const rbhElement_s* el = rbhash_element_slot(t->el, esize, i);
+		rbhElement_s* fel = rbhash_element_slot(img + hdr.offel, esize, i);
+		memcpy(fel, el, sizeof(rbhElement_s) + el->len);
+		fel->data = (void*)off;
+		const uint64_t len = pl[i].size;
+		memcpy(img + off, &len, sizeof len);
+		if( len ){
+			memcpy(img + off + sizeof len, pl[i].bytes, len);
+			memset(img + off + sizeof len + len, 0, ROUND_UP(len, sizeof(uint64_t)) - len);
+		}
+		off += sizeof len + ROUND_UP(len, sizeof(uint64_t));
+	}
+	iassert( off == hdr.filesize );
+	
+	if( rbhash_file_write(fd, img, hdr.filesize) != hdr.filesize ) return -1;
+	return 0;
+}
+
+__private void rbhash_map_dtor(void* addr){
+	rbhashMap_t* map = addr;
+	munmap((void*)map->base, map->filesize);
+}
+
+__private int rbhash_map_header_check(const rbhFileHeader_s* hdr, size_t filesize){
+	if( filesize < sizeof *hdr || memcmp(hdr->magic, RBHASH_FILE_MAGIC, sizeof hdr->magic) || hdr->version != RBHASH_FILE_VERSION ) return -1;
+	if( hdr->filesize != filesize || !hdr->size || (hdr->size & (hdr->size - 1)) || hdr->size < RBHASH_GROUP ) return -1;
+	const size_t esize = ROUND_UP(ROUND_UP(sizeof(rbhElement_s), sizeof(void*)) + hdr->keySize, sizeof(void*));
+	if( hdr->elementSize != esize || hdr->count > hdr->size ) return -1;
+	if( hdr->offel < sizeof *hdr || hdr->offmeta < hdr->offel + esize * hdr->size ) return -1;
+	if( hdr->offpayload < hdr->offmeta + (hdr->size + RBHASH_GROUP) * 2 || hdr->offpayload > filesize ) return -1;
+	return 0;
+}
+
+rbhashMap_t* rbhash_map_open(const char* path, rbhash_f hashing){
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if( fd == -1 ) return NULL;
+	struct stat st;
+	if( fstat(fd, &st) == -1 ){
+		close(fd);
+		return NULL;
+	}
+	if( (size_t)st.st_size < sizeof(rbhFileHeader_s) ){
+		close(fd);
+		errno = EBADMSG;
+		return NULL;
+	}
+	void* base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if( base == MAP_FAILED ) return NULL;
+	
+	const rbhFileHeader_s* hdr = base;
+	if( rbhash_map_header_check(hdr, st.st_size) ){
+		munmap(base, st.st_size);
+		errno = EBADMSG;
+		return NULL;
+	}
+	if( hdr->hashid != hash_id(hashing) ){
+		munmap(base, st.st_size);
+		errno = EINVAL;
+		return NULL;
+	}
+	
+	rbhashMap_t* map = NEW(rbhashMap_t);
+	map->base        = base;
+	map->filesize    = st.st_size;
+	map->elementSize = hdr->elementSize;
+	map->keySize     = hdr->keySize;
+	map->hashing     = hashing;
+	map->tbl.el          = (rbhElement_s*)(map->base + hdr->offel);
+	map->tbl.fp          = (uint8_t*)(map->base + hdr->offmeta);
+	map->tbl.dist        = map->tbl.fp + hdr->size + RBHASH_GROUP;
+	map->tbl.size        = hdr->size;
+	map->tbl.count       = hdr->count;
+	map->tbl.maxdistance = hdr->maxdistance;
+	mem_cleanup(map, rbhash_map_dtor);
+	return map;
+}
+
+const void* rbhash_map_findh(rbhashMap_t* map, uint64_t hash, const void* key, size_t len, size_t* size){
+	const long s = len > map->keySize ? -1 : rbhash_table_find(&map->tbl, map->elementSize, hash, key, len, NULL);
+	if( s == -1 ){
+		errno = ESRCH;
+		return NULL;
+	}
+	const uint64_t off = (uintptr_t)rbhash_element_slot(map->tbl.el, map->elementSize, s)->data;
+	uint64_t plen;
+	if( off + sizeof plen > map->filesize ) goto ONERR;
+	memcpy(&plen, map->base + off, sizeof plen);
+	if( plen > map->filesize - off - sizeof plen ) goto ONERR;
+	if( size ) *size = plen;
+	return map->base + off + sizeof plen;
+ONERR:
+	errno = EBADMSG;
+	return NULL;
+}
+
+const void* rbhash_map_find(rbhashMap_t* map, const void* key, size_t len, size_t* size){
+	return rbhash_map_findh(map, map->hashing(key, len), key, len, size);
+}
+
+size_t rbhash_map_count(rbhashMap_t* map){
+	return map->tbl.count;
+}
+
+/* crbhash, concurrent rbhash
+ * each segment is a robin hood table with own lock and version, segment is selected from bits of mixed hash not used by slot and fingerprint
+ * writers lock segment and make version odd while table change, readers never write shared memory,
+ * read is valid only if version is even and not changed at end of read
+ * table replaced on grow is never released until crbhash is freed, reader on old table read always valid memory,
+ * memory of old tables is less than current tables
+ */
+
+typedef struct crbhSegment{
+	unsigned version;  /**< odd while writer change table*/
+	glock_s lock;      /**< writers lock*/
+	rbhTable_s* tbl;   /**< current table*/
+	size_t min;        /**< elements where table grow*/
+}__cacheline crbhSegment_s;
+
+struct crbhash{
+	crbhSegment_s* seg;     /**< segments aligned to cache line*/
+	unsigned mask;          /**< segments - 1*/
+	size_t elementSize;     /**< sizeof rbhashElement*/
+	size_t pmin;            /**< percentage elements of free bucket*/
+	size_t keySize;         /**< key size*/
+	rbhash_f hashing;       /**< function calcolate hash*/
+};
+
+//slot use low bits of hash and fingerprint the 7 high bits of mixed hash, segment use mixed bits from 32
+#define crbhash_segment(CH, HASH) (&(CH)->seg[(RBHASH_MIX(HASH) >> 32) & (CH)->mask])
+
+__private rbhTable_s* crbhash_table_new(crbhash_t* ch, size_t size){
+	rbhTable_s* t = mem_gift(NEW(rbhTable_s), ch);
+	rbhash_table_ctor(t, size, ch->elementSize);
+	mem_gift(t->el, ch);
+	mem_gift(t->fp, ch);
+	return t;
+}
+
+crbhash_t* crbhash_new(size_t size, size_t min, size_t keysize, unsigned segments, rbhash_f hashing){
+	crbhash_t* ch = NEW(crbhash_t);
+	ch->pmin = min;
+	ch->hashing = hashing;
+	ch->keySize = keysize;
+	ch->elementSize = ROUND_UP(sizeof(rbhElement_s), sizeof(void*));
+	ch->elementSize = ROUND_UP(ch->elementSize + keysize, sizeof(void*));
+	if( !segments ) segments = topology_cpu_count() * CRBHASH_SEGMENT_CPU;
+	if( segments > CRBHASH_SEGMENT_MAX ) segments = CRBHASH_SEGMENT_MAX;
+	segments = ROUND_UP_POW_TWO32(segments);
+	ch->mask = segments - 1;
+	//one more element for realign to cache line
+	void* seg = mem_gift(MANY(crbhSegment_s, segments + 1), ch);
+	ch->seg = (crbhSegment_s*)ROUND_UP(ADDR(seg), CACHE_LINE_SIZE);
+	size = ROUND_UP_POW_TWO32(size / segments);
+	if( size < RBHASH_GROUP ) size = RBHASH_GROUP;
+	for( unsigned i = 0; i < segments; ++i ){
+		crbhSegment_s* s = &ch->seg[i];
+		s->version = 0;
+		mutex_ctor(&s->lock, 0);
+		s->tbl = crbhash_table_new(ch, size);
+		s->min = size - (size * min) / 100;
+	}
+	return ch;
+}
+
+//segment is locked, readers that see version odd or changed retry
+__private inline void crbhash_change_begin(crbhSegment_s* seg){
+	__atomic_store_n(&seg->version, seg->version + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+__private inline void crbhash_change_end(crbhSegment_s* seg){
+	__atomic_store_n(&seg->version, seg->version + 1, __ATOMIC_RELEASE);
+}
+
+//rehash all elements in new table and publish it, readers still on old table are invalidated from version
+__private void crbhash_segment_grow(crbhash_t* ch, crbhSegment_s* seg){
+	const rbhTable_s* o = seg->tbl;
+	rbhTable_s* t = crbhash_table_new(ch, o->size * 2);
+	rbhElement_s* scratch = rbhash_element_slot(t->el, ch->elementSize, t->size);
+	for( size_t i = 0; i < o->size; ++i ){
+		if( !o->fp[i] ) continue;
+		const rbhElement_s* el = rbhash_element_slot(o->el, ch->elementSize, i);
+		memcpy(scratch, el, sizeof(rbhElement_s) + el->len);
+		scratch->distance = 0;
+		rbhash_swapdown(t, ch->elementSize, scratch);
+	}
+	seg->min = t->size - (t->size * ch->pmin) / 100;
+	__atomic_store_n(&seg->tbl, t, __ATOMIC_RELEASE);
+}
+
+//segment is locked and version is odd
+__private void crbhash_segment_add(crbhash_t* ch, crbhSegment_s* seg, uint64_t hash, const void* key, size_t len, void* data){
+	rbhElement_s* el = rbhash_element_slot(seg->tbl->el, ch->elementSize, seg->tbl->size);
+	el->data = data;
+	el->distance = 0;
+	el->hash = hash;
+	el->len = len;
+	memcpy(el->key, key, len);
+	rbhash_swapdown(seg->tbl, ch->elementSize, el);
+	if( seg->tbl->count >= seg->min ) crbhash_segment_grow(ch, seg);
+}
+
+int crbhash_addh(crbhash_t* ch, uint64_t hash, const void* key, size_t len, void* data){
+	if( len > ch->keySize ){
+		errno = EFBIG;
+		return -1;
+	}
+	crbhSegment_s* seg = crbhash_segment(ch, hash);
+	mutex_guard(&seg->lock){
+		crbhash_change_begin(seg);
+		crbhash_segment_add(ch, seg, hash, key, len, data);
+		crbhash_change_end(seg);
+	}
+	return 0;
+}
+
+int crbhash_add(crbhash_t* ch, const void* key, size_t len, void* data){
+	return crbhash_addh(ch, ch->hashing(key, len), key, len, data);
+}
+
+int crbhash_adduh(crbhash_t* ch, uint64_t hash, const void* key, size_t len, void* data){
+	if( len > ch->keySize ){
+		errno = EFBIG;
+		return -1;
+	}
+	int ret = 0;
+	crbhSegment_s* seg = crbhash_segment(ch, hash);
+	mutex_guard(&seg->lock){
+		if( rbhash_table_find(seg->tbl, ch->elementSize, hash, key, len, NULL) != -1 ){
+			errno = EEXIST;
+			ret = -1;
+		}
+		else{
+			crbhash_change_begin(seg);
+			crbhash_segment_add(ch, seg, hash, key, len, data);
+			crbhash_change_end(seg);
+		}
+	}
+	return ret;
+}
+
+int crbhash_addu(crbhash_t* ch, const void* key, size_t len, void* data){
+	return crbhash_adduh(ch, ch->hashing(key, len), key, len, data);
+}
+
+void* crbhash_findh(crbhash_t* ch, uint64_t hash, const void* key, size_t len){
+	//torn element can't have len > keySize, memcmp never read out of element
+	if( len > ch->keySize ){
+		errno = ESRCH;
+		return NULL;
+	}
+	crbhSegment_s* seg = crbhash_segment(ch, hash);
+	void* data = NULL;
+	for( unsigned retry = 0; retry < CRBHASH_OPTIMISTIC; ++retry ){
+		const unsigned v = __atomic_load_n(&seg->version, __ATOMIC_ACQUIRE);
+		if( v & 1 ){
+			cpu_relax();
+			continue;
+		}
+		const rbhTable_s* t = __atomic_load_n(&seg->tbl, __ATOMIC_ACQUIRE);
+		const long s = rbhash_table_find(t, ch->elementSize, hash, key, len, NULL);
+		data = s == -1 ? NULL : rbhash_element_slot(t->el, ch->elementSize, s)->data;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if( __atomic_load_n(&seg->version, __ATOMIC_RELAXED) == v ) goto ONEND;
+	}
+	//writers never leave segment, read in lock
+	mutex_guard(&seg->lock){
+		const long s = rbhash_table_find(seg->tbl, ch->elementSize, hash, key, len, NULL);
+		data = s == -1 ? NULL : rbhash_element_slot(seg->tbl->el, ch->elementSize, s)->data;
+	}
+ONEND:
+	if( !data ) errno = ESRCH;
+	return data;
+}
+
+void* crbhash_find(crbhash_t* ch, const void* key, size_t len){
+	return crbhash_findh(ch, ch->hashing(key, len), key, len);
+}
+
+void* crbhash_removeh(crbhash_t* ch, uint64_t hash, const void* key, size_t len){
+	crbhSegment_s* seg = crbhash_segment(ch, hash);
+	void* ret = NULL;
+	mutex_guard(&seg->lock){
+		rbhTable_s* t = seg->tbl;
+		const long s = len > ch->keySize ? -1 : rbhash_table_find(t, ch->elementSize, hash, key, len, NULL);
+		if( s != -1 ){
+			crbhash_change_begin(seg);
+			rbhElement_s* el = rbhash_element_slot(t->el, ch->elementSize, s);
+			ret = el->data;
+			rbhash_hist_del(t, el->distance);
+			rbhash_swapup(t, ch->elementSize, s);
+			--t->count;
+			crbhash_change_end(seg);
+		}
+	}
+	if( !ret ) errno = ESRCH;
+	return ret;
+}
+
+void* crbhash_remove(crbhash_t* ch, const void* key, size_t len){
+	return crbhash_removeh(ch, ch->hashing(key, len), key, len);
+}
+
+uint64_t crbhash_hash(crbhash_t* ch, const void* key, size_t len){
+	return ch->hashing(key, len);
+}
+
+//not linearizable, each segment is read at different time
+size_t crbhash_segment_count(crbhash_t* ch, unsigned index){
+	return __atomic_load_n(&__atomic_load_n(&ch->seg[index & ch->mask].tbl, __ATOMIC_ACQUIRE)->count, __ATOMIC_RELAXED);
+}
+
+size_t crbhash_count(crbhash_t* ch){
+	size_t count = 0;
+	for( unsigned i = 0; i <= ch->mask; ++i ){
+		count += __atomic_load_n(&__atomic_load_n(&ch->seg[i].tbl, __ATOMIC_ACQUIRE)->count, __ATOMIC_RELAXED);
+	}
+	return count;
+}
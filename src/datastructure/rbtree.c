@@ -1,321 +1,371 @@
 #include <notstd/rbtree.h>
-#include <notstd/vector.h>
-
-#define RBT_BLACK   0
-#define RBT_RED     1
-#define RBT_RAINBOW 2
 
 struct rbtNode{
-	struct rbtNode* parent;
-	struct rbtNode* left;
-	struct rbtNode* right;
+	rbtLink_s link;
 	void* data;
-	int color;
+	size_t size;
 };
 
 struct rbtree{
-	rbtNode_t* root;
+	rbtRoot_s root;
 	cmp_f cmp;
-	size_t count;
 };
 
-__private void rbt_leftrotate(rbtNode_t** root, rbtNode_t* p){
-    if( p->right == NULL ) return;
-    rbtNode_t* y = p->right;
-    if( y->left ){
-        p->right = y->left;
-        y->left->parent = p;
-    }
-    else{
-        p->right=NULL;
-	}
+__private inline rbtNode_t* rbt_node(rbtLink_s* l){
+	return l ? container_of(l, rbtNode_t, link) : NULL;
+}
+
+#define rbt_red(L) ((L) && (L)->color == RBT_RED)
+#define rbt_size(L) ((L) ? rbt_node(L)->size : 0)
 
-	if( p->parent ){
-        y->parent = p->parent;
-        if( p == p->parent->left ) p->parent->left = y;
-        else p->parent->right = y;
+/*** link ***/
+
+//parent of old point to new
+__private void rbt_replace(rbtRoot_s* root, rbtLink_s* old, rbtLink_s* new){
+	rbtLink_s* p = old->parent;
+	if( !p ) root->root = new;
+	else if( p->left == old ) p->left = new;
+	else p->right = new;
+}
+
+__private void rbt_leftrotate(rbtRoot_s* root, rbtLink_s* p){
+	rbtLink_s* y = p->right;
+	p->right = y->left;
+	if( y->left ) y->left->parent = p;
+	y->parent = p->parent;
+	rbt_replace(root, p, y);
+	y->left = p;
+	p->parent = y;
+	if( root->augment ){
+		root->augment(p);
+		root->augment(y);
 	}
-	else{
-        *root = y;
-		y->parent = NULL;
+}
+
+__private void rbt_rightrotate(rbtRoot_s* root, rbtLink_s* p){
+	rbtLink_s* y = p->left;
+	p->left = y->right;
+	if( y->right ) y->right->parent = p;
+	y->parent = p->parent;
+	rbt_replace(root, p, y);
+	y->right = p;
+	p->parent = y;
+	if( root->augment ){
+		root->augment(p);
+		root->augment(y);
 	}
+}
 
-    y->left = p;
-    p->parent = y;
+//n changed children, update it and all ancestors
+__private void rbt_augment_path(rbtRoot_s* root, rbtLink_s* n){
+	if( !root->augment ) return;
+	for(; n; n = n->parent ) root->augment(n);
+}
+
+__private void rbt_insertfix(rbtRoot_s* root, rbtLink_s* n){
+	rbtLink_s* p;
+	while( (p = n->parent) && p->color == RBT_RED ){
+		rbtLink_s* g = p->parent;
+		iassert(g);
+		if( g->left == p ){
+			rbtLink_s* u = g->right;
+			if( rbt_red(u) ){
+				p->color = RBT_BLACK;
+				u->color = RBT_BLACK;
+				g->color = RBT_RED;
+				n = g;
+				continue;
+			}
+			if( p->right == n ){
+				rbt_leftrotate(root, p);
+				n = p;
+				p = n->parent;
+			}
+			p->color = RBT_BLACK;
+			g->color = RBT_RED;
+			rbt_rightrotate(root, g);
+		}
+		else{
+			rbtLink_s* u = g->left;
+			if( rbt_red(u) ){
+				p->color = RBT_BLACK;
+				u->color = RBT_BLACK;
+				g->color = RBT_RED;
+				n = g;
+				continue;
+			}
+			if( p->left == n ){
+				rbt_rightrotate(root, p);
+				n = p;
+				p = n->parent;
+			}
+			p->color = RBT_BLACK;
+			g->color = RBT_RED;
+			rbt_leftrotate(root, g);
+		}
+	}
+	root->root->color = RBT_BLACK;
 }
 
-__private void rbt_rightrotate(rbtNode_t** root, rbtNode_t* p){
-    if( p->left == NULL) return ;
+void rbtree_link_insert(rbtRoot_s* root, rbtLink_s* parent, rbtLink_s** where, rbtLink_s* n){
+	n->parent = parent;
+	n->left = n->right = NULL;
+	n->color = RBT_RED;
+	*where = n;
+	rbt_augment_path(root, n);
+	rbt_insertfix(root, n);
+	++root->count;
+}
 
-    rbtNode_t* y = p->left;
-    if( y->right ){
-        p->left = y->right;
-        y->right->parent = p;
-    }
-    else{
-        p->left = NULL;
+//x replace a black node and can be NULL, p is parent of x
+__private void rbt_removefix(rbtRoot_s* root, rbtLink_s* x, rbtLink_s* p){
+	rbtLink_s* s;
+	while( x != root->root && !rbt_red(x) ){
+		if( p->left == x ){
+			s = p->right;
+			if( s->color == RBT_RED ){
+				s->color = RBT_BLACK;
+				p->color = RBT_RED;
+				rbt_leftrotate(root, p);
+				s = p->right;
+			}
+			if( !rbt_red(s->left) && !rbt_red(s->right) ){
+				s->color = RBT_RED;
+				x = p;
+				p = x->parent;
+			}
+			else{
+				if( !rbt_red(s->right) ){
+					s->left->color = RBT_BLACK;
+					s->color = RBT_RED;
+					rbt_rightrotate(root, s);
+					s = p->right;
+				}
+				s->color = p->color;
+				p->color = RBT_BLACK;
+				s->right->color = RBT_BLACK;
+				rbt_leftrotate(root, p);
+				x = root->root;
+			}
+		}
+		else{
+			s = p->left;
+			if( s->color == RBT_RED ){
+				s->color = RBT_BLACK;
+				p->color = RBT_RED;
+				rbt_rightrotate(root, p);
+				s = p->left;
+			}
+			if( !rbt_red(s->left) && !rbt_red(s->right) ){
+				s->color = RBT_RED;
+				x = p;
+				p = x->parent;
+			}
+			else{
+				if( !rbt_red(s->left) ){
+					s->right->color = RBT_BLACK;
+					s->color = RBT_RED;
+					rbt_leftrotate(root, s);
+					s = p->left;
+				}
+				s->color = p->color;
+				p->color = RBT_BLACK;
+				s->left->color = RBT_BLACK;
+				rbt_rightrotate(root, p);
+				x = root->root;
+			}
+		}
 	}
+	if( x ) x->color = RBT_BLACK;
+}
 
-	if( p->parent ){
-		y->parent = p->parent;
-		if( p == p->parent->left ) p->parent->left = y;
-		else p->parent->right = y;
+void rbtree_link_remove(rbtRoot_s* root, rbtLink_s* z){
+	rbtLink_s* x;
+	rbtLink_s* p;
+	int color;
+
+	if( !z->left || !z->right ){
+		x = z->left ? z->left : z->right;
+		p = z->parent;
+		color = z->color;
+		if( x ) x->parent = p;
+		rbt_replace(root, z, x);
 	}
 	else{
-        *root = y;
-		y->parent = NULL;
+		//successor take place of z
+		rbtLink_s* y = z->right;
+		while( y->left ) y = y->left;
+		color = y->color;
+		x = y->right;
+		if( y->parent == z ){
+			p = y;
+		}
+		else{
+			p = y->parent;
+			p->left = x;
+			if( x ) x->parent = p;
+			y->right = z->right;
+			z->right->parent = y;
+		}
+		y->left = z->left;
+		z->left->parent = y;
+		y->parent = z->parent;
+		y->color = z->color;
+		rbt_replace(root, z, y);
 	}
-    
-	y->right = p;
-    p->parent = y;
-}
-
-__private void rbt_insertfix(rbtNode_t** root, rbtNode_t *page){
-    rbtNode_t* u;
-    if( *root == page){
-        page->color = RBT_BLACK;
-        return;
-    }
-	iassert(page->parent);
-    while( page->parent && page->parent->color == RBT_RED){
-        rbtNode_t* g = page->parent->parent;
-		iassert(g);
-        if( g->left == page->parent ){
-            if( g->right ){
-                u = g->right;
-				if( u->color == RBT_RED ){
-                    page->parent->color = RBT_BLACK;
-                    u->color = RBT_BLACK;
-                    g->color = RBT_RED;
-                    page = g;
-                }
-				else{
-					break;
-				}
-            }
-            else{
-                if( page->parent->right == page ){
-                    page = page->parent;
-                    rbt_leftrotate(root, page);
-                }
-                page->parent->color = RBT_BLACK;
-                g->color = RBT_RED;
-                rbt_rightrotate(root, g);
-            }
-        }
-        else{
-            if( g->left ){
-                u = g->left;
-				if( u->color == RBT_RED ){
-                    page->parent->color = RBT_BLACK;
-                    u->color = RBT_BLACK;
-                    g->color = RBT_RED;
-                    page = g;
-                }
-				else{
-					break;
-				}
-            }
-            else{
-                if( page->parent->left == page ){
-                    page = page->parent;
-                    rbt_rightrotate(root, page);
-                }
-                page->parent->color = RBT_BLACK;
-                g->color = RBT_RED;
-                rbt_leftrotate(root, g);
-            }
-        }
-        (*root)->color = RBT_BLACK;
-    }
+	//p is deepest node changed, successor moved in z is ancestor of p
+	rbt_augment_path(root, p);
+	if( color == RBT_BLACK && root->root ) rbt_removefix(root, x, p);
+
+	z->parent = z->left = z->right = NULL;
+	z->color = RBT_RAINBOW;
+	--root->count;
 }
 
-rbtNode_t* rbtree_insert(rbtree_t* rbt, rbtNode_t* page){
-	if( page->color != RBT_RAINBOW ) return page;
+rbtLink_s* rbtree_link_first(rbtRoot_s* root){
+	rbtLink_s* n = root->root;
+	if( n ) while( n->left ) n = n->left;
+	return n;
+}
 
-	page->color = RBT_RED;
-    rbtNode_t* p = rbt->root;
-    rbtNode_t* q = NULL;
+rbtLink_s* rbtree_link_last(rbtRoot_s* root){
+	rbtLink_s* n = root->root;
+	if( n ) while( n->right ) n = n->right;
+	return n;
+}
 
-    if( !rbt->root ){ 
-		rbt->root = page;
+rbtLink_s* rbtree_link_next(rbtLink_s* n){
+	if( n->right ){
+		n = n->right;
+		while( n->left ) n = n->left;
+		return n;
 	}
-    else{
-        while( p != NULL ){
-            q = p;
-            if( rbt->cmp(p->data, page->data) < 0 )
-                p = p->right;
-            else
-                p = p->left;
-        }
-        page->parent = q;
-        if( rbt->cmp(q->data, page->data) < 0 )
-            q->right = page;
-        else
-            q->left = page;
-    }
-    rbt_insertfix(&rbt->root, page);
-	++rbt->count;
-	return page;
+	rbtLink_s* p;
+	while( (p = n->parent) && p->right == n ) n = p;
+	return p;
 }
 
-__private void rbt_removefix(rbtNode_t** root, rbtNode_t* p){
-	iassert(p);
-    rbtNode_t* s;
-    while( p != *root && p->color == RBT_BLACK ){
-        if( p->parent->left == p ){
-            s = p->parent->right;
-            if( s->color == RBT_RED ){
-                s->color = RBT_BLACK;
-                p->parent->color = RBT_RED;
-                rbt_leftrotate(root, p->parent);
-                s = p->parent->right;
-            }
-            if( s->right->color == RBT_BLACK && s->left->color == RBT_BLACK ){
-                s->color = RBT_RED;
-                p = p->parent;
-            }
-            else{
-                if( s->right->color == RBT_BLACK ){
-                    s->left->color = RBT_BLACK;
-                    s->color = RBT_RED;
-                    rbt_rightrotate(root, s);
-                    s = p->parent->right;
-                }
-                s->color = p->parent->color;
-                p->parent->color = RBT_BLACK;
-                s->right->color = RBT_BLACK;
-                rbt_leftrotate(root, p->parent);
-                p = *root;
-            }
-        }
-        else{
-            s = p->parent->left;
-            if( s->color == RBT_RED ){
-                s->color=RBT_BLACK;
-                p->parent->color = RBT_RED;
-                rbt_rightrotate(root, p->parent);
-                s = p->parent->left;
-            }
-            if( s->left->color == RBT_BLACK && s->right->color == RBT_BLACK){
-                s->color = RBT_RED;
-                p = p->parent;
-            }
-            else{
-                if(s->left->color == RBT_BLACK){
-                    s->right->color = RBT_BLACK;
-                    s->color = RBT_RED;
-                    rbt_leftrotate(root, s);
-                    s = p->parent->left;
-                }
-                s->color = p->parent->color;
-                p->parent->color = RBT_BLACK;
-                s->left->color = RBT_BLACK;
-                rbt_rightrotate(root, p->parent);
-                p = *root;
-            }
-        }
-
-        p->color=RBT_BLACK;
-        (*root)->color = RBT_BLACK;
-    }
-}
-
-__private rbtNode_t* rbt_successor(rbtNode_t* p){
-    rbtNode_t* y = NULL;
-    if( p->left ){
-        y = p->left;
-        while( y->right ) y = y->right;
-    }
-    else{
-        y = p->right;
-        while( y->left ) y = y->left;
-    }
-    return y;
+rbtLink_s* rbtree_link_prev(rbtLink_s* n){
+	if( n->left ){
+		n = n->left;
+		while( n->right ) n = n->right;
+		return n;
+	}
+	rbtLink_s* p;
+	while( (p = n->parent) && p->left == n ) n = p;
+	return p;
 }
 
-rbtNode_t* rbtree_remove(rbtree_t* rbt, rbtNode_t* p){
-	if( p->color == RBT_RAINBOW ) return p;
-	if( !rbt->root || !p ) return NULL;
-	--rbt->count;
-	if( (rbt->root) == p && (rbt->root)->left == NULL && (rbt->root)->right == NULL ){
-		p->parent = p->left = p->right = NULL;
-		rbt->root = NULL;
-		p->color = RBT_RAINBOW;
-		return p;
-	}
+/*** bulk ***/
+
+//v is sorted, middle is root and each level is full except last, last level is red and all other black
+__private rbtLink_s* rbt_build(rbtRoot_s* root, rbtLink_s** v, size_t n, rbtLink_s* parent, unsigned depth, unsigned red){
+	if( !n ) return NULL;
+	const size_t mid = n / 2;
+	rbtLink_s* l = v[mid];
+	l->parent = parent;
+	l->color  = depth == red ? RBT_RED : RBT_BLACK;
+	l->left   = rbt_build(root, v, mid, l, depth + 1, red);
+	l->right  = rbt_build(root, v + mid + 1, n - mid - 1, l, depth + 1, red);
+	if( root->augment ) root->augment(l);
+	return l;
+}
 
-    rbtNode_t* y = NULL;
-    rbtNode_t* q = NULL;
+void rbtree_link_build(rbtRoot_s* root, rbtLink_s** sorted, size_t n){
+	iassert( !root->root );
+	root->count = n;
+	root->root  = rbt_build(root, sorted, n, NULL, 0, n ? 63 - __builtin_clzll(n) : 0);
+	if( root->root ) root->root->color = RBT_BLACK;
+}
 
-	if( p->left == NULL || p->right==NULL ) y = p;
-	else y = rbt_successor(p);
+__private size_t rbt_flatten(rbtRoot_s* root, rbtLink_s** out){
+	size_t n = 0;
+	for( rbtLink_s* l = rbtree_link_first(root); l; l = rbtree_link_next(l) ) out[n++] = l;
+	return n;
+}
 
-	if( y->left ) q = y->left;
-	else if( y->right ) q = y->right;
+//linear merge of two sorted list, lcmp compare links, otherwise dcmp compare data of rbtNode_t
+__private void rbt_merge(rbtRoot_s* dst, rbtRoot_s* src, rbtLinkCmp_f lcmp, cmp_f dcmp){
+	const size_t na = dst->count;
+	const size_t nb = src->count;
+	if( !nb ) return;
+	__free rbtLink_s** v = MANY(rbtLink_s*, (na + nb) * 2);
+	rbtLink_s** a = v + na + nb;
+	rbtLink_s** b = a + na;
+	rbt_flatten(dst, a);
+	rbt_flatten(src, b);
+	size_t i = 0, j = 0, k = 0;
+	while( i < na && j < nb ){
+		const int c = lcmp ? lcmp(b[j], a[i]) : dcmp(rbt_node(b[j])->data, rbt_node(a[i])->data);
+		v[k++] = c < 0 ? b[j++] : a[i++];
+	}
+	while( i < na ) v[k++] = a[i++];
+	while( j < nb ) v[k++] = b[j++];
+	dst->root  = NULL;
+	src->root  = NULL;
+	src->count = 0;
+	rbtree_link_build(dst, v, k);
+}
 
-	if( q ) q->parent = y->parent;
+void rbtree_link_merge(rbtRoot_s* dst, rbtRoot_s* src, rbtLinkCmp_f cmp){
+	rbt_merge(dst, src, cmp, NULL);
+}
 
-	if( !y->parent ) rbt->root = q;
-	else{
-        if( y == y->parent->left ) y->parent->left = q;
-        else y->parent->right = q;
-    }
-
-    if( y != p ){
-		p->color = y->color;
-		if( p->parent ){
-			if( p->parent->left == p ) p->parent->left = y;
-			else if( p->parent->right == p ) p->parent->right = y;
-		}
-		else{
-			rbt->root = y;
-		}
-		if( y->parent ){
-			if( y->parent->left == y ) y->parent->left = p;
-			else if( y->parent->right == y ) y->parent->right = p;
-		}
-		else{
-			rbt->root = p;
-		}
-		swap(p->parent, y->parent);
-		swap(p->left, y->left);
-		swap(p->right, y->right);
-	}
-	if( q && y->color == RBT_BLACK ) rbt_removefix(&rbt->root, q);
+/*** rbtree ***/
 
-	if( p->parent ){
-		if( p->parent->left == p ) p->parent->left = NULL;
-		else if( p->parent->right == p ) p->parent->right = NULL;
+rbtNode_t* rbtree_insert(rbtree_t* rbt, rbtNode_t* page){
+	if( page->link.color != RBT_RAINBOW ) return page;
+	rbtLink_s* p = NULL;
+	rbtLink_s** w = &rbt->root.root;
+	while( *w ){
+		p = *w;
+		w = rbt->cmp(rbt_node(p)->data, page->data) < 0 ? &p->right : &p->left;
 	}
-	p->parent = p->left = p->right = NULL;
-	p->color = RBT_RAINBOW;
+	rbtree_link_insert(&rbt->root, p, w, &page->link);
+	return page;
+}
+
+rbtNode_t* rbtree_remove(rbtree_t* rbt, rbtNode_t* p){
+	if( !p ) return NULL;
+	if( p->link.color == RBT_RAINBOW ) return p;
+	rbtree_link_remove(&rbt->root, &p->link);
 	return p;
 }
 
 rbtNode_t* rbtree_find(rbtree_t* rbt, const void* key){
-	rbtNode_t* p = rbt->root;
+	rbtLink_s* p = rbt->root.root;
 	int cmp;
-    while( p && (cmp=rbt->cmp(p->data, key)) ){
-        p = cmp < 0 ? p->right : p->left;
-    }
-	return p;
+	while( p && (cmp=rbt->cmp(rbt_node(p)->data, key)) ){
+		p = cmp < 0 ? p->right : p->left;
+	}
+	return rbt_node(p);
 }
 
 rbtNode_t* rbtree_find_best(rbtree_t* rbt, const void* key){
-	rbtNode_t* p = rbt->root;
-	while( p && rbt->cmp(p->data, key) < 0 ){
-		p = p->right;
-		while( p && p->left && rbt->cmp(p->left->data, key) >= 0 ) p = p->left;
-    }
-	return p;
+	rbtLink_s* p = rbt->root.root;
+	rbtLink_s* best = NULL;
+	while( p ){
+		if( rbt->cmp(rbt_node(p)->data, key) < 0 ){
+			p = p->right;
+		}
+		else{
+			best = p;
+			p = p->left;
+		}
+	}
+	return rbt_node(best);
+}
+
+__private void rbt_size_augment(rbtLink_s* l){
+	rbt_node(l)->size = 1 + rbt_size(l->left) + rbt_size(l->right);
 }
 
 rbtree_t* rbtree_new(cmp_f fn){
 	rbtree_t* t = NEW(rbtree_t);
-	t->root  = NULL;
-	t->cmp   = fn;
-	t->count = 0;
+	t->root.root    = NULL;
+	t->root.count   = 0;
+	t->root.augment = rbt_size_augment;
+	t->cmp          = fn;
 	return t;
 }
 
@@ -326,9 +376,10 @@ rbtree_t* rbtree_cmp(rbtree_t* t, cmp_f fn){
 
 rbtNode_t* rbtree_node_new(void* data){
 	rbtNode_t* n = NEW(rbtNode_t);
-	n->color  = RBT_RAINBOW;
-	n->data   = data; 
-	n->parent = n->left = n->right = NULL;
+	n->link.color  = RBT_RAINBOW;
+	n->link.parent = n->link.left = n->link.right = NULL;
+	n->data = data;
+	n->size = 1;
 	return n;
 }
 
@@ -342,58 +393,183 @@ rbtNode_t* rbtree_node_data_set(rbtNode_t* n, void* data){
 }
 
 rbtNode_t* rbtree_node_root(rbtree_t* t){
-	return t->root;
+	return rbt_node(t->root.root);
 }
 
 rbtNode_t* rbtree_node_left(rbtNode_t* node){
-	if( node->color == RBT_RAINBOW ) return NULL;
-	return node->left;
+	if( node->link.color == RBT_RAINBOW ) return NULL;
+	return rbt_node(node->link.left);
 }
 
 rbtNode_t* rbtree_node_right(rbtNode_t* node){
-	if( node->color == RBT_RAINBOW ) return NULL;
-	return node->right;
+	if( node->link.color == RBT_RAINBOW ) return NULL;
+	return rbt_node(node->link.right);
 }
 
 rbtNode_t* rbtree_node_parent(rbtNode_t* node){
-	if( node->color == RBT_RAINBOW ) return NULL;
-	return node->parent;
+	if( node->link.color == RBT_RAINBOW ) return NULL;
+	return rbt_node(node->link.parent);
+}
+
+rbtree_t* rbtree_bulk_build(rbtree_t* t, void** sorted, size_t n){
+	if( t->root.root ){
+		errno = ENOTEMPTY;
+		return NULL;
+	}
+	for( size_t i = 1; i < n; ++i ){
+		if( t->cmp(sorted[i-1], sorted[i]) > 0 ){
+			errno = EINVAL;
+			return NULL;
+		}
+	}
+	__free rbtLink_s** v = MANY(rbtLink_s*, n ? n : 1);
+	for( size_t i = 0; i < n; ++i ){
+		rbtNode_t* node = mem_gift(rbtree_node_new(sorted[i]), t);
+		v[i] = &node->link;
+	}
+	rbtree_link_build(&t->root, v, n);
+	return t;
+}
+
+rbtree_t* rbtree_merge(rbtree_t* a, rbtree_t* b){
+	rbt_merge(&a->root, &b->root, NULL, a->cmp);
+	mem_borrowed(b, a);
+	return a;
+}
+
+/*** order statistic ***/
+
+rbtNode_t* rbtree_select(rbtree_t* t, size_t k){
+	rbtLink_s* l = t->root.root;
+	while( l ){
+		const size_t ls = rbt_size(l->left);
+		if( k < ls ){
+			l = l->left;
+		}
+		else if( k == ls ){
+			break;
+		}
+		else{
+			k -= ls + 1;
+			l = l->right;
+		}
+	}
+	return rbt_node(l);
+}
+
+size_t rbtree_rank(rbtree_t* t, const void* key){
+	rbtLink_s* l = t->root.root;
+	size_t rank = 0;
+	while( l ){
+		if( t->cmp(rbt_node(l)->data, key) < 0 ){
+			rank += rbt_size(l->left) + 1;
+			l = l->right;
+		}
+		else{
+			l = l->left;
+		}
+	}
+	return rank;
+}
+
+size_t rbtree_node_index(rbtNode_t* node){
+	rbtLink_s* l = &node->link;
+	size_t index = rbt_size(l->left);
+	for( rbtLink_s* p = l->parent; p; l = p, p = p->parent ){
+		if( p->right == l ) index += rbt_size(p->left) + 1;
+	}
+	return index;
+}
+
+/*** cursor ***/
+
+rbtCursor_s rbtree_link_cursor(rbtLink_s* begin, rbtLink_s* end, int reverse){
+	return (rbtCursor_s){ .cur = begin, .end = end, .reverse = reverse };
+}
+
+rbtLink_s* rbtree_link_cursor_next(rbtCursor_s* c){
+	rbtLink_s* n = c->cur;
+	if( !n || n == c->end ) return NULL;
+	rbtLink_s* next = c->reverse ? rbtree_link_prev(n) : rbtree_link_next(n);
+	//successor of next start from this child
+	if( next ) __builtin_prefetch(c->reverse ? next->left : next->right);
+	c->cur = next;
+	return n;
+}
+
+rbtNode_t* rbtree_node_next(rbtNode_t* node){
+	return rbt_node(rbtree_link_next(&node->link));
+}
+
+rbtNode_t* rbtree_node_prev(rbtNode_t* node){
+	return rbt_node(rbtree_link_prev(&node->link));
+}
+
+rbtNode_t* rbtree_lower_bound(rbtree_t* t, const void* key){
+	return rbtree_find_best(t, key);
+}
+
+rbtNode_t* rbtree_upper_bound(rbtree_t* t, const void* key){
+	rbtLink_s* p = t->root.root;
+	rbtLink_s* best = NULL;
+	while( p ){
+		if( t->cmp(rbt_node(p)->data, key) <= 0 ){
+			p = p->right;
+		}
+		else{
+			best = p;
+			p = p->left;
+		}
+	}
+	return rbt_node(best);
+}
+
+rbtCursor_s rbtree_cursor(rbtree_t* t, int reverse){
+	return rbtree_link_cursor(reverse ? rbtree_link_last(&t->root) : rbtree_link_first(&t->root), NULL, reverse);
 }
 
+rbtCursor_s rbtree_cursor_range(rbtNode_t* begin, rbtNode_t* end){
+	return rbtree_link_cursor(begin ? &begin->link : NULL, end ? &end->link : NULL, 0);
+}
+
+rbtNode_t* rbtree_cursor_next(rbtCursor_s* c){
+	rbtLink_s* l = rbtree_link_cursor_next(c);
+	if( c->cur ) __builtin_prefetch(rbt_node(c->cur)->data);
+	return rbt_node(l);
+}
+
+/*** iterator ***/
+
 struct rbtreeit{
 	unsigned count;
-	rbtNode_t*  cur;
-	rbtNode_t** stk;
+	rbtCursor_s cursor;
 };
 
-rbtree_i* rbtree_inorder_iterator(rbtree_t* t, unsigned offset, unsigned count){
+__private rbtree_i* rbt_iterator(rbtCursor_s c, unsigned count){
 	rbtree_i* it = NEW(rbtree_i);
-	if( !count ) count = t->count;
-	if( count > t->count ) count = t->count;
-	size_t h = 2 * log2(count+1);
-	if( h < 2 ) h = 2;
-	it->count = t->count;
-	it->stk = mem_gift(VECTOR(rbtNode_t*, h), it);
-	it->cur = t->root;
-	while( offset --> 0 ) rbtree_inorder_iterate(it);
-	it->count = count;
+	it->cursor = c;
+	it->count  = count ? count : UINT_MAX;
 	return it;
 }
 
+rbtree_i* rbtree_inorder_iterator(rbtree_t* t, unsigned offset, unsigned count){
+	return rbt_iterator(rbtree_cursor_range(rbtree_select(t, offset), NULL), count);
+}
+
+rbtree_i* rbtree_reverse_iterator(rbtree_t* t, unsigned offset, unsigned count){
+	rbtNode_t* start = offset < t->root.count ? rbtree_select(t, t->root.count - offset - 1) : NULL;
+	return rbt_iterator(rbtree_link_cursor(start ? &start->link : NULL, NULL, 1), count);
+}
+
+rbtree_i* rbtree_range_iterator(rbtree_t* t, const void* key, unsigned count){
+	return rbt_iterator(rbtree_cursor_range(rbtree_find_best(t, key), NULL), count);
+}
+
 void* rbtree_inorder_iterate(void* IT){
 	rbtree_i* it = IT;
 	if( !it->count ) return NULL;
-	while( it->cur ){
-		vector_push(&it->stk, &it->cur);
-		it->cur = it->cur->left;
-	}
-	if( !vector_count(&it->stk) ) return NULL;
-	
-	rbtNode_t* n;
-	vector_pop(&it->stk, &n);
-	it->cur = n->right;
 	--it->count;
-	return n;
+	return rbtree_cursor_next(&it->cursor);
 }
 
 /*
@@ -420,5 +596,9 @@ void map_rbtree_postorder(rbtNode_t* n, rbtMap_f fn, void* arg){
 */
 
 size_t rbtree_count(rbtree_t* t){
-	return t->count;
+	return t->root.count;
+}
+
+rbtRoot_s* rbtree_root(rbtree_t* t){
+	return &t->root;
 }
@@ -0,0 +1,267 @@
+#include <notstd/skiplist.h>
+#include <notstd/threads.h>
+
+/* next[l] is pointer to next node at level l, bit 0 is set when node is removed and pointer can't change more
+ * remove mark from top to level 0, who mark level 0 own the remove, node is logical removed when level 0 is marked
+ * insert link level 0 and then up, inserter and remover hold one ref, last ref retire the node,
+ * node is retired only after is unlinked from all levels
+ */
+typedef struct slNode{
+	void* data;
+	unsigned level;
+	unsigned refs;
+	uintptr_t next[];
+}slNode_s;
+
+struct skiplist{
+	slNode_s* head;
+	cmp_f cmp;
+	size_t count;
+	unsigned level;
+};
+
+struct skiplistit{
+	slNode_s* cur;
+	unsigned count;
+};
+
+#define SL_MARK         ((uintptr_t)1)
+#define sl_marked(P)    ((P) & SL_MARK)
+#define sl_ptr(P)       ((slNode_s*)((P) & ~SL_MARK))
+#define sl_next(N,L)    __atomic_load_n(&(N)->next[L], __ATOMIC_ACQUIRE)
+
+__private __thread uint64_t SLSEED;
+
+__private int sl_cas(slNode_s* n, unsigned l, uintptr_t old, uintptr_t val){
+	return __atomic_compare_exchange_n(&n->next[l], &old, val, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+//xorshift for each thread, 2 bits for each level
+__private unsigned sl_random_level(void){
+	if( !SLSEED ) SLSEED = (ADDR(&SLSEED) * 0x9E3779B97F4A7C15ULL) | 1;
+	SLSEED ^= SLSEED << 13;
+	SLSEED ^= SLSEED >> 7;
+	SLSEED ^= SLSEED << 17;
+	const unsigned level = 1 + __builtin_ctzll(SLSEED | (1ULL << 63)) / 2;
+	return level > SKIPLIST_LEVEL_MAX ? SKIPLIST_LEVEL_MAX : level;
+}
+
+__private slNode_s* sl_node_new(void* data, unsigned level){
+	slNode_s* n = mem_alloc(sizeof(slNode_s) + sizeof(uintptr_t) * level, 0, 0, NULL, 0, NULL);
+	n->data  = data;
+	n->level = level;
+	n->refs  = 2;
+	return n;
+}
+
+__private void sl_node_unref(slNode_s* n){
+	if( !__atomic_sub_fetch(&n->refs, 1, __ATOMIC_ACQ_REL) ) epoch_retire(n, NULL);
+}
+
+//level only grow, search start from here and not from SKIPLIST_LEVEL_MAX
+__private void sl_level_raise(skiplist_t* sl, unsigned level){
+	unsigned cur = __atomic_load_n(&sl->level, __ATOMIC_RELAXED);
+	while( cur < level && !__atomic_compare_exchange_n(&sl->level, &cur, level, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED) );
+}
+
+/*** search ***/
+
+/* fill preds and succs of each level with last node < key and first node >= key, unlink marked node found in the walk
+ * return 1 if succs[0] is key
+ */
+__private int sl_search(skiplist_t* sl, const void* key, slNode_s** preds, slNode_s** succs){
+RETRY: ;
+	slNode_s* pred = sl->head;
+	for( int l = __atomic_load_n(&sl->level, __ATOMIC_ACQUIRE) - 1; l >= 0; --l ){
+		slNode_s* cur = sl_ptr(sl_next(pred, l));
+		while( cur ){
+			uintptr_t succ = sl_next(cur, l);
+			if( sl_marked(succ) ){
+				if( !sl_cas(pred, l, (uintptr_t)cur, succ & ~SL_MARK) ) goto RETRY;
+				cur = sl_ptr(succ);
+				continue;
+			}
+			if( sl->cmp(cur->data, key) >= 0 ) break;
+			pred = cur;
+			cur  = sl_ptr(succ);
+		}
+		preds[l] = pred;
+		succs[l] = cur;
+	}
+	return succs[0] && !sl->cmp(succs[0]->data, key);
+}
+
+/* read only walk, marked nodes are skipped and never unlinked, return first node >= key
+ * node where upper level stop is >= key and is not compared again in lower levels
+ */
+__private slNode_s* sl_lookup(skiplist_t* sl, const void* key){
+	slNode_s* pred  = sl->head;
+	slNode_s* cur   = NULL;
+	slNode_s* bound = NULL;
+	for( int l = __atomic_load_n(&sl->level, __ATOMIC_ACQUIRE) - 1; l >= 0; --l ){
+		cur = sl_ptr(sl_next(pred, l));
+		while( cur ){
+			const uintptr_t succ = sl_next(cur, l);
+			if( !sl_marked(succ) ){
+				if( cur == bound ) break;
+				__builtin_prefetch(sl_ptr(succ));
+				if( sl->cmp(cur->data, key) >= 0 ) break;
+				pred = cur;
+			}
+			cur = sl_ptr(succ);
+		}
+		bound = cur;
+	}
+	return cur;
+}
+
+//next node not removed at level 0
+__private slNode_s* sl_walk(slNode_s* n){
+	uintptr_t next = sl_next(n, 0);
+	slNode_s* cur;
+	while( (cur = sl_ptr(next)) && sl_marked(next = sl_next(cur, 0)) );
+	return cur;
+}
+
+/*** skiplist ***/
+
+//children are freed before cleanup, head is not gifted to list
+__private void sl_dtor(void* ctx){
+	skiplist_t* sl = ctx;
+	slNode_s* n = sl->head;
+	while( n ){
+		slNode_s* next = sl_ptr(n->next[0]);
+		mem_free(n);
+		n = next;
+	}
+}
+
+skiplist_t* skiplist_new(cmp_f fn){
+	skiplist_t* sl = NEW(skiplist_t);
+	sl->head  = sl_node_new(NULL, SKIPLIST_LEVEL_MAX);
+	sl->cmp   = fn;
+	sl->count = 0;
+	sl->level = 1;
+	for( unsigned l = 0; l < SKIPLIST_LEVEL_MAX; ++l ) sl->head->next[l] = 0;
+	mem_cleanup(sl, sl_dtor);
+	return sl;
+}
+
+//link upper levels of n, stop when n is removed, if remove happen while link is this to unlink
+__private void sl_link(skiplist_t* sl, slNode_s* n, slNode_s** preds, slNode_s** succs){
+	for( unsigned l = 1; l < n->level; ++l ){
+		forever(){
+			const uintptr_t next = sl_next(n, l);
+			if( sl_marked(next) ) goto END;
+			if( next != (uintptr_t)succs[l] && !sl_cas(n, l, next, (uintptr_t)succs[l]) ) continue;
+			if( sl_cas(preds[l], l, (uintptr_t)succs[l], (uintptr_t)n) ) break;
+			sl_search(sl, n->data, preds, succs);
+			if( succs[0] != n ) goto END;
+		}
+	}
+END:
+	if( sl_marked(sl_next(n, 0)) ) sl_search(sl, n->data, preds, succs);
+	sl_node_unref(n);
+}
+
+int skiplist_insert(skiplist_t* sl, void* data){
+	slNode_s* preds[SKIPLIST_LEVEL_MAX];
+	slNode_s* succs[SKIPLIST_LEVEL_MAX];
+	const unsigned level = sl_random_level();
+	slNode_s* n = NULL;
+	sl_level_raise(sl, level);
+
+	epoch_enter();
+	do{
+		if( sl_search(sl, data, preds, succs) ){
+			epoch_leave();
+			if( n ) mem_free(n);
+			errno = EEXIST;
+			return -1;
+		}
+		if( !n ) n = sl_node_new(data, level);
+		for( unsigned l = 0; l < level; ++l ) n->next[l] = (uintptr_t)succs[l];
+	}while( !sl_cas(preds[0], 0, (uintptr_t)succs[0], (uintptr_t)n) );
+	__atomic_add_fetch(&sl->count, 1, __ATOMIC_RELAXED);
+	sl_link(sl, n, preds, succs);
+	epoch_leave();
+	return 0;
+}
+
+void* skiplist_find(skiplist_t* sl, const void* key){
+	void* data = NULL;
+	epoch_enter();
+	slNode_s* n = sl_lookup(sl, key);
+	if( n && !sl->cmp(n->data, key) ) data = n->data;
+	epoch_leave();
+	return data;
+}
+
+void* skiplist_find_best(skiplist_t* sl, const void* key){
+	epoch_enter();
+	slNode_s* n = sl_lookup(sl, key);
+	void* data = n ? n->data : NULL;
+	epoch_leave();
+	return data;
+}
+
+void* skiplist_remove(skiplist_t* sl, const void* key){
+	slNode_s* preds[SKIPLIST_LEVEL_MAX];
+	slNode_s* succs[SKIPLIST_LEVEL_MAX];
+	void* data = NULL;
+
+	epoch_enter();
+	if( sl_search(sl, key, preds, succs) ){
+		slNode_s* n = succs[0];
+		for( unsigned l = n->level - 1; l > 0; --l ) __atomic_fetch_or(&n->next[l], SL_MARK, __ATOMIC_ACQ_REL);
+		if( !sl_marked(__atomic_fetch_or(&n->next[0], SL_MARK, __ATOMIC_ACQ_REL)) ){
+			data = n->data;
+			__atomic_sub_fetch(&sl->count, 1, __ATOMIC_RELAXED);
+			sl_search(sl, key, preds, succs);
+			sl_node_unref(n);
+		}
+	}
+	epoch_leave();
+	return data;
+}
+
+size_t skiplist_count(skiplist_t* sl){
+	return __atomic_load_n(&sl->count, __ATOMIC_RELAXED);
+}
+
+/*** iterator ***/
+
+__private void sl_iterator_dtor(__unused void* ctx){
+	epoch_leave();
+}
+
+__private skiplist_i* sl_iterator(unsigned count){
+	skiplist_i* it = NEW(skiplist_i);
+	epoch_enter();
+	mem_cleanup(it, sl_iterator_dtor);
+	it->cur   = NULL;
+	it->count = count ? count : UINT_MAX;
+	return it;
+}
+
+skiplist_i* skiplist_inorder_iterator(skiplist_t* sl, unsigned offset, unsigned count){
+	skiplist_i* it = sl_iterator(count);
+	it->cur = sl_walk(sl->head);
+	while( offset-- && it->cur ) it->cur = sl_walk(it->cur);
+	return it;
+}
+
+skiplist_i* skiplist_range_iterator(skiplist_t* sl, const void* key, unsigned count){
+	skiplist_i* it = sl_iterator(count);
+	it->cur = sl_lookup(sl, key);
+	return it;
+}
+
+void* skiplist_inorder_iterate(void* IT){
+	skiplist_i* it = IT;
+	slNode_s* n = it->cur;
+	if( !n || !it->count ) return NULL;
+	--it->count;
+	it->cur = sl_walk(n);
+	return n->data;
+}
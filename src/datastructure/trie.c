@@ -1,12 +1,16 @@
 #include <notstd/trie.h>
 #include <notstd/vector.h>
+#include <notstd/intern.h>
+#include <immintrin.h>
 
 #define TRIE_ENDNODES 2
+#define TRIE_LABELS_MIN 64
 
 typedef struct trieN trieN_s;
 
+//label is in intern pool of trie, equal labels share memory, pool is compacted when removed labels are too many
 typedef struct trieE{
-	char*  str;
+	const char* str;
 	unsigned len;
 	struct trieN* next;
 	void* data;
@@ -18,12 +22,501 @@ typedef struct trieN{
 
 struct trie{
 	trieN_s* root;
+	intern_t* labels;
+	uintptr_t art;
+	trieMode_e mode;
 	unsigned count;
+	unsigned edges;
 };
 
+/*** art ***/
+
+/* child is tagged pointer, bit 0 set is leaf with full key inline, leaf is placed at first byte that differ from other keys
+ * and node is created only when two keys share the slot, node store prefix shared from all keys under it,
+ * only first ART_PREFIX_MAX bytes are stored and the rest is checked on leaf, key that end inside node is in end leaf
+ */
+#define ART_PREFIX_MAX 8
+#define ART_LEAF       ((uintptr_t)1)
+#define art_isleaf(P)  ((P) & ART_LEAF)
+#define art_leaf(P)    ((artLeaf_s*)((P) & ~ART_LEAF))
+#define art_node(P)    ((artNode_s*)(P))
+#define art_min(A,B)   ((A) < (B) ? (A) : (B))
+
+typedef enum { ART_NODE4, ART_NODE16, ART_NODE48, ART_NODE256 } artType_e;
+
+typedef struct artLeaf{
+	void* data;
+	unsigned len;
+	char key[];
+}artLeaf_s;
+
+typedef struct artNode{
+	uint8_t type;
+	uint16_t count;
+	uint32_t plen;
+	uint8_t prefix[ART_PREFIX_MAX];
+	uintptr_t end;
+}artNode_s;
+
+//keys of node4 and node16 are sorted
+typedef struct artNode4{
+	artNode_s h;
+	uint8_t key[4];
+	uintptr_t child[4];
+}artNode4_s;
+
+typedef struct artNode16{
+	artNode_s h;
+	uint8_t key[16];
+	uintptr_t child[16];
+}artNode16_s;
+
+//index is position + 1 in child, 0 not exists
+typedef struct artNode48{
+	artNode_s h;
+	uint8_t index[256];
+	uintptr_t child[48];
+}artNode48_s;
+
+typedef struct artNode256{
+	artNode_s h;
+	uintptr_t child[256];
+}artNode256_s;
+
+__private const size_t ARTSIZE[] = { sizeof(artNode4_s), sizeof(artNode16_s), sizeof(artNode48_s), sizeof(artNode256_s) };
+__private const unsigned ARTMAX[] = { 4, 16, 48, 256 };
+
+__private artNode_s* art_node_new(artType_e type){
+	artNode_s* n = mem_alloc(ARTSIZE[type], 0, 0, NULL, 0, NULL);
+	memset(n, 0, ARTSIZE[type]);
+	n->type = type;
+	return n;
+}
+
+__private uintptr_t art_leaf_new(const char* key, unsigned len, void* data){
+	artLeaf_s* l = mem_alloc(sizeof(artLeaf_s) + len, 0, 0, NULL, 0, NULL);
+	l->data = data;
+	l->len  = len;
+	memcpy(l->key, key, len);
+	return (uintptr_t)l | ART_LEAF;
+}
+
+__private int art_leaf_match(uintptr_t p, const char* key, unsigned len){
+	const artLeaf_s* l = art_leaf(p);
+	return l->len == len && !memcmp(l->key, key, len);
+}
+
+__private void art_prefix_set(artNode_s* n, const char* str, unsigned len){
+	n->plen = len;
+	memcpy(n->prefix, str, art_min(len, ART_PREFIX_MAX));
+}
+
+//node4 and node16 have same layout of keys and children
+__private uintptr_t* art_sorted(artNode_s* n, uint8_t** key){
+	if( n->type == ART_NODE4 ){
+		*key = ((artNode4_s*)n)->key;
+		return ((artNode4_s*)n)->child;
+	}
+	*key = ((artNode16_s*)n)->key;
+	return ((artNode16_s*)n)->child;
+}
+
+__private uintptr_t* art_child(artNode_s* n, uint8_t b){
+	switch( n->type ){
+		case ART_NODE4:{
+			artNode4_s* n4 = (artNode4_s*)n;
+			for( unsigned i = 0; i < n->count; ++i ){
+				if( n4->key[i] == b ) return &n4->child[i];
+			}
+			return NULL;
+		}
+		case ART_NODE16:{
+			artNode16_s* n16 = (artNode16_s*)n;
+			const __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8(b), _mm_loadu_si128((const __m128i*)n16->key));
+			const unsigned m = _mm_movemask_epi8(cmp) & ((1U << n->count) - 1);
+			return m ? &n16->child[__builtin_ctz(m)] : NULL;
+		}
+		case ART_NODE48:{
+			artNode48_s* n48 = (artNode48_s*)n;
+			return n48->index[b] ? &n48->child[n48->index[b] - 1] : NULL;
+		}
+		default:{
+			artNode256_s* n256 = (artNode256_s*)n;
+			return n256->child[b] ? &n256->child[b] : NULL;
+		}
+	}
+}
+
+//children in byte order, return count
+__private unsigned art_children(artNode_s* n, uint8_t* keys, uintptr_t* child){
+	unsigned count = 0;
+	switch( n->type ){
+		case ART_NODE4: case ART_NODE16:{
+			uint8_t* k;
+			uintptr_t* c = art_sorted(n, &k);
+			memcpy(keys, k, n->count);
+			memcpy(child, c, n->count * sizeof(uintptr_t));
+			return n->count;
+		}
+		case ART_NODE48:{
+			artNode48_s* n48 = (artNode48_s*)n;
+			for( unsigned b = 0; b < 256; ++b ){
+				if( !n48->index[b] ) continue;
+				keys[count] = b;
+				child[count++] = n48->child[n48->index[b] - 1];
+			}
+			return count;
+		}
+		default:{
+			artNode256_s* n256 = (artNode256_s*)n;
+			for( unsigned b = 0; b < 256; ++b ){
+				if( !n256->child[b] ) continue;
+				keys[count] = b;
+				child[count++] = n256->child[b];
+			}
+			return count;
+		}
+	}
+}
+
+__private uintptr_t art_first(artNode_s* n){
+	switch( n->type ){
+		case ART_NODE4:   return ((artNode4_s*)n)->child[0];
+		case ART_NODE16:  return ((artNode16_s*)n)->child[0];
+		case ART_NODE48:{
+			artNode48_s* n48 = (artNode48_s*)n;
+			unsigned b = 0;
+			while( !n48->index[b] ) ++b;
+			return n48->child[n48->index[b] - 1];
+		}
+		default:{
+			artNode256_s* n256 = (artNode256_s*)n;
+			unsigned b = 0;
+			while( !n256->child[b] ) ++b;
+			return n256->child[b];
+		}
+	}
+}
+
+//any leaf under node has full prefix of node
+__private artLeaf_s* art_any_leaf(artNode_s* n){
+	forever(){
+		if( n->end ) return art_leaf(n->end);
+		const uintptr_t c = art_first(n);
+		if( art_isleaf(c) ) return art_leaf(c);
+		n = art_node(c);
+	}
+}
+
+//type change, header is same and children are copied in new layout
+__private artNode_s* art_resize(artNode_s* n, artType_e type){
+	uint8_t keys[256];
+	uintptr_t child[256];
+	const unsigned count = art_children(n, keys, child);
+	artNode_s* r = art_node_new(type);
+	memcpy(r, n, sizeof(artNode_s));
+	r->type = type;
+	switch( type ){
+		case ART_NODE4: case ART_NODE16:{
+			uint8_t* k;
+			uintptr_t* c = art_sorted(r, &k);
+			memcpy(k, keys, count);
+			memcpy(c, child, count * sizeof(uintptr_t));
+		}
+		break;
+		case ART_NODE48:{
+			artNode48_s* n48 = (artNode48_s*)r;
+			for( unsigned i = 0; i < count; ++i ){
+				n48->child[i] = child[i];
+				n48->index[keys[i]] = i + 1;
+			}
+		}
+		break;
+		case ART_NODE256:{
+			artNode256_s* n256 = (artNode256_s*)r;
+			for( unsigned i = 0; i < count; ++i ) n256->child[keys[i]] = child[i];
+		}
+		break;
+	}
+	mem_free(n);
+	return r;
+}
+
+//ref point to n and is changed when node grow
+__private void art_add_child(uintptr_t* ref, artNode_s* n, uint8_t b, uintptr_t child){
+	if( n->count == ARTMAX[n->type] ) *ref = (uintptr_t)(n = art_resize(n, n->type + 1));
+	switch( n->type ){
+		case ART_NODE4: case ART_NODE16:{
+			uint8_t* k;
+			uintptr_t* c = art_sorted(n, &k);
+			unsigned i = 0;
+			while( i < n->count && k[i] < b ) ++i;
+			memmove(&k[i+1], &k[i], n->count - i);
+			memmove(&c[i+1], &c[i], (n->count - i) * sizeof(uintptr_t));
+			k[i] = b;
+			c[i] = child;
+		}
+		break;
+		case ART_NODE48:{
+			artNode48_s* n48 = (artNode48_s*)n;
+			unsigned i = 0;
+			while( n48->child[i] ) ++i;
+			n48->child[i] = child;
+			n48->index[b] = i + 1;
+		}
+		break;
+		case ART_NODE256:
+			((artNode256_s*)n)->child[b] = child;
+		break;
+	}
+	++n->count;
+}
+
+//leaf of key go to end of node when key end at depth
+__private void art_put(uintptr_t* ref, artNode_s* n, const char* key, unsigned len, unsigned depth, uintptr_t leaf){
+	if( depth == len ) n->end = leaf;
+	else art_add_child(ref, n, key[depth], leaf);
+}
+
+//node4 with only one element is replaced from element, child node get prefix of node and byte of child
+__private void art_collapse(uintptr_t* ref, artNode_s* n){
+	artNode4_s* n4 = (artNode4_s*)n;
+	if( n->end ){
+		*ref = n->end;
+	}
+	else if( art_isleaf(n4->child[0]) ){
+		*ref = n4->child[0];
+	}
+	else{
+		artNode_s* c = art_node(n4->child[0]);
+		uint8_t prefix[ART_PREFIX_MAX * 2 + 1] = {0};
+		unsigned i = art_min(n->plen, ART_PREFIX_MAX);
+		memcpy(prefix, n->prefix, i);
+		prefix[i++] = n4->key[0];
+		memcpy(&prefix[i], c->prefix, art_min(c->plen, ART_PREFIX_MAX));
+		memcpy(c->prefix, prefix, ART_PREFIX_MAX);
+		c->plen += n->plen + 1;
+		*ref = (uintptr_t)c;
+	}
+	mem_free(n);
+}
+
+__private void art_shrink(uintptr_t* ref, artNode_s* n){
+	switch( n->type ){
+		case ART_NODE4:   if( n->count + !!n->end < 2 ) art_collapse(ref, n); break;
+		case ART_NODE16:  if( n->count <= 3 ) *ref = (uintptr_t)art_resize(n, ART_NODE4); break;
+		case ART_NODE48:  if( n->count <= 12 ) *ref = (uintptr_t)art_resize(n, ART_NODE16); break;
+		case ART_NODE256: if( n->count <= 37 ) *ref = (uintptr_t)art_resize(n, ART_NODE48); break;
+	}
+}
+
+__private void art_remove_child(uintptr_t* ref, artNode_s* n, uint8_t b, uintptr_t* child){
+	switch( n->type ){
+		case ART_NODE4: case ART_NODE16:{
+			uint8_t* k;
+			uintptr_t* c = art_sorted(n, &k);
+			const unsigned i = child - c;
+			memmove(&k[i], &k[i+1], n->count - i - 1);
+			memmove(&c[i], &c[i+1], (n->count - i - 1) * sizeof(uintptr_t));
+		}
+		break;
+		case ART_NODE48:
+			((artNode48_s*)n)->index[b] = 0;
+			*child = 0;
+		break;
+		case ART_NODE256:
+			*child = 0;
+		break;
+	}
+	--n->count;
+	art_shrink(ref, n);
+}
+
+//first byte of prefix not equal to key, bytes over ART_PREFIX_MAX are read from leaf
+__private unsigned art_prefix_mismatch(artNode_s* n, const char* key, unsigned len, unsigned depth){
+	const unsigned max = art_min(n->plen, len - depth);
+	const unsigned stored = art_min(max, ART_PREFIX_MAX);
+	unsigned i = 0;
+	for(; i < stored; ++i ){
+		if( n->prefix[i] != (uint8_t)key[depth + i] ) return i;
+	}
+	if( max > ART_PREFIX_MAX ){
+		const artLeaf_s* l = art_any_leaf(n);
+		for(; i < max; ++i ){
+			if( l->key[depth + i] != key[depth + i] ) return i;
+		}
+	}
+	return i;
+}
+
+//return 1 if key is added, 0 if data is replaced
+__private int art_insert(uintptr_t* ref, const char* key, unsigned len, void* data){
+	unsigned depth = 0;
+	forever(){
+		const uintptr_t p = *ref;
+		if( !p ){
+			*ref = art_leaf_new(key, len, data);
+			return 1;
+		}
+
+		if( art_isleaf(p) ){
+			artLeaf_s* l = art_leaf(p);
+			if( art_leaf_match(p, key, len) ){
+				l->data = data;
+				return 0;
+			}
+			dbg_info("expand leaf %.*s", l->len, l->key);
+			const unsigned max = art_min(l->len, len);
+			unsigned lcp = depth;
+			while( lcp < max && l->key[lcp] == key[lcp] ) ++lcp;
+			artNode_s* n = art_node_new(ART_NODE4);
+			art_prefix_set(n, &key[depth], lcp - depth);
+			*ref = (uintptr_t)n;
+			art_put(ref, n, l->key, l->len, lcp, p);
+			art_put(ref, n, key, len, lcp, art_leaf_new(key, len, data));
+			return 1;
+		}
+
+		artNode_s* n = art_node(p);
+		if( n->plen ){
+			const unsigned im = art_prefix_mismatch(n, key, len, depth);
+			if( im < n->plen ){
+				dbg_info("split prefix at %u", im);
+				artNode_s* s = art_node_new(ART_NODE4);
+				art_prefix_set(s, &key[depth], im);
+				uint8_t b;
+				if( n->plen <= ART_PREFIX_MAX ){
+					b = n->prefix[im];
+					n->plen -= im + 1;
+					memmove(n->prefix, &n->prefix[im + 1], n->plen);
+				}
+				else{
+					const artLeaf_s* l = art_any_leaf(n);
+					b = l->key[depth + im];
+					n->plen -= im + 1;
+					memcpy(n->prefix, &l->key[depth + im + 1], art_min(n->plen, ART_PREFIX_MAX));
+				}
+				*ref = (uintptr_t)s;
+				art_add_child(ref, s, b, p);
+				art_put(ref, s, key, len, depth + im, art_leaf_new(key, len, data));
+				return 1;
+			}
+			depth += n->plen;
+		}
+
+		if( depth == len ){
+			if( n->end ){
+				art_leaf(n->end)->data = data;
+				return 0;
+			}
+			n->end = art_leaf_new(key, len, data);
+			return 1;
+		}
+
+		uintptr_t* c = art_child(n, key[depth]);
+		if( !c ){
+			art_add_child(ref, n, key[depth], art_leaf_new(key, len, data));
+			return 1;
+		}
+		ref = c;
+		++depth;
+	}
+}
+
+//only stored prefix is compared, leaf check full key
+__private void* art_find(uintptr_t p, const char* key, unsigned len){
+	unsigned depth = 0;
+	while( p ){
+		if( art_isleaf(p) ) return art_leaf_match(p, key, len) ? art_leaf(p)->data : NULL;
+		artNode_s* n = art_node(p);
+		if( n->plen ){
+			if( depth + n->plen > len ) return NULL;
+			if( memcmp(n->prefix, &key[depth], art_min(n->plen, ART_PREFIX_MAX)) ) return NULL;
+			depth += n->plen;
+		}
+		if( depth == len ){
+			p = n->end;
+		}
+		else{
+			const uintptr_t* c = art_child(n, key[depth++]);
+			p = c ? *c : 0;
+		}
+	}
+	return NULL;
+}
+
+__private int art_remove(uintptr_t* ref, const char* key, unsigned len){
+	unsigned depth = 0;
+	forever(){
+		const uintptr_t p = *ref;
+		if( !p ) return -1;
+		if( art_isleaf(p) ){
+			if( !art_leaf_match(p, key, len) ) return -1;
+			mem_free(art_leaf(p));
+			*ref = 0;
+			return 0;
+		}
+
+		artNode_s* n = art_node(p);
+		if( n->plen ){
+			if( depth + n->plen > len ) return -1;
+			if( memcmp(n->prefix, &key[depth], art_min(n->plen, ART_PREFIX_MAX)) ) return -1;
+			depth += n->plen;
+		}
+
+		if( depth == len ){
+			if( !n->end || !art_leaf_match(n->end, key, len) ) return -1;
+			mem_free(art_leaf(n->end));
+			n->end = 0;
+			art_shrink(ref, n);
+			return 0;
+		}
+
+		uintptr_t* c = art_child(n, key[depth]);
+		if( !c ) return -1;
+		if( art_isleaf(*c) ){
+			if( !art_leaf_match(*c, key, len) ) return -1;
+			mem_free(art_leaf(*c));
+			art_remove_child(ref, n, key[depth], c);
+			return 0;
+		}
+		ref = c;
+		++depth;
+	}
+}
+
+__private void art_free(uintptr_t p){
+	if( !p ) return;
+	if( art_isleaf(p) ){
+		mem_free(art_leaf(p));
+		return;
+	}
+	artNode_s* n = art_node(p);
+	art_free(n->end);
+	switch( n->type ){
+		case ART_NODE4:   for( unsigned i = 0; i < n->count; ++i ) art_free(((artNode4_s*)n)->child[i]); break;
+		case ART_NODE16:  for( unsigned i = 0; i < n->count; ++i ) art_free(((artNode16_s*)n)->child[i]); break;
+		case ART_NODE48:  for( unsigned i = 0; i < 48; ++i ) art_free(((artNode48_s*)n)->child[i]); break;
+		case ART_NODE256: for( unsigned i = 0; i < 256; ++i ) art_free(((artNode256_s*)n)->child[i]); break;
+	}
+	mem_free(n);
+}
+
+__private void art_dtor(void* ctx){
+	art_free(((trie_t*)ctx)->art);
+}
+
+/*** edge ***/
+
+//vector grow with realloc, can't be gift to node
+__private void tn_dtor(void* tn){
+	mem_free(((trieN_s*)tn)->ve);
+}
+
 __private trieN_s* tn_new(trie_t* tr){
 	trieN_s* tn = mem_gift(NEW(trieN_s), tr);
-	tn->ve = mem_gift(VECTOR(trieE_s, TRIE_ENDNODES), tn);
+	tn->ve = VECTOR(trieE_s, TRIE_ENDNODES);
+	mem_cleanup(tn, tn_dtor);
 	return tn;
 }
 
@@ -31,22 +524,59 @@ __private void tn_free(trie_t* t, trieN_s* n){
 	mem_free(mem_give(n, t));
 }
 
-__private void tn_endpoint_add(trieN_s* n, const char* str, unsigned len, void* data, trieN_s* next){
+__private void tn_endpoint_add(trie_t* tr, trieN_s* n, const char* str, unsigned len, void* data, trieN_s* next){
 	trieE_s* e = vector_push(&n->ve, NULL);
 	e->next = next;
 	e->data = data;
 	e->len = len;
-	e->str = mem_gift(MANY(char, e->len+1), n);
-	memcpy(e->str, str, e->len);
-	e->str[e->len] = 0;
+	e->str = intern_add(tr->labels, str, len);
+	++tr->edges;
 }
 
-trie_t* trie_new(void){
+__private void tn_relabel(intern_t* pool, trieN_s* n){
+	foreach_vector(n->ve, i){
+		n->ve[i].str = intern_add(pool, n->ve[i].str, n->ve[i].len);
+		if( n->ve[i].next ) tn_relabel(pool, n->ve[i].next);
+	}
+}
+
+//pool can't release single label, each edge use one label then when pool have more than twice labels of edges
+//at least half is garbage, rebuild pool with only live labels, cost is amortized by removed labels
+__private void labels_compact(trie_t* tr){
+	if( intern_count(tr->labels) < TRIE_LABELS_MIN + tr->edges * 2ULL ) return;
+	dbg_info("compact labels %zu edges %u", intern_count(tr->labels), tr->edges);
+	intern_t* pool = mem_gift(intern_new(), tr);
+	tn_relabel(pool, tr->root);
+	mem_free(mem_give(tr->labels, tr));
+	tr->labels = pool;
+}
+
+trie_t* trie_new_mode(trieMode_e mode){
 	trie_t* tr = NEW(trie_t);
-	tr->root = tn_new(tr);
+	tr->mode  = mode;
+	tr->count = 0;
+	tr->edges = 0;
+	tr->art   = 0;
+	if( mode == TRIE_ART ){
+		tr->labels = NULL;
+		tr->root   = NULL;
+		mem_cleanup(tr, art_dtor);
+	}
+	else{
+		tr->labels = mem_gift(intern_new(), tr);
+		tr->root   = tn_new(tr);
+	}
 	return tr;
 }
 
+trie_t* trie_new(void){
+	return trie_new_mode(TRIE_EDGE);
+}
+
+trieMode_e trie_mode(trie_t* tr){
+	return tr->mode;
+}
+
 __private int stricmp(const char* a, const char* b){
 	int i = 0;
 	for(; a[i] && b[i] && a[i] == b[i]; ++i );
@@ -63,24 +593,30 @@ __private trieE_s* e_find(trieN_s* n, const char* s, __out unsigned* im, __out u
 	return NULL;
 }
 
-__private void e_split(trie_t* tr, trieN_s* cn, trieE_s* e, unsigned im, const char* s, unsigned len, void* data){
+__private void e_split(trie_t* tr, trieE_s* e, unsigned im, const char* s, unsigned len, void* data){
 	trieN_s* n = tn_new(tr);
 	dbg_info("split %s", e->str);
 	dbg_info("add to next node %*s", e->len-im, &e->str[im]);
-	tn_endpoint_add(n, &e->str[im], e->len-im, e->data, e->next);
-	dbg_info("add to next node %s", s);
-	tn_endpoint_add(n, s, len, data, NULL);
+	tn_endpoint_add(tr, n, &e->str[im], e->len-im, e->data, e->next);
+	//string end on split, data stay on splitted endpoint
+	if( len ){
+		dbg_info("add to next node %s", s);
+		tn_endpoint_add(tr, n, s, len, data, NULL);
+	}
 	e->next = n;
 	e->len = im;
-	e->str = mem_gift(RESIZE(char, mem_give(e->str, cn), e->len+1), cn);
-	e->str[e->len] = 0;
-	e->data = NULL;
+	e->str = intern_add(tr->labels, e->str, e->len);
+	e->data = len ? NULL : data;
 	dbg_info("splitted %s", e->str);
 }
 
 int trie_insert(trie_t* tr, const char* str, unsigned len, void* data){
 	if( !str || !*str ) return -1;
 	if( !len ) len = strlen(str);
+	if( tr->mode == TRIE_ART ){
+		tr->count += art_insert(&tr->art, str, len, data);
+		return 0;
+	}
 
 	trieN_s* n = tr->root;
 	while( len ){	
@@ -88,7 +624,7 @@ int trie_insert(trie_t* tr, const char* str, unsigned len, void* data){
 		trieE_s* e = e_find(n, str, &im, NULL);
 		if( !e ){
 			dbg_info("not find E, element not exists in this N, add and return");
-			tn_endpoint_add(n, str, len, data, NULL);
+			tn_endpoint_add(tr, n, str, len, data, NULL);
 			++tr->count;
 			return 0;
 		}
@@ -104,12 +640,13 @@ int trie_insert(trie_t* tr, const char* str, unsigned len, void* data){
 				e->data = data;
 				return 0;
 			}
-			e_split(tr, n, e, im, str, len, data);
+			e_split(tr, e, im, str, len, data);
+			++tr->count;
 			return 0;
 		}
 
 		if( im < e->len ){
-			e_split(tr, n, e, im, str, len, data);
+			e_split(tr, e, im, str, len, data);
 			++tr->count;
 			return 0;
 		}
@@ -117,7 +654,7 @@ int trie_insert(trie_t* tr, const char* str, unsigned len, void* data){
 		if( !e->next ){
 			dbg_info("string have more chars but no more node, create new node for remaning string and return");
 			e->next = tn_new(tr);
-			tn_endpoint_add(e->next, str, len, data, NULL);
+			tn_endpoint_add(tr, e->next, str, len, data, NULL);
 			++tr->count;
 			return 0;
 		}
@@ -132,6 +669,7 @@ int trie_insert(trie_t* tr, const char* str, unsigned len, void* data){
 void* trie_find(trie_t* tr, const char* str, unsigned len){
 	if( !str || !*str ) return NULL;
 	if( !len ) len = strlen(str);
+	if( tr->mode == TRIE_ART ) return art_find(tr->art, str, len);
 
 	trieN_s* n = tr->root;
 	trieE_s* e = NULL;
@@ -139,6 +677,7 @@ void* trie_find(trie_t* tr, const char* str, unsigned len){
 	do{	
 		unsigned im;
 		if( !(e = e_find(n, str, &im, NULL)) ) return NULL;
+		if( im != e->len ) return NULL;
 		iassert(im <= len);
 		len -= im;
 		str += im;
@@ -151,18 +690,21 @@ void* trie_find(trie_t* tr, const char* str, unsigned len){
 	return e->data;
 }
 
-__private void e_merge(trie_t* tr, trieN_s* n, trieE_s* e){
+__private void e_merge(trie_t* tr, trieE_s* e){
 	trieE_s* m = &e->next->ve[0];
 	dbg_info("merge %s++%s", e->str, m->str);
 
-	unsigned len = e->len;
+	__free char* cat = MANY(char, e->len + m->len + 1);
+	memcpy(cat, e->str, e->len);
+	memcpy(&cat[e->len], m->str, m->len);
 	e->len = e->len + m->len;
-	e->str = mem_gift(RESIZE(char, mem_give(e->str, n), e->len+1), n);
-	memcpy(&e->str[len], m->str, m->len);
-	e->str[e->len] = 0;
+	e->str = intern_add(tr->labels, cat, e->len);
 	e->data = m->data;
+	//m is inside vector of next, read before free
+	trieN_s* next = m->next;
 	tn_free(tr, e->next);
-	e->next = m->next;
+	e->next = next;
+	--tr->edges;
 }
 
 
@@ -183,13 +725,13 @@ __private int rm_rec(trie_t* tr, trieN_s* n, const char* str, unsigned len){
 	if( e->next && !vector_count(&e->next->ve) ){
 		dbg_info("next element is clear, destroy and remove current element");
 		tn_free(tr, e->next);
-		mem_free(mem_give(e->str, n));
 		vector_remove(&n->ve, it, 1);
+		--tr->edges;
 	}
 	else if( !e->next ){
 		dbg_info("not have next can free(%u) %s", it, e->str);
-		mem_free(mem_give(e->str, n));
 		vector_remove(&n->ve, it, 1);
+		--tr->edges;
 	}
 	else if( !len ){
 		if( e->data == NULL ) return -1;
@@ -198,7 +740,7 @@ __private int rm_rec(trie_t* tr, trieN_s* n, const char* str, unsigned len){
 	}
 	else if( e->next && vector_count(&e->next->ve) == 1 && !e->data ){
 		dbg_info("next have only one element, can merge");
-		e_merge(tr, n, e);
+		e_merge(tr, e);
 	}
 
 	
@@ -208,7 +750,14 @@ __private int rm_rec(trie_t* tr, trieN_s* n, const char* str, unsigned len){
 //ensure data exists before remove
 int trie_remove(trie_t* tr,  const char* str, unsigned len){
 	dbg_info("remove %s", str);
-	if( rm_rec(tr, tr->root, str, len ? len : strlen(str)) ) return -1;
+	if( !len ) len = strlen(str);
+	if( tr->mode == TRIE_ART ){
+		if( art_remove(&tr->art, str, len) ) return -1;
+	}
+	else{
+		if( rm_rec(tr, tr->root, str, len) ) return -1;
+		labels_compact(tr);
+	}
 	--tr->count;
 	return 0;
 }
@@ -227,22 +776,79 @@ __private void tn_dump(trieN_s* n, unsigned tab){
 	}
 }
 
+__private void art_dump(uintptr_t p, unsigned tab){
+	if( !p ) return;
+	pt(tab);
+	if( art_isleaf(p) ){
+		printf("%.*s*\n", art_leaf(p)->len, art_leaf(p)->key);
+		return;
+	}
+	uint8_t keys[256];
+	uintptr_t child[256];
+	artNode_s* n = art_node(p);
+	const unsigned count = art_children(n, keys, child);
+	printf("node%u(%u) %.*s%s\n", ARTMAX[n->type], count, art_min(n->plen, ART_PREFIX_MAX), n->prefix, n->plen > ART_PREFIX_MAX ? "..." : "");
+	art_dump(n->end, tab + 2);
+	for( unsigned i = 0; i < count; ++i ){
+		pt(tab + 2);
+		printf("%c\n", keys[i]);
+		art_dump(child[i], tab + 4);
+	}
+}
+
 void trie_dump(trie_t* tr){
-	tn_dump(tr->root, 0);
+	if( tr->mode == TRIE_ART ) art_dump(tr->art, 0);
+	else tn_dump(tr->root, 0);
 }
 
+//art use only stack of children, each element in stack has at least one leaf
 struct trieit{
 	unsigned count;
 	trieN_s** stk;
 	trieN_s*  cur;
 	unsigned  icur;
+	uintptr_t* art;
 };
 
+//node push children in reverse and end leaf at top, pop return keys in byte order
+__private void* art_iterate(trie_i* it){
+	uint8_t keys[256];
+	uintptr_t child[256];
+	uintptr_t p;
+	while( vector_pop(&it->art, &p) ){
+		if( art_isleaf(p) ){
+			--it->count;
+			return art_leaf(p)->data;
+		}
+		artNode_s* n = art_node(p);
+		unsigned count = art_children(n, keys, child);
+		while( count-->0 ) vector_push(&it->art, &child[count]);
+		if( n->end ) vector_push(&it->art, &n->end);
+	}
+	return NULL;
+}
+
+//pop shrink stack with realloc, can't be gift to iterator
+__private void trie_iterator_dtor(void* ctx){
+	trie_i* it = ctx;
+	if( it->stk ) mem_free(it->stk);
+	if( it->art ) mem_free(it->art);
+}
+
 trie_i* trie_iterator(trie_t* tr, unsigned off, unsigned count){
 	trie_i* it = NEW(trie_i);
 	if( !count ) count = tr->count;
 	if( count > tr->count ) count = tr->count;
-	it->stk = mem_gift(VECTOR(trieN_s*, tr->count+1), it);
+	it->stk = NULL;
+	it->art = NULL;
+	if( tr->mode == TRIE_ART ){
+		it->art = VECTOR(uintptr_t, tr->count+1);
+		if( tr->art ) vector_push(&it->art, &tr->art);
+	}
+	else{
+		it->stk = VECTOR(trieN_s*, tr->count+1);
+	}
+	mem_cleanup(it, trie_iterator_dtor);
 	it->cur = tr->root;
 	it->icur = 0;
 	it->count = tr->count+1;
@@ -255,6 +861,7 @@ void* trie_iterate(void* IT){
 	trie_i* it = IT;
 	void* ret = NULL;
 	if( !it->count ) return NULL;
+	if( it->art ) return art_iterate(it);
 
 	while( !ret ){
 		if( it->icur >= vector_count(&it->icur) ){
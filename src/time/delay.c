@@ -8,6 +8,16 @@
 #include <time.h>
 #include <sys/time.h>
 #include <sys/sysinfo.h>
+#include <cpuid.h>
+
+__private struct{
+	uint64_t tsc0;      /**< tsc at startup*/
+	delay_t ns0;        /**< monotonic ns at startup*/
+	uint64_t hz;        /**< tsc frequency*/
+	uint64_t mult;      /**< ns = (cycles * mult) >> 32*/
+	int invariant;      /**< tsc invariant*/
+	pthread_once_t once;
+}TSC = { .once = PTHREAD_ONCE_INIT };
 
 delay_t time_ms(void){
 	struct timespec ts; 
@@ -51,66 +61,190 @@ double time_sec(void){
     return ts.tv_sec + ts.tv_nsec*1e-9;
 }
 
-__private void timespec_ms(struct timespec* tv, uint64_t ms){
-	tv->tv_sec = (time_t) ms / 1000;
-	tv->tv_nsec = (long) ((ms - (tv->tv_sec * 1000)) * 1000000L);
+delay_t time_mono_ms(void){
+	struct timespec ts; 
+	clock_gettime(CLOCK_MONOTONIC, &ts); 
+    return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000ULL;
 }
 
-__private void timespec_us(struct timespec* tv, uint64_t us){
-	tv->tv_sec = (time_t) us / 1000000L;
-	tv->tv_nsec = (long) ((us - (tv->tv_sec * 1000000L)) * 1000L);
+delay_t time_mono_us(void){
+	struct timespec ts; 
+	clock_gettime(CLOCK_MONOTONIC, &ts); 
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000ULL;
 }
 
-__private void timespec_ns(struct timespec* tv, uint64_t us){
-	tv->tv_sec = (time_t) us / 1000000000L;
-	tv->tv_nsec = (long)(us - (tv->tv_sec * 1000000000L));
+delay_t time_mono_ns(void){
+	struct timespec ts; 
+	clock_gettime(CLOCK_MONOTONIC, &ts); 
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
 }
 
-__private void timespec_sec(struct timespec* tv, double s){
-	tv->tv_sec = (time_t) s;
-	tv->tv_nsec = (long) ((s - tv->tv_sec) * 1e+9);
+void time_begin(void){
+	unsigned eax, ebx, ecx, edx;
+	TSC.invariant = 0;
+	if( __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) ) TSC.invariant = (edx >> 8) & 1;
+	TSC.hz = 0;
+	//crystal clock ratio, not all cpu report crystal frequency
+	if( __get_cpuid_max(0, NULL) >= 0x15 && __get_cpuid(0x15, &eax, &ebx, &ecx, &edx) && eax && ebx && ecx ){
+		TSC.hz = ((uint64_t)ecx * ebx) / eax;
+	}
+	TSC.ns0  = time_mono_ns();
+	TSC.tsc0 = time_cycles();
 }
 
-__private void timespec_wait(struct timespec* tv, size_t(*gettime_f)(void), size_t time){
-	size_t start = gettime_f();
-	while (1){
-		int rval = nanosleep(tv, tv);
-		if( !rval ) return;
-		else if( errno == EINTR ) continue;
-		else{
-			while( gettime_f() - start < time );
-			return;
-		}
+__private void tsc_calibrate(void){
+	if( !TSC.hz ){
+		delay_t ns;
+		while( (ns = time_mono_ns() - TSC.ns0) < TIME_TSC_CALIBRATE_NS ) cpu_relax();
+		uint64_t cycles = time_cycles() - TSC.tsc0;
+		TSC.hz = (uint64_t)((double)cycles * 1e9 / (double)ns);
+		if( !TSC.hz ) TSC.hz = 1;
 	}
+	TSC.mult = ((uint64_t)1000000000 << 32) / TSC.hz;
 }
 
-void delay_ms(delay_t ms){
+int time_tsc_invariant(void){
+	return TSC.invariant;
+}
+
+uint64_t time_cycles_hz(void){
+	pthread_once(&TSC.once, tsc_calibrate);
+	return TSC.hz;
+}
+
+delay_t time_cycles_to_ns(uint64_t cycles){
+	pthread_once(&TSC.once, tsc_calibrate);
+	return ((unsigned __int128)cycles * TSC.mult) >> 32;
+}
+
+delay_t time_cycles_ns(uint64_t cycles){
+	return TSC.ns0 + time_cycles_to_ns(cycles - TSC.tsc0);
+}
+
+void time_cycles_ns_batch(delay_t* ns, const uint64_t* cycles, size_t count){
+	pthread_once(&TSC.once, tsc_calibrate);
+	const uint64_t tsc0 = TSC.tsc0;
+	const delay_t ns0 = TSC.ns0;
+	const uint64_t mult = TSC.mult;
+	for( size_t i = 0; i < count; ++i ){
+		ns[i] = ns0 + (delay_t)(((unsigned __int128)(cycles[i] - tsc0) * mult) >> 32);
+	}
+}
+
+__private void timespec_ns(struct timespec* tv, uint64_t us){
+	tv->tv_sec = (time_t) us / 1000000000L;
+	tv->tv_nsec = (long)(us - (tv->tv_sec * 1000000000L));
+}
+
+//absolute deadline, EINTR restart with same deadline without drift
+__private void timespec_wait(delay_t deadline){
 	struct timespec tv;
-	timespec_ms(&tv, ms);
-	timespec_wait(&tv, time_ms, ms);
+	timespec_ns(&tv, deadline);
+	while( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tv, NULL) == EINTR );
+}
+
+void delay_ms(delay_t ms){
+	timespec_wait(time_mono_ns() + MSTONS(ms));
 }
 
 void delay_us(delay_t us){
-	struct timespec tv;
-	timespec_us(&tv, us);
-	timespec_wait(&tv, time_us, us);
+	timespec_wait(time_mono_ns() + USTONS(us));
 }
 
 void delay_ns(delay_t ns){
-	struct timespec tv;
-	timespec_ns(&tv, ns);
-	timespec_wait(&tv, time_ns, ns);
+	timespec_wait(time_mono_ns() + ns);
 }
 
 void delay_sec(double s){
-	struct timespec tv;
-	timespec_sec(&tv, s);
-	timespec_wait(&tv, time_us, s * 1000000.0);
+	timespec_wait(time_mono_ns() + (delay_t)(s * 1e9));
 }
 
 void delay_hard(delay_t us){
-	uint32_t t = time_us();
-	while( time_us() - t < us );
+	delay_t t = time_mono_us();
+	while( time_mono_us() - t < us ) cpu_relax();
+}
+
+//spin window for each thread, follow wakeup latency of clock_nanosleep
+__private __thread delay_t SPINNS = DELAY_SPIN_NS;
+
+void delay_until(delay_t deadline){
+	delay_t now = time_mono_ns();
+	if( deadline <= now ) return;
+	if( deadline - now > SPINNS ){
+		const delay_t target = deadline - SPINNS;
+		timespec_wait(target);
+		delay_t late = (time_mono_ns() - target) * 2;
+		if( late < DELAY_SPIN_MIN ) late = DELAY_SPIN_MIN;
+		if( late > DELAY_SPIN_MAX ) late = DELAY_SPIN_MAX;
+		SPINNS = (SPINNS * 7 + late) / 8;
+	}
+	if( TSC.invariant ){
+		//anchor on current time, calibration error is scaled only on spin window
+		pthread_once(&TSC.once, tsc_calibrate);
+		const uint64_t c0 = time_cycles();
+		now = time_mono_ns();
+		if( deadline > now ){
+			const uint64_t cdeadline = c0 + ((unsigned __int128)(deadline - now) * TSC.hz) / 1000000000UL;
+			while( time_cycles() < cdeadline ) cpu_relax();
+		}
+	}
+	//never return before deadline, on tsc path is only a last check
+	while( time_mono_ns() < deadline ) cpu_relax();
+}
+
+void delay_precise(delay_t ns){
+	delay_until(time_mono_ns() + ns);
 }
 
+struct pacer{
+	delay_t start;
+	double period;
+	uint64_t count;
+};
+
+//rate must be finite and positive and period must be finite, otherwise slot is nan or never arrive
+__private int pacer_period(double rate, double* period){
+	if( !isfinite(rate) || rate <= 0.0 || !isfinite(1e9 / rate) ){
+		errno = EINVAL;
+		return -1;
+	}
+	*period = 1e9 / rate;
+	return 0;
+}
 
+pacer_t* pacer_new(double rate){
+	double period;
+	if( pacer_period(rate, &period) ) return NULL;
+	pacer_t* p = NEW(pacer_t);
+	p->period = period;
+	pacer_reset(p);
+	return p;
+}
+
+void pacer_reset(pacer_t* p){
+	p->start = time_mono_ns();
+	p->count = 0;
+}
+
+int pacer_rate(pacer_t* p, double rate){
+	double period;
+	if( pacer_period(rate, &period) ) return -1;
+	//restart schedule from current slot
+	p->start += (delay_t)(p->count * p->period);
+	p->count = 0;
+	p->period = period;
+	return 0;
+}
+
+delay_t pacer_wait(pacer_t* p){
+	//slot is always computed from start, rounding never accumulate
+	const delay_t slot = p->start + (delay_t)(++p->count * p->period);
+	const delay_t now = time_mono_ns();
+	if( now >= slot ) return now - slot;
+	delay_until(slot);
+	return 0;
+}
+
+uint64_t pacer_count(pacer_t* p){
+	return p->count;
+}
@@ -0,0 +1,110 @@
+#include <notstd/map.h>
+#include <notstd/btree.h>
+#include <notstd/mth.h>
+
+#define N 20000
+
+__private int u64cmp(const void* a, const void* b){
+	const uint64_t ua = *(const uint64_t*)a;
+	const uint64_t ub = *(const uint64_t*)b;
+	return (ua > ub) - (ua < ub);
+}
+
+//odd multiplier is a bijection on 32 bit, keys are unique and unordered
+__private uint64_t key_of(unsigned i){
+	return (uint32_t)(i * 2654435761U) * 2ULL;
+}
+
+//all elements are ordered, count match and data are of key
+__private void btree_check(btree_t* t, size_t count){
+	if( btree_count(t) != count ) die("wrong count %zu != %zu", btree_count(t), count);
+	uint64_t prev = 0;
+	size_t n = 0;
+	btreeEntry_s* e;
+	foreach(btree_inorder, t, e, 0, 0){
+		const uint64_t k = *(const uint64_t*)e->key;
+		if( n && k <= prev ) die("not ordered %lu <= %lu", k, prev);
+		if( (uint64_t)e->data != k + 1 ) die("wrong data of key %lu", k);
+		prev = k;
+		++n;
+	}
+	if( n != count ) die("iterate %zu elements, expected %zu", n, count);
+}
+
+__private void btree_test(unsigned nodesize){
+	dbg_info("nodesize %u", nodesize);
+	__free btree_t* t = btree_new(sizeof(uint64_t), nodesize, u64cmp);
+
+	dbg_info("insert");
+	for( unsigned i = 0; i < N; ++i ){
+		const uint64_t k = key_of(i);
+		if( btree_insert(t, &k, (void*)(k+1)) ) die("insert fail %lu", k);
+	}
+	const uint64_t k0 = key_of(0);
+	if( !btree_insert(t, &k0, NULL) || errno != EEXIST ) die("insert duplicate");
+	btree_check(t, N);
+	dbg_info("depth %u", btree_depth(t));
+
+	dbg_info("search");
+	for( unsigned i = 0; i < N; ++i ){
+		const uint64_t k = key_of(i);
+		if( btree_find(t, &k) != (void*)(k+1) ) die("try find element %lu but not exists", k);
+		const uint64_t miss = k + 1;
+		if( btree_find(t, &miss) ) die("find element %lu not inserted", miss);
+		uint64_t best = 0;
+		if( btree_find_best(t, &miss, &best) && best <= k ) die("find best %lu of %lu", best, miss);
+	}
+	const uint64_t over = UINT64_MAX;
+	if( btree_find_best(t, &over, NULL) ) die("find best over max");
+
+	dbg_info("range");
+	const uint64_t from = key_of(N/2);
+	btreeEntry_s* e;
+	unsigned count = 0;
+	foreach(btree_inorder, t, e, 0, 0){
+		if( *(const uint64_t*)e->key >= from ) break;
+		++count;
+	}
+	unsigned range = 0;
+	foreach(btree_range, t, e, &from, 100){
+		if( !range && *(const uint64_t*)e->key != from ) die("range not start from key");
+		++range;
+	}
+	if( range != (N - count < 100 ? N - count : 100) ) die("range count %u", range);
+	__free btree_i* it = btree_inorder_iterator(t, count, 1);
+	if( *(const uint64_t*)((btreeEntry_s*)btree_inorder_iterate(it))->key != from ) die("iterator offset");
+	if( btree_inorder_iterate(it) ) die("iterator count");
+
+	dbg_info("delete");
+	for( unsigned i = 0; i < N; i += 2 ){
+		const uint64_t k = key_of(i);
+		if( btree_remove(t, &k) != (void*)(k+1) ) die("remove %lu", k);
+		if( btree_remove(t, &k) ) die("remove twice %lu", k);
+	}
+	btree_check(t, N/2);
+	for( unsigned i = 0; i < N; ++i ){
+		const uint64_t k = key_of(i);
+		void* d = btree_find(t, &k);
+		if( (i & 1) && d != (void*)(k+1) ) die("lost element %lu", k);
+		if( !(i & 1) && d ) die("find element but element is removed");
+	}
+	for( unsigned i = 1; i < N; i += 2 ){
+		const uint64_t k = key_of(i);
+		if( btree_remove(t, &k) != (void*)(k+1) ) die("remove %lu", k);
+	}
+	btree_check(t, 0);
+	if( btree_depth(t) ) die("empty tree have depth");
+
+	dbg_info("reuse");
+	for( unsigned i = 0; i < N; ++i ){
+		const uint64_t k = key_of(i);
+		btree_insert(t, &k, (void*)(k+1));
+	}
+	btree_check(t, N);
+}
+
+void uc_btree(){
+	btree_test(0);
+	btree_test(64);
+	btree_test(4096);
+}
@@ -1,7 +1,7 @@
 #include <notstd/core.h>
 
 #ifndef TEST_DATASTRUCTURE
-#define TEST_DATASTRUCTURE 0xFFFF
+#define TEST_DATASTRUCTURE 0x7FFFF
 #endif
 
 const unsigned MODE=TEST_DATASTRUCTURE;
@@ -20,6 +20,11 @@ void uc_dict(void);
 void uc_trie(void);
 void uc_lbuffer(void);
 void uc_bipbuffer(void);
+void uc_hash_quality(void);
+void uc_btree(void);
+void uc_skiplist(void);
+void uc_intern(void);
+void uc_generics(void);
 
 int main(){
 	if( MODE & 0x0001 ) uc_vector();
@@ -36,6 +41,11 @@ int main(){
 	if( MODE & 0x0800 ) uc_trie();
 	if( MODE & 0x1000 ) uc_lbuffer();
 	if( MODE & 0x2000 ) uc_bipbuffer();
+	if( MODE & 0x4000 ) uc_hash_quality();
+	if( MODE & 0x8000 ) uc_btree();
+	if( MODE & 0x10000 ) uc_skiplist();
+	if( MODE & 0x20000 ) uc_intern();
+	if( MODE & 0x40000 ) uc_generics();
 
 	return 0;
 }
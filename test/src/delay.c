@@ -23,7 +23,8 @@ int uc_delay(){
 	start = time_ns();
 	delay_ns(USTONS(t));
 	end   = time_ns();
-	dbg_info("\tdelay: %lu jitter: %lu", end-start, (end-start)-USTONS(t));
+	dbg_info("\tdelay: %lu jitter: %ld", end-start, (long)(end-start)-(long)USTONS(t));
+	if( end-start < USTONS(t) ) die("precise delay wake up before deadline");
 	
 	t=500;
 	dbg_info("ns delay %luns", t);
@@ -70,7 +71,94 @@ int uc_delay(){
 	return 0;
 }
 
+#define NCLOCK 100000
+
+int uc_clock(){
+	dbg_info("tsc invariant:%d hz:%lu", time_tsc_invariant(), time_cycles_hz());
+
+	delay_t start = time_mono_ns();
+	uint64_t cs = time_cycles();
+	delay_ms(50);
+	uint64_t ce = time_cycles();
+	delay_t end = time_mono_ns();
+	dbg_info("monotonic 50ms: %luns cycles: %lu -> %luns", end-start, ce-cs, time_cycles_to_ns(ce-cs));
+	delay_t diff = time_cycles_ns(ce) > end ? time_cycles_ns(ce) - end : end - time_cycles_ns(ce);
+	if( diff > MSTONS(1) ) die("cycles timeline drift from monotonic %luns", diff);
+
+	__free uint64_t* trace = MANY(uint64_t, NCLOCK);
+	uint64_t c0 = time_cycles();
+	for( unsigned i = 0; i < NCLOCK; ++i ) trace[i] = time_cycles();
+	uint64_t c1 = time_cycles();
+	for( unsigned i = 0; i < NCLOCK; ++i ) trace[i] = time_ns();
+	uint64_t c2 = time_cycles();
+	for( unsigned i = 0; i < NCLOCK; ++i ) trace[i] = time_mono_ns();
+	uint64_t c3 = time_cycles();
+	dbg_info("cost for read: cycles %lu, realtime %lu, monotonic %lu", (c1-c0)/NCLOCK, (c2-c1)/NCLOCK, (c3-c2)/NCLOCK);
+
+	for( unsigned i = 0; i < NCLOCK; ++i ) trace[i] = time_cycles();
+	__free delay_t* single = MANY(delay_t, NCLOCK);
+	for( unsigned i = 0; i < NCLOCK; ++i ) single[i] = time_cycles_ns(trace[i]);
+	time_cycles_ns_batch(trace, trace, NCLOCK);
+	for( unsigned i = 0; i < NCLOCK; ++i ){
+		if( trace[i] != single[i] ) die("batch timestamp %lu differ from single %lu at %u", trace[i], single[i], i);
+		if( i && trace[i] < trace[i-1] ) die("batch timestamp not monotonic at %u", i);
+	}
+	//far from startup double lost ns, fixed point must stay exact
+	uint64_t far = time_cycles() + time_cycles_hz() * 86400 * 365;
+	delay_t fns;
+	time_cycles_ns_batch(&fns, &far, 1);
+	if( fns != time_cycles_ns(far) ) die("batch far timestamp %lu differ from single %lu", fns, time_cycles_ns(far));
+	return 0;
+}
+
+#define PACER_RATE 20000.0
+#define PACER_N    20000
+
+int uc_pacer(){
+	delay_t t = 150;
+	dbg_info("precise delay %luus", t);
+	delay_t start = time_mono_ns();
+	delay_precise(USTONS(t));
+	delay_t end = time_mono_ns();
+	dbg_info("\tdelay: %lu jitter: %ld", end-start, (long)(end-start)-(long)USTONS(t));
+	if( end-start < USTONS(t) ) die("precise delay wake up before deadline");
+
+	__free pacer_t* p = pacer_new(PACER_RATE);
+	delay_t maxlate = 0;
+	start = time_mono_ns();
+	delay_t cpu = time_cpu_ns();
+	for( unsigned i = 0; i < PACER_N; ++i ){
+		delay_t late = pacer_wait(p);
+		if( late > maxlate ) maxlate = late;
+	}
+	end = time_mono_ns();
+	cpu = time_cpu_ns() - cpu;
+	const delay_t expected = (delay_t)(PACER_N * (1e9 / PACER_RATE));
+	dbg_info("pacer %u events at %.0f/s: %luns expected %luns drift %ldns maxlate %luns cpu %.1f%%",
+		PACER_N, PACER_RATE, end-start, expected, (long)(end-start)-(long)expected, maxlate, cpu * 100.0 / (end-start)
+	);
+	if( pacer_count(p) != PACER_N ) die("pacer count");
+
+	const double bad[] = { 0.0, -1.0, NAN, INFINITY, -INFINITY, 1e-310 };
+	for( unsigned i = 0; i < sizeof bad / sizeof bad[0]; ++i ){
+		errno = 0;
+		if( pacer_new(bad[i]) || errno != EINVAL ) die("pacer_new accept rate %g", bad[i]);
+		errno = 0;
+		if( pacer_rate(p, bad[i]) != -1 || errno != EINVAL ) die("pacer_rate accept rate %g", bad[i]);
+	}
+	//old rate is kept, next slot is at 1/PACER_RATE
+	start = time_mono_ns();
+	pacer_reset(p);
+	pacer_wait(p);
+	end = time_mono_ns();
+	if( end - start < (delay_t)(1e9 / PACER_RATE) ) die("pacer rate changed by invalid rate");
+	if( pacer_rate(p, PACER_RATE * 2) ) die("pacer_rate reject valid rate");
+	return 0;
+}
+
 int main(){
+	uc_clock();
+	uc_pacer();
 	uc_delay();
 	return 0;
 }
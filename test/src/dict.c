@@ -10,6 +10,63 @@ __private int pair(void* KV, __unused void* arg){
 	return 0;
 }
 
+#define DICT_HASH_KEYS 5000
+
+//keys are written in same buffer, dict need to own own copy
+__private void dict_hash_test(void){
+	__free dict_t* d = dict_new_mode(DICT_HASH);
+	if( dict_mode(d) != DICT_HASH ) die("dict mode");
+	char key[32];
+	for( long i = 0; i < DICT_HASH_KEYS; ++i ){
+		sprintf(key, "key%ld", i);
+		*dict(d, (const char*)key) = GI(i);
+		*dict(d, i) = GI(-i);
+	}
+	if( dict_count(d) != DICT_HASH_KEYS * 2 ) die("dict hash count %lu", dict_count(d));
+	for( long i = 0; i < DICT_HASH_KEYS; i += 2 ){
+		sprintf(key, "key%ld", i);
+		if( dictrm(d, (const char*)key) ) die("dict hash remove %s", key);
+		if( !dictrm(d, (const char*)key) || errno != ESRCH ) die("dict hash remove twice %s", key);
+		if( dictrm(d, i) ) die("dict hash remove %ld", i);
+	}
+	if( dict_count(d) != DICT_HASH_KEYS ) die("dict hash count after remove %lu", dict_count(d));
+	//grow after remove reuse compacted entries
+	for( long i = DICT_HASH_KEYS; i < DICT_HASH_KEYS * 2; ++i ) *dict(d, i) = GI(-i);
+	for( long i = 0; i < DICT_HASH_KEYS; ++i ){
+		sprintf(key, "key%ld", i);
+		generic_s* v = dict(d, (const char*)key);
+		if( (i & 1) ? v->type != G_LONG || v->l != i : v->type != G_UNSET ) die("dict hash find %s", key);
+		if( !(i & 1) ) dictrm(d, (const char*)key);
+	}
+	long prev = -1;
+	dictPair_s* kv;
+	foreach(dict, d, kv, 0, 0){
+		if( kv->key.type != G_LONG ) continue;
+		if( kv->key.l <= prev ) die("dict hash not in insertion order");
+		if( kv->value.l != -kv->key.l ) die("dict hash value of %ld", kv->key.l);
+		prev = kv->key.l;
+	}
+
+	dictPair_s pairs[] = { { GI("b"), GI(2) }, { GI(1), GI("one") }, { GI("a"), GI(1) } };
+	__free dict_t* l = dict_new_mode(DICT_HASH);
+	if( dict_load(l, pairs, sizeof_vector(pairs)) ) die("dict hash load");
+	if( dict(l, "a")->l != 1 || dict(l, 1)->type != G_STRING || dict_count(l) != 3 ) die("dict hash load value");
+	dictPair_s dup[] = { { GI("a"), GI(1) }, { GI("a"), GI(2) } };
+	__free dict_t* u = dict_new_mode(DICT_HASH);
+	if( !dict_load(u, dup, sizeof_vector(dup)) || errno != EINVAL || dict_count(u) ) die("dict hash load duplicate");
+
+	//hash index is released in cleanup of dict, free many dicts with keys
+	for( unsigned n = 0; n < 8; ++n ){
+		dict_t* f = dict_new_mode(DICT_HASH);
+		for( long i = 0; i < 64; ++i ){
+			sprintf(key, "free%ld", i);
+			*dict(f, (const char*)key) = GI(i);
+			*dict(f, i) = GI(i);
+		}
+		mem_free(f);
+	}
+}
+
 void uc_dict(void){
 	dict_t* d = dict_new();
 	
@@ -30,4 +87,25 @@ void uc_dict(void){
 	foreach(dict, d, kv, 0, 0){
 		pair(kv, NULL);
 	}
+
+	puts("load");
+	dictPair_s pairs[] = {
+		{ GI(1), GI("one") },
+		{ GI(2), GI("two") },
+		{ GI("a"), GI(1.0) },
+		{ GI("b"), GI(2.0) },
+		{ GI(3), GI("three") }
+	};
+	__free dict_t* l = dict_new();
+	if( dict_load(l, pairs, sizeof_vector(pairs)) ) die("dict load");
+	if( dict_count(l) != sizeof_vector(pairs) ) die("dict load count");
+	if( dict(l, 3)->type != G_STRING || dict(l, "b")->type != G_FLOAT ) die("dict load value");
+	if( !dict_load(l, pairs, sizeof_vector(pairs)) || errno != ENOTEMPTY ) die("dict load not empty");
+	dictPair_s unsorted[] = { { GI(2), GI(2) }, { GI(1), GI(1) } };
+	__free dict_t* u = dict_new();
+	if( !dict_load(u, unsorted, sizeof_vector(unsorted)) || errno != EINVAL ) die("dict load unsorted");
+	foreach(dict, l, kv, 0, 0){
+		pair(kv, NULL);
+	}
+	dict_hash_test();
 }
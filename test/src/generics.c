@@ -0,0 +1,117 @@
+#include <notstd/generics.h>
+#include <notstd/map.h>
+#include <math.h>
+
+#define N 20000
+
+__private int g_equal(generic_s a, generic_s b){
+	if( a.type != b.type ) return 0;
+	switch( a.type ){
+		default: return a.obj == b.obj;
+		case G_UNSET: return 1;
+		case G_CHAR: return a.c == b.c;
+		case G_LONG: return a.l == b.l;
+		case G_ULONG: return a.ul == b.ul;
+		case G_FLOAT: return !memcmp(&a.f, &b.f, sizeof(double));
+		case G_LSTRING: return !strcmp(a.lstr, b.lstr);
+		case G_STRING: return a.str == b.str;
+	}
+}
+
+//each generic need to return same value after box and unbox
+__private void gbox_roundtrip(generic_s g){
+	gbox_t b = gbox_from(g);
+	if( gbox_type(b) != g.type ) die("gbox type %d != %d", gbox_type(b), g.type);
+	if( !g_equal(gbox_generic(&b), g) ) die("gbox roundtrip type %d", g.type);
+}
+
+__private void gbox_test(void){
+	char str[] = "not inline";
+	generic_s vec[1] = { GI(1L) };
+	int obj;
+	if( sizeof(gbox_t) != 8 ) die("gbox size");
+
+	gbox_roundtrip(gi_unset());
+	gbox_roundtrip(GI((char)'x'));
+	gbox_roundtrip(GI((char)-1));
+	gbox_roundtrip(GI(0L));
+	gbox_roundtrip(GI(-1L));
+	gbox_roundtrip(GI(GBOX_LONG_MAX));
+	gbox_roundtrip(GI(GBOX_LONG_MIN));
+	gbox_roundtrip(GI((uint64_t)GBOX_PAYLOAD));
+	gbox_roundtrip(GI(3.25));
+	gbox_roundtrip(GI(-0.0));
+	gbox_roundtrip(GI(INFINITY));
+	gbox_roundtrip(GI((const char*)""));
+	gbox_roundtrip(GI((const char*)"abcde"));
+	gbox_roundtrip(GI((const char*)"abcdef"));
+	gbox_roundtrip(GI(str));
+	gbox_roundtrip(GI(vec));
+	gbox_roundtrip(GI(&obj));
+
+	for( long i = -N; i < N; ++i ){
+		gbox_t b = GB(i * 7919L);
+		if( gbox_type(b) != G_LONG || gbox_l(b) != i * 7919L ) die("gbox long %ld", i * 7919L);
+		b = GB(i * 0.5);
+		if( gbox_type(b) != G_FLOAT || gbox_f(b) < i * 0.5 || gbox_f(b) > i * 0.5 ) die("gbox double %ld", i);
+	}
+
+	//small literal is copied in box, long literal and string are pointer
+	const char* lit = "abcde";
+	gbox_t b = GB(lit);
+	if( gbox_lstr(&b) == lit || strcmp(gbox_lstr(&b), lit) ) die("gbox inline string");
+	lit = "abcdef";
+	b = GB(lit);
+	if( gbox_type(b) != G_LSTRING || gbox_lstr(&b) != lit ) die("gbox literal pointer");
+	b = GB(str);
+	if( gbox_type(b) != G_STRING || gbox_ptr(b) != str ) die("gbox string");
+
+	//out of 48 bit is double, nan is canonical and never boxed
+	b = GB((int64_t)GBOX_LONG_MAX + 1);
+	if( gbox_type(b) != G_FLOAT || gbox_l(b) != GBOX_LONG_MAX + 1 ) die("gbox long overflow");
+	b = GB(UINT64_MAX);
+	if( gbox_type(b) != G_FLOAT ) die("gbox ulong overflow");
+	uint64_t nanbits = GBOX_MAKE(GBOX_TAG_PTR, 0x1234);
+	double nan;
+	memcpy(&nan, &nanbits, sizeof nan);
+	b = GB(nan);
+	if( gbox_type(b) != G_FLOAT || !isnan(gbox_f(b)) ) die("gbox nan");
+}
+
+__private void gcolumn_test(void){
+	__free gcolumn_t* c = gcolumn_new(0);
+	for( unsigned i = 0; i < N; ++i ){
+		switch( i % 3 ){
+			case 0: gcolumn_push(c, GI((long)i)); break;
+			case 1: gcolumn_push(c, GI((double)i)); break;
+			case 2: gcolumn_push(c, GI((const char*)"str")); break;
+		}
+	}
+	if( gcolumn_count(c) != N ) die("gcolumn count %zu", gcolumn_count(c));
+	for( unsigned i = 0; i < N; ++i ){
+		generic_s g = gcolumn_get(c, i);
+		switch( i % 3 ){
+			case 0: if( g.type != G_LONG || g.l != i ) die("gcolumn long %u", i); break;
+			case 1: if( g.type != G_FLOAT || g.f < i || g.f > i ) die("gcolumn double %u", i); break;
+			case 2: if( g.type != G_LSTRING || strcmp(g.lstr, "str") ) die("gcolumn string %u", i); break;
+		}
+	}
+	gcolumn_set(c, 0, GI((char)'a'));
+	if( gcolumn_get(c, 0).type != G_CHAR || gcolumn_get(c, 0).c != 'a' ) die("gcolumn set");
+
+	//scan read only types and payloads of match
+	const uint8_t* types = gcolumn_types(c);
+	const uint64_t* pay  = gcolumn_payloads(c);
+	long sum = 0;
+	long expect = 0;
+	for( unsigned i = 0; i < N; ++i ){
+		if( types[i] == G_LONG ) sum += (long)pay[i];
+		if( i && i % 3 == 0 ) expect += i;
+	}
+	if( sum != expect ) die("gcolumn scan %ld != %ld", sum, expect);
+}
+
+void uc_generics(void){
+	gbox_test();
+	gcolumn_test();
+}
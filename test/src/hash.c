@@ -3,6 +3,7 @@
 #include <notstd/vector.h>
 #include <notstd/rbhash.h>
 #include <notstd/delay.h>
+#include <notstd/threads.h>
 
 #define FILE_NAME_A "/home/vbextreme/Project/Training/password/2151220-passwords.txt"
 #define FILE_COUNT_A 2151220UL
@@ -34,7 +35,11 @@ __private rbhash_f hfn[] = {
 	hash_knuth,
 	hash_partow,
 	hash_murmur_oaat64,
-	hash_murmur_oaat32
+	hash_murmur_oaat32,
+	hash_wyhash,
+	hash_xxh3,
+	hash_crc32c,
+	hash_seeded
 };
 
 __private const char* hname[] = {
@@ -50,7 +55,11 @@ __private const char* hname[] = {
 	"knuth",
 	"partow",
 	"murmur_oaat64",
-	"murmur_oaat32"
+	"murmur_oaat32",
+	"wyhash",
+	"xxh3",
+	"crc32c",
+	"seeded"
 };
 
 __private char** load_data(__out size_t* max, const char* fname){
@@ -186,6 +195,127 @@ void uc_chi_square_hash(){
 	}
 }
 
+/*******************************************/
+/*** throughput and quality on generated ***/
+/*******************************************/
+
+#define QUALITY_KEYS    200000UL
+#define QUALITY_BITS    18
+#define AVALANCHE_KEYS  2000
+#define AVALANCHE_LEN   16
+//hash with avalanche bias over this fail, noise of AVALANCHE_KEYS is near 0.045, classic hash are only reported
+#define AVALANCHE_BIAS  0.1
+
+__private uint64_t QSTATE = 0x5EED;
+
+__private uint64_t qrand(void){
+	uint64_t z = (QSTATE += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+//bytes hashed for each cycle, on same buffer
+__private double hash_throughput(rbhash_f fn, const uint8_t* buf, size_t len){
+	const size_t rounds = (64UL << 20) / (len + 16) + 1;
+	uint64_t keep = 0;
+	const uint64_t st = time_cycles();
+	for( size_t i = 0; i < rounds; ++i ) keep += fn(buf + (i & 7), len);
+	const uint64_t en = time_cycles();
+	__asm__ volatile("" :: "r"(keep));
+	return (double)(rounds * len) / (en - st);
+}
+
+//unique words, random prefix and base 26 counter suffix as the real text share prefix
+__private char** quality_words(size_t count){
+	char** v = VECTOR(char*, count);
+	for( size_t i = 0; i < count; ++i ){
+		const unsigned len = 6 + qrand() % 10;
+		char* w = mem_gift(MANY(char, len + 1), v);
+		unsigned k = len;
+		size_t id = i;
+		do{
+			w[--k] = 'a' + id % 26;
+			id /= 26;
+		}while( id && k );
+		while( k-- ) w[k] = 'a' + qrand() % 26;
+		w[len] = 0;
+		vector_push(&v, &w);
+	}
+	return v;
+}
+
+__private int u64cmp(const void* a, const void* b){
+	const uint64_t ua = *(const uint64_t*)a;
+	const uint64_t ub = *(const uint64_t*)b;
+	return (ua > ub) - (ua < ub);
+}
+
+//full 64 bit collisions and χ² on 2^QUALITY_BITS buckets from low bits, rbhash use low bits for slot
+__private double hash_collision(rbhash_f fn, char** words, size_t* full){
+	const size_t count = vector_count(&words);
+	__free uint64_t* h = MANY(uint64_t, count);
+	__free unsigned* bucket = MANY(unsigned, 1UL << QUALITY_BITS);
+	memset(bucket, 0, sizeof(unsigned) << QUALITY_BITS);
+	for( size_t i = 0; i < count; ++i ){
+		h[i] = fn(words[i], strlen(words[i]));
+		++bucket[h[i] & ((1UL << QUALITY_BITS) - 1)];
+	}
+	qsort(h, count, sizeof(uint64_t), u64cmp);
+	*full = 0;
+	for( size_t i = 1; i < count; ++i ) if( h[i] == h[i-1] ) ++*full;
+	return hash_chi_square(count, 1UL << QUALITY_BITS, bucket);
+}
+
+//flip each input bit and count output bits changed, ideal probability is 0.5 for each pair of bits, return max distance from 0.5
+__private double hash_avalanche(rbhash_f fn){
+	__free unsigned* flip = MANY(unsigned, AVALANCHE_LEN * 8 * 64);
+	memset(flip, 0, sizeof(unsigned) * AVALANCHE_LEN * 8 * 64);
+	uint8_t key[AVALANCHE_LEN];
+	for( unsigned n = 0; n < AVALANCHE_KEYS; ++n ){
+		for( unsigned i = 0; i < AVALANCHE_LEN; ++i ) key[i] = qrand();
+		const uint64_t h = fn(key, AVALANCHE_LEN);
+		for( unsigned bit = 0; bit < AVALANCHE_LEN * 8; ++bit ){
+			key[bit / 8] ^= 1 << (bit % 8);
+			uint64_t d = h ^ fn(key, AVALANCHE_LEN);
+			key[bit / 8] ^= 1 << (bit % 8);
+			for( unsigned o = 0; o < 64; ++o, d >>= 1 ) flip[bit * 64 + o] += d & 1;
+		}
+	}
+	double bias = 0.0;
+	for( unsigned i = 0; i < AVALANCHE_LEN * 8 * 64; ++i ){
+		const double b = fabs((double)flip[i] / AVALANCHE_KEYS - 0.5);
+		if( b > bias ) bias = b;
+	}
+	return bias;
+}
+
+void uc_hash_quality(void){
+	const size_t lens[] = { 8, 16, 64, 256, 4096, 65536 };
+	__free uint8_t* buf = MANY(uint8_t, 65536 + 8);
+	for( size_t i = 0; i < 65536 + 8; ++i ) buf[i] = qrand();
+	__free char** words = quality_words(QUALITY_KEYS);
+	
+	printf("%13s", "bytes/cycle");
+	for( unsigned l = 0; l < sizeof_vector(lens); ++l ) printf(" %7zu", lens[l]);
+	printf(" | %8s %4s %6s\n", "χ²", "coll", "bias");
+	for( unsigned t = 0; t < sizeof_vector(hname); ++t ){
+		printf("%13s", hname[t]);
+		for( unsigned l = 0; l < sizeof_vector(lens); ++l ) printf(" %7.3f", hash_throughput(hfn[t], buf, lens[l]));
+		size_t full;
+		const double chi = hash_collision(hfn[t], words, &full);
+		const double bias = hash_avalanche(hfn[t]);
+		printf(" | %8.4f %4zu %6.4f\n", chi, full, bias);
+		if( hfn[t] == hash_wyhash || hfn[t] == hash_xxh3 || hfn[t] == hash_seeded ){
+			if( full ) die("%s %zu full collisions", hname[t], full);
+			if( bias > AVALANCHE_BIAS ) die("%s avalanche bias %f", hname[t], bias);
+		}
+	}
+	if( crc32c(0, "123456789", 9) != 0xE3069283 ) die("crc32c check value");
+	if( hash_xxh3("", 0) != 0x2D06800538D394C2ULL ) die("xxh3 empty value");
+	if( hash_xxh3_seed(buf, 4096, 7) == hash_xxh3(buf, 4096) ) die("xxh3 seed ignored");
+}
+
 __private int run_hash(char** vdata, size_t max, const char* fnname, rbhash_f fnh){
 	const size_t lines = vector_count(&vdata);
 	__free rbhash_t* rbh = rbhash_new(4096, 10, max, fnh);
@@ -210,7 +340,317 @@ __private int run_hash(char** vdata, size_t max, const char* fnname, rbhash_f fn
 	return 0;
 }
 
+#define CHURN_KEYS  100000UL
+#define CHURN_ROUND 4
+
+//50% of keys removed and reinserted each round, lookup must not degrade and table return empty
+__private void rbhash_churn(void){
+	__free uint64_t* keys = MANY(uint64_t, CHURN_KEYS);
+	__free rbhash_t* rbh = rbhash_new(16, 10, sizeof(uint64_t), hash64_splitmix);
+	for( size_t i = 0; i < CHURN_KEYS; ++i ){
+		keys[i] = i * 0x9E3779B97F4A7C15ULL + 1;
+		rbhash_add(rbh, &keys[i], sizeof(uint64_t), &keys[i]);
+	}
+	rbhashStat_s st;
+	for( unsigned r = 0; r < CHURN_ROUND; ++r ){
+		for( size_t i = r & 1; i < CHURN_KEYS; i += 2 ){
+			if( rbhash_remove(rbh, &keys[i], sizeof(uint64_t)) != &keys[i] ) die("churn remove lost key %zu", i);
+		}
+		for( size_t i = r & 1; i < CHURN_KEYS; i += 2 ){
+			if( rbhash_find(rbh, &keys[i], sizeof(uint64_t)) ) die("churn find removed key %zu", i);
+			rbhash_add(rbh, &keys[i], sizeof(uint64_t), &keys[i]);
+		}
+		for( size_t i = 0; i < CHURN_KEYS; ++i ){
+			if( rbhash_find(rbh, &keys[i], sizeof(uint64_t)) != &keys[i] ) die("churn find lost key %zu", i);
+		}
+		rbhash_stat(rbh, &st);
+		printf("churn round %u: count:%zu load:%.2f probe:%.3f maxdistance:%zu\n", r, st.count, st.load, st.probe, st.maxdistance);
+	}
+	for( size_t i = 0; i < CHURN_KEYS; ++i ) rbhash_remove(rbh, &keys[i], sizeof(uint64_t));
+	rbhash_stat(rbh, &st);
+	if( st.count || st.maxdistance || rbhash_collision(rbh) ) die("churn table not empty count:%zu maxdistance:%zu", st.count, st.maxdistance);
+	for( size_t i = 0; i < RBHASH_HIST; ++i ) if( st.hist[i] ) die("churn histogram not empty");
+}
+
+//grow while keys are found and removed, after reserve table not grow
+__private void rbhash_incremental(void){
+	__free uint64_t* keys = MANY(uint64_t, CHURN_KEYS);
+	__free rbhash_t* rbh = rbhash_new(16, 10, sizeof(uint64_t), hash64_splitmix);
+	rbhash_resize_step(rbh, 1);
+	rbhashStat_s st;
+	size_t pending = 0;
+	for( size_t i = 0; i < CHURN_KEYS; ++i ){
+		keys[i] = i * 0x9E3779B97F4A7C15ULL + 1;
+		rbhash_add(rbh, &keys[i], sizeof(uint64_t), &keys[i]);
+		if( rbhash_stat(rbh, &st)->pending ) ++pending;
+		if( i & 1 ) continue;
+		const size_t h = i / 2;
+		if( rbhash_find(rbh, &keys[h], sizeof(uint64_t)) != &keys[h] ) die("incremental find lost key %zu", h);
+		if( (h & 3) == 0 && rbhash_remove(rbh, &keys[h], sizeof(uint64_t)) != &keys[h] ) die("incremental remove lost key %zu", h);
+		if( (h & 3) == 0 ) rbhash_add(rbh, &keys[h], sizeof(uint64_t), &keys[h]);
+	}
+	if( !pending ) die("incremental resize never pending");
+	__free const void** bkeys = MANY(const void*, CHURN_KEYS + 1);
+	__free void** bout = MANY(void*, CHURN_KEYS + 1);
+	for( size_t i = 0; i < CHURN_KEYS; ++i ) bkeys[i] = &keys[CHURN_KEYS - 1 - i];
+	const uint64_t miss = 0;
+	bkeys[CHURN_KEYS] = &miss;
+	if( rbhash_find_batch(rbh, bkeys, NULL, CHURN_KEYS + 1, bout) != CHURN_KEYS ) die("batch find count");
+	for( size_t i = 0; i < CHURN_KEYS; ++i ) if( bout[i] != bkeys[i] ) die("batch find lost key %zu", i);
+	if( bout[CHURN_KEYS] ) die("batch find ghost key");
+	for( size_t i = 0; i < CHURN_KEYS; ++i ){
+		if( rbhash_find(rbh, &keys[i], sizeof(uint64_t)) != &keys[i] ) die("incremental find lost key %zu", i);
+	}
+	
+	__free rbhash_t* rsv = rbhash_new(16, 10, sizeof(uint64_t), hash64_splitmix);
+	rbhash_reserve(rsv, CHURN_KEYS);
+	const size_t size = rbhash_bucket_count(rsv);
+	for( size_t i = 0; i < CHURN_KEYS; ++i ) rbhash_add(rsv, &keys[i], sizeof(uint64_t), &keys[i]);
+	if( size != rbhash_bucket_count(rsv) ) die("reserve table grow %zu -> %zu", size, rbhash_bucket_count(rsv));
+	rbhash_stat(rsv, &st);
+	printf("incremental: operations in resize:%zu reserved load:%.2f probe:%.3f\n", pending, st.load, st.probe);
+}
+
+__private uint64_t hash_identity(const void* key, __unused size_t len){
+	return *(const uint64_t*)key;
+}
+
+#define WRAP_KEYS 256
+
+/* home slot is the key, A and B collide on last slot and B wrap on slot 0, C and D are shifted by B,
+ * A is removed while resize is pending and migrate cursor is past slot 0, D must not be moved behind cursor
+ */
+__private void rbhash_wrap_remove(void){
+	__free uint64_t* keys = MANY(uint64_t, WRAP_KEYS);
+	__free rbhash_t* rbh = rbhash_new(32, 10, sizeof(uint64_t), hash_identity);
+	rbhash_resize_step(rbh, 1);
+	rbhashStat_s st;
+	size_t n = 0;
+	keys[n++] = 31;
+	keys[n++] = 63;
+	keys[n++] = 32;
+	keys[n++] = 33;
+	for( uint64_t home = 5; home < 31; ++home ) keys[n++] = home;
+	size_t i = 0;
+	while( i < n && !rbhash_stat(rbh, &st)->pending ){
+		rbhash_add(rbh, &keys[i], sizeof(uint64_t), &keys[i]);
+		++i;
+	}
+	if( !st.pending ) die("wrap resize never pending");
+	if( rbhash_remove(rbh, &keys[0], sizeof(uint64_t)) != &keys[0] ) die("wrap remove lost key %lu", keys[0]);
+	const size_t size = rbhash_bucket_count(rbh);
+	for( n = i; rbhash_bucket_count(rbh) == size; ++n ){
+		if( n >= WRAP_KEYS ) die("wrap table never grow");
+		keys[n] = 1000 + n;
+		rbhash_add(rbh, &keys[n], sizeof(uint64_t), &keys[n]);
+	}
+	for( i = 1; i < n; ++i ){
+		if( rbhash_find(rbh, &keys[i], sizeof(uint64_t)) != &keys[i] ) die("wrap lost key %lu", keys[i]);
+	}
+	size_t walk = 0;
+	long slot = 0;
+	while( rbhash_linear(rbh, &slot) ) ++walk;
+	if( walk != n - 1 || rbhash_bucket_used(rbh) != n - 1 ) die("wrap count %zu walk %zu expected %zu", rbhash_bucket_used(rbh), walk, n - 1);
+}
+
+RBHASH_DECLARE(u64map, uint64_t, uint64_t, rbhash_mix64, RBHASH_EQ)
+
+//same churn on specialized table, values are stored by value
+__private void rbhash_declare(void){
+	__free u64map_t* m = u64map_new(16, 10);
+	for( uint64_t i = 0; i < CHURN_KEYS; ++i ) u64map_add(m, i * 0x9E3779B97F4A7C15ULL, i);
+	if( !u64map_addu(m, 0, 0) ) die("u64map addu add duplicate");
+	for( unsigned r = 0; r < CHURN_ROUND; ++r ){
+		for( uint64_t i = r & 1; i < CHURN_KEYS; i += 2 ){
+			uint64_t v;
+			if( u64map_remove(m, i * 0x9E3779B97F4A7C15ULL, &v) || v != i ) die("u64map remove lost key %lu", i);
+		}
+		for( uint64_t i = r & 1; i < CHURN_KEYS; i += 2 ){
+			if( u64map_find(m, i * 0x9E3779B97F4A7C15ULL) ) die("u64map find removed key %lu", i);
+			if( u64map_addu(m, i * 0x9E3779B97F4A7C15ULL, i) ) die("u64map addu fail %lu", i);
+		}
+		for( uint64_t i = 0; i < CHURN_KEYS; ++i ){
+			uint64_t* v = u64map_find(m, i * 0x9E3779B97F4A7C15ULL);
+			if( !v || *v != i ) die("u64map find lost key %lu", i);
+		}
+	}
+	size_t count = 0;
+	long it = 0;
+	u64mapSlot_s* sl;
+	while( (sl = u64map_linear(m, &it)) ){
+		if( sl->key != sl->val * 0x9E3779B97F4A7C15ULL ) die("u64map linear wrong slot");
+		++count;
+	}
+	if( count != CHURN_KEYS || u64map_count(m) != CHURN_KEYS ) die("u64map count %zu", count);
+	for( uint64_t i = 0; i < CHURN_KEYS; ++i ) u64map_remove(m, i * 0x9E3779B97F4A7C15ULL, NULL);
+	if( u64map_count(m) ) die("u64map not empty");
+	printf("u64map: size:%zu ok\n", m->size);
+}
+
+//payload is the key as string
+__private const void* persistent_payload(void* data, size_t* size, __unused void* ctx){
+	if( !data ) return NULL;
+	*size = strlen(data);
+	return data;
+}
+
+//save words, reopen with mmap and find all words without rebuild
+__private void rbhash_persistent(void){
+	__free char** words = quality_words(CHURN_KEYS);
+	__free rbhash_t* rbh = rbhash_new(16, 10, 16, hash_xxh3);
+	foreach_vector(words, i) rbhash_add(rbh, words[i], strlen(words[i]), words[i]);
+	rbhash_add(rbh, "nopayload", 9, NULL);
+	
+	char path[] = "/tmp/notstd-rbhash-XXXXXX";
+	int fd = mkstemp(path);
+	if( fd == -1 ) die("mkstemp: %m");
+	if( rbhash_save(rbh, fd, persistent_payload, NULL) ) die("rbhash save: %m");
+	close(fd);
+	
+	if( rbhash_map_open(path, hash_wyhash) || errno != EINVAL ) die("rbhash map open with wrong hash");
+	delay_t st = time_us();
+	__free rbhashMap_t* map = rbhash_map_open(path, hash_xxh3);
+	if( !map ) die("rbhash map open: %m");
+	delay_t en = time_us();
+	if( rbhash_map_count(map) != CHURN_KEYS + 1 ) die("rbhash map count %zu", rbhash_map_count(map));
+	foreach_vector(words, i){
+		size_t len;
+		const char* p = rbhash_map_find(map, words[i], strlen(words[i]), &len);
+		if( !p || len != strlen(words[i]) || memcmp(p, words[i], len) ) die("rbhash map lost word %s", words[i]);
+	}
+	size_t len = 1;
+	if( !rbhash_map_find(map, "nopayload", 9, &len) || len ) die("rbhash map key without payload");
+	if( rbhash_map_find(map, "notexists", 9, NULL) ) die("rbhash map ghost key");
+	
+	if( truncate(path, 4096) ) die("truncate: %m");
+	if( rbhash_map_open(path, hash_xxh3) || errno != EBADMSG ) die("rbhash map open truncated file");
+	unlink(path);
+	printf("persistent: %zu keys open in %luus\n", rbhash_map_count(map), en - st);
+}
+
+#define CONCURRENT_THR  4
+#define CONCURRENT_KEYS 20000UL
+
+typedef struct crbhtest{
+	crbhash_t* ch;
+	uint64_t* stable;
+	uint64_t* volatilekeys;
+	unsigned id;
+}crbhtest_s;
+
+//readers never miss stable keys while writers add and remove own volatile keys and grow segments
+__private void async_crbhash(__unused thr_t* self, void* arg){
+	crbhtest_s* ct = arg;
+	if( ct->id & 1 ){
+		for( unsigned r = 0; r < 8; ++r ){
+			for( size_t i = 0; i < CONCURRENT_KEYS; ++i ){
+				const uint64_t hash = crbhash_hash(ct->ch, &ct->stable[i], sizeof(uint64_t));
+				if( crbhash_findh(ct->ch, hash, &ct->stable[i], sizeof(uint64_t)) != &ct->stable[i] ) die("crbhash reader lost key %zu", i);
+			}
+		}
+		return;
+	}
+	uint64_t* k = &ct->volatilekeys[(ct->id / 2) * CONCURRENT_KEYS];
+	for( size_t i = 0; i < CONCURRENT_KEYS; ++i ){
+		if( crbhash_addu(ct->ch, &k[i], sizeof(uint64_t), &k[i]) ) die("crbhash writer add %zu", i);
+	}
+	for( size_t i = 0; i < CONCURRENT_KEYS; i += 2 ){
+		if( crbhash_remove(ct->ch, &k[i], sizeof(uint64_t)) != &k[i] ) die("crbhash writer remove %zu", i);
+	}
+}
+
+__private void crbhash_concurrent(void){
+	__free uint64_t* stable = MANY(uint64_t, CONCURRENT_KEYS);
+	__free uint64_t* vkeys = MANY(uint64_t, CONCURRENT_KEYS * CONCURRENT_THR / 2);
+	__free crbhash_t* ch = crbhash_new(16, 10, sizeof(uint64_t), 0, hash64_splitmix);
+	for( size_t i = 0; i < CONCURRENT_KEYS; ++i ){
+		stable[i] = i * 0x9E3779B97F4A7C15ULL + 1;
+		crbhash_add(ch, &stable[i], sizeof(uint64_t), &stable[i]);
+	}
+	for( size_t i = 0; i < CONCURRENT_KEYS * CONCURRENT_THR / 2; ++i ) vkeys[i] = ~(i * 0x9E3779B97F4A7C15ULL);
+	if( !crbhash_addu(ch, &stable[0], sizeof(uint64_t), NULL) ) die("crbhash addu add duplicate");
+	
+	crbhtest_s ct[CONCURRENT_THR];
+	thr_t* t[CONCURRENT_THR];
+	delay_t st = time_us();
+	for( unsigned i = 0; i < CONCURRENT_THR; ++i ){
+		ct[i] = (crbhtest_s){ .ch = ch, .stable = stable, .volatilekeys = vkeys, .id = i };
+		t[i] = START(async_crbhash, &ct[i]);
+	}
+	thr_waitv(t, CONCURRENT_THR);
+	delay_t en = time_us();
+	for( unsigned i = 0; i < CONCURRENT_THR; ++i ) mem_free(t[i]);
+	
+	const size_t expect = CONCURRENT_KEYS + CONCURRENT_KEYS * CONCURRENT_THR / 4;
+	if( crbhash_count(ch) != expect ) die("crbhash count %zu expected %zu", crbhash_count(ch), expect);
+	for( size_t i = 0; i < CONCURRENT_KEYS * CONCURRENT_THR / 2; ++i ){
+		void* f = crbhash_find(ch, &vkeys[i], sizeof(uint64_t));
+		if( (i & 1) ? f != &vkeys[i] : f != NULL ) die("crbhash final find %zu", i);
+	}
+	printf("crbhash: %u threads in %luus\n", CONCURRENT_THR, en - st);
+}
+
+#define HASH32_KEYS 50000UL
+
+//hash functions of 32 bit leave high bits to 0, fingerprint need to use all 128 values
+__private void rbhash_hash32(void){
+	__free char* kbuf = MANY(char, HASH32_KEYS * 16);
+	unsigned fp[256] = {0};
+	__free rbhash_t* rbh = rbhash_new(16, 10, 16, hash_fasthash);
+	for( size_t i = 0; i < HASH32_KEYS; ++i ){
+		char* k = &kbuf[i * 16];
+		sprintf(k, "key%zu", i);
+		const uint64_t h = hash_fasthash(k, strlen(k));
+		if( h >> 32 ) die("fasthash is not 32 bit");
+		++fp[RBHASH_FP(h)];
+		rbhash_add(rbh, k, strlen(k), k);
+	}
+	unsigned used = 0;
+	for( unsigned i = 0; i < 256; ++i ){
+		if( fp[i] && !(i & 0x80) ) die("fingerprint without high bit");
+		used += fp[i] != 0;
+	}
+	if( used != 128 ) die("32 bit hash use only %u fingerprints", used);
+	char miss[16];
+	for( size_t i = 0; i < HASH32_KEYS; ++i ){
+		char* k = &kbuf[i * 16];
+		if( rbhash_find(rbh, k, strlen(k)) != k ) die("hash32 lost key %s", k);
+		sprintf(miss, "miss%zu", i);
+		if( rbhash_find(rbh, miss, strlen(miss)) ) die("hash32 find missing key %s", miss);
+	}
+	for( size_t i = 0; i < HASH32_KEYS; i += 2 ){
+		char* k = &kbuf[i * 16];
+		if( rbhash_remove(rbh, k, strlen(k)) != k ) die("hash32 remove %s", k);
+	}
+	for( size_t i = 0; i < HASH32_KEYS; ++i ){
+		char* k = &kbuf[i * 16];
+		if( rbhash_find(rbh, k, strlen(k)) != ((i & 1) ? k : NULL) ) die("hash32 find after remove %s", k);
+	}
+
+	//segments are selected from mixed hash, with 32 bit hash each segment need to have near count/segments keys
+	__free crbhash_t* ch = crbhash_new(16, 10, 16, 16, hash_fasthash);
+	for( size_t i = 0; i < HASH32_KEYS; ++i ){
+		char* k = &kbuf[i * 16];
+		crbhash_add(ch, k, strlen(k), k);
+	}
+	for( unsigned i = 0; i < 16; ++i ){
+		const size_t c = crbhash_segment_count(ch, i);
+		if( c < HASH32_KEYS / 32 || c > HASH32_KEYS / 8 ) die("32 bit hash segment %u has %zu keys", i, c);
+	}
+	for( size_t i = 0; i < HASH32_KEYS; ++i ){
+		char* k = &kbuf[i * 16];
+		if( crbhash_find(ch, k, strlen(k)) != k ) die("hash32 crbhash lost key %s", k);
+	}
+}
+
 void uc_rbhash(void){
+	rbhash_churn();
+	rbhash_hash32();
+	rbhash_incremental();
+	rbhash_wrap_remove();
+	crbhash_concurrent();
+	rbhash_declare();
+	rbhash_persistent();
 	size_t maxlen;
 	__free char** words = load_data(&maxlen, FILE_TEST);
 	const size_t tests = sizeof_vector(hname);
@@ -0,0 +1,60 @@
+#include <notstd/intern.h>
+#include <notstd/dict.h>
+#include <notstd/map.h>
+#include <notstd/rbhash.h>
+
+#define N 20000
+
+//equal strings return same pointer, copy is independent of caller buffer
+__private void intern_pool_test(void){
+	__free intern_t* pool = intern_new();
+	__free const char** ptr = MANY(const char*, N);
+	char buf[64];
+	for( unsigned i = 0; i < N; ++i ){
+		sprintf(buf, "label%u", i);
+		ptr[i] = intern_add(pool, buf, 0);
+		if( strcmp(ptr[i], buf) ) die("intern copy %s", buf);
+		if( intern_len(ptr[i]) != strlen(buf) ) die("intern len %s", buf);
+		if( intern_hash(ptr[i]) != hash_seeded(buf, strlen(buf)) ) die("intern hash %s", buf);
+	}
+	if( intern_count(pool) != N ) die("intern count %zu", intern_count(pool));
+	for( unsigned i = 0; i < N; ++i ){
+		sprintf(buf, "label%u", i);
+		if( intern_add(pool, buf, 0) != ptr[i] ) die("intern same string different pointer %s", buf);
+		if( intern_find(pool, buf, 0) != ptr[i] ) die("intern find %s", buf);
+	}
+	if( intern_count(pool) != N ) die("intern count after add again %zu", intern_count(pool));
+	if( intern_find(pool, "notexists", 0) ) die("intern find not interned");
+	if( intern_add(pool, "label12", 5) != intern_find(pool, "label", 0) ) die("intern prefix with len");
+
+	__free char* big = MANY(char, INTERN_ARENA_SIZE);
+	memset(big, 'x', INTERN_ARENA_SIZE - 1);
+	big[INTERN_ARENA_SIZE - 1] = 0;
+	const char* ib = intern_add(pool, big, 0);
+	if( ib == big || strcmp(ib, big) || intern_add(pool, big, 0) != ib ) die("intern big string");
+}
+
+//dict key from intern is found from pointer and is not copied, dicts with same string find same pair and own a copy
+__private void intern_dict_test(void){
+	__free dict_t* a = dict_new_mode(DICT_HASH);
+	__free dict_t* b = dict_new_mode(DICT_HASH);
+	const char* k = intern("attribute", 0);
+	if( intern("attribute", 0) != k ) die("global intern");
+	*dictk(a, k) = GI(1L);
+	*dict(b, "attribute") = GI(2L);
+	if( dict(a, "attribute")->l != 1 || dictk(b, k)->l != 2 ) die("dict interned key");
+	dictPair_s* kv;
+	foreach(dict, a, kv, 0, 0){
+		if( kv->key.type != G_LSTRING || kv->key.lstr != k ) die("dict interned key is copied");
+	}
+	foreach(dict, b, kv, 0, 0){
+		if( kv->key.type != G_STRING || kv->key.lstr == k || strcmp(kv->key.lstr, k) ) die("dict key not owned");
+	}
+	if( dictkrm(b, k) || dict_count(b) ) die("dict remove owned key with interned key");
+	if( dictkrm(a, k) || dict_count(a) ) die("dict remove interned key");
+}
+
+void uc_intern(void){
+	intern_pool_test();
+	intern_dict_test();
+}
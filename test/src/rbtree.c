@@ -7,12 +7,20 @@ __private int cmp(const void* a, const void* b){
 	return (int)(uintptr_t)a - (int)(uintptr_t)b;
 }
 
+__private int uint_cmp(const void* a, const void* b){
+	return (int)*(const unsigned*)a - (int)*(const unsigned*)b;
+}
+
 __private int mapp(void* data, __unused void* arg){
 	printf("%d\n", (int)(uintptr_t)(rbtree_node_data(data)));
 	return 0;
 }
 #define N 8
 
+void uc_rbtree_intrusive(void);
+void uc_rbtree_order(void);
+void uc_rbtree_bulk(void);
+
 void uc_rbtree(){
 	__free rbtree_t* t = rbtree_new(cmp);
 	__free int* val = VECTOR(int,N*2);
@@ -38,4 +46,224 @@ void uc_rbtree(){
 
 	if( rbtree_find(t, (void*)(uintptr_t)val[N/2]) ) die("find element but element is removed");
 
+	dbg_info("delete all");
+	for( unsigned i = 0; i < N; ++i ){
+		if( i == N/2 ) continue;
+		node = rbtree_find(t, (void*)(uintptr_t)val[i]);
+		if( !node ) die("lost element %d", val[i]);
+		mem_free(mem_give(rbtree_remove(t, node), t));
+	}
+	if( rbtree_count(t) || rbtree_node_root(t) ) die("tree not empty");
+
+	uc_rbtree_intrusive();
+	uc_rbtree_order();
+	uc_rbtree_bulk();
+}
+
+typedef struct item{
+	rbtLink_s link;
+	uint64_t id;
+}item_s;
+
+RBTREE_DECLARE(items, item_s, link, id, RBTREE_CMP)
+
+#define NI 4096
+
+//return black height, die if red node has red child or black height differ
+__private unsigned rbt_check(rbtLink_s* l){
+	if( !l ) return 1;
+	if( l->color == RBT_RED && ((l->left && l->left->color == RBT_RED) || (l->right && l->right->color == RBT_RED)) ) die("red node with red child");
+	if( l->left && l->left->parent != l ) die("wrong parent");
+	if( l->right && l->right->parent != l ) die("wrong parent");
+	const unsigned bl = rbt_check(l->left);
+	const unsigned br = rbt_check(l->right);
+	if( bl != br ) die("black height %u != %u", bl, br);
+	return bl + (l->color == RBT_BLACK);
+}
+
+void uc_rbtree_intrusive(void){
+	rbtRoot_s root = { NULL, 0, NULL };
+	__free item_s* it = MANY(item_s, NI);
+	dbg_info("intrusive insert");
+	for( unsigned i = 0; i < NI; ++i ){
+		it[i].id = (uint32_t)(i * 2654435761U);
+		if( items_insertu(&root, &it[i]) ) die("insert unique %lu", it[i].id);
+	}
+	if( rbt_check(root.root) == 0 || root.count != NI ) die("wrong tree");
+	item_s dup = { .id = it[7].id };
+	if( items_insertu(&root, &dup) != &it[7] ) die("insertu not find duplicate");
+
+	dbg_info("intrusive remove, two children and root");
+	for( unsigned i = 0; i < NI; i += 2 ){
+		if( items_find(&root, &it[i].id) != &it[i] ) die("find %lu", it[i].id);
+		items_remove(&root, &it[i]);
+		if( items_find(&root, &it[i].id) ) die("find element but element is removed");
+		if( !(i & 0xFF) ) rbt_check(root.root);
+	}
+	rbt_check(root.root);
+	items_remove(&root, container_of(root.root, item_s, link));
+
+	dbg_info("intrusive order");
+	size_t n = 0;
+	uint64_t prev = 0;
+	for( item_s* e = items_first(&root); e; e = items_next(e), ++n ){
+		if( n && e->id < prev ) die("not ordered");
+		prev = e->id;
+	}
+	if( n != root.count || n != NI/2 - 1 ) die("wrong count %zu", n);
+	for( item_s* e = items_last(&root); e; e = items_prev(e) ) --n;
+	if( n ) die("reverse count");
+	const uint64_t key = 0;
+	if( items_find_best(&root, &key) != items_first(&root) ) die("find best");
+
+	while( root.root ) items_remove(&root, container_of(root.root, item_s, link));
+	if( root.count ) die("count after remove all");
+}
+
+#define NO 2000
+
+//sum of keys of subtree, maintained from augment
+typedef struct sitem{
+	rbtLink_s link;
+	uint64_t id;
+	uint64_t sum;
+}sitem_s;
+
+RBTREE_DECLARE(sitems, sitem_s, link, id, RBTREE_CMP)
+
+__private uint64_t sitem_sum(rbtLink_s* l){
+	return l ? container_of(l, sitem_s, link)->sum : 0;
+}
+
+__private void sitem_augment(rbtLink_s* l){
+	container_of(l, sitem_s, link)->sum = container_of(l, sitem_s, link)->id + sitem_sum(l->left) + sitem_sum(l->right);
+}
+
+__private uint64_t sitem_check(rbtLink_s* l){
+	if( !l ) return 0;
+	const uint64_t sum = container_of(l, sitem_s, link)->id + sitem_check(l->left) + sitem_check(l->right);
+	if( sum != sitem_sum(l) ) die("augment sum %lu != %lu", sitem_sum(l), sum);
+	return sum;
+}
+
+__private uint64_t okey(unsigned i){
+	return (uint32_t)(i * 2654435761U) % 100003;
+}
+
+void uc_rbtree_order(void){
+	dbg_info("order statistic");
+	__free rbtree_t* t = rbtree_new(cmp);
+	__free unsigned* sorted = MANY(unsigned, NO);
+	for( unsigned i = 0; i < NO; ++i ){
+		rbtree_insert(t, mem_gift(rbtree_node_new((void*)(uintptr_t)okey(i)), t));
+		sorted[i] = okey(i);
+	}
+	qsort(sorted, NO, sizeof(unsigned), uint_cmp);
+
+	for( unsigned k = 0; k < NO; ++k ){
+		rbtNode_t* n = rbtree_select(t, k);
+		if( !n || (uintptr_t)rbtree_node_data(n) != sorted[k] ) die("select %u", k);
+		if( rbtree_rank(t, (void*)(uintptr_t)sorted[k]) != k ) die("rank %u", k);
+		if( rbtree_node_index(n) != k ) die("node index %u", k);
+	}
+	if( rbtree_select(t, NO) ) die("select out of range");
+
+	rbtNode_t* node;
+	unsigned k = NO - 10;
+	foreach(rbtree_inorder, t, node, NO - 10, 0){
+		if( (uintptr_t)rbtree_node_data(node) != sorted[k++] ) die("iterator offset");
+	}
+	if( k != NO ) die("iterator count");
+	k = NO / 2;
+	foreach(rbtree_range, t, node, (void*)(uintptr_t)(sorted[NO/2-1]+1), 5){
+		if( (uintptr_t)rbtree_node_data(node) != sorted[k++] ) die("range iterator");
+	}
+	if( k != NO/2 + 5 ) die("range count");
+
+	dbg_info("cursor");
+	k = 0;
+	rbtree_each(node, rbtree_cursor(t, 0)){
+		if( (uintptr_t)rbtree_node_data(node) != sorted[k++] ) die("cursor order");
+	}
+	if( k != NO ) die("cursor count");
+	rbtree_each(node, rbtree_cursor(t, 1)){
+		if( (uintptr_t)rbtree_node_data(node) != sorted[--k] ) die("reverse cursor order");
+	}
+	if( k ) die("reverse cursor count");
+	k = NO - 1 - 3;
+	foreach(rbtree_reverse, t, node, 3, 0){
+		if( (uintptr_t)rbtree_node_data(node) != sorted[k--] ) die("reverse iterator");
+	}
+	if( k != UINT_MAX ) die("reverse iterator count");
+
+	//all lo <= key <= hi, bounds are also keys not in tree
+	const unsigned lo = sorted[10] + 1;
+	const unsigned hi = sorted[20];
+	if( rbtree_node_data(rbtree_upper_bound(t, (void*)(uintptr_t)hi)) != (void*)(uintptr_t)sorted[21] ) die("upper bound");
+	k = 11;
+	rbtree_each(node, rbtree_cursor_range(rbtree_lower_bound(t, (void*)(uintptr_t)lo), rbtree_upper_bound(t, (void*)(uintptr_t)hi))){
+		if( (uintptr_t)rbtree_node_data(node) != sorted[k++] ) die("range cursor");
+	}
+	if( k != 21 ) die("range cursor count %u", k);
+	if( rbtree_node_next(rbtree_select(t, 5)) != rbtree_select(t, 6) || rbtree_node_prev(rbtree_select(t, 5)) != rbtree_select(t, 4) ) die("node next prev");
+
+	dbg_info("augment sum");
+	rbtRoot_s root = { NULL, 0, sitem_augment };
+	__free sitem_s* it = MANY(sitem_s, NO);
+	uint64_t total = 0;
+	for( unsigned i = 0; i < NO; ++i ){
+		it[i].id = okey(i);
+		total += it[i].id;
+		sitems_insert(&root, &it[i]);
+	}
+	if( sitem_check(root.root) != total ) die("augment total");
+	for( unsigned i = 0; i < NO; i += 3 ){
+		sitems_remove(&root, &it[i]);
+		total -= it[i].id;
+		if( !(i % 64) ) sitem_check(root.root);
+	}
+	if( sitem_check(root.root) != total ) die("augment total after remove");
+}
+
+void uc_rbtree_bulk(void){
+	dbg_info("bulk build");
+	__free void** sorted = MANY(void*, NO);
+	for( unsigned i = 0; i < NO; ++i ) sorted[i] = (void*)(uintptr_t)(i * 2);
+	for( unsigned n = 0; n < 600; ++n ){
+		__free rbtree_t* t = rbtree_new(cmp);
+		if( !rbtree_bulk_build(t, sorted, n) ) die("bulk build %u", n);
+		if( rbtree_count(t) != n ) die("bulk count");
+		if( n ) rbt_check(rbtree_root(t)->root);
+		for( unsigned k = 0; k < n; ++k ){
+			if( rbtree_node_data(rbtree_select(t, k)) != sorted[k] ) die("bulk select %u/%u", k, n);
+		}
+	}
+	__free rbtree_t* a = rbtree_new(cmp);
+	if( rbtree_bulk_build(a, sorted, NO) != a ) die("bulk build");
+	if( rbtree_bulk_build(a, sorted, NO) || errno != ENOTEMPTY ) die("bulk build on not empty tree");
+
+	dbg_info("merge");
+	__free rbtree_t* b = rbtree_new(cmp);
+	for( unsigned i = 0; i < NO; ++i ) rbtree_insert(b, mem_gift(rbtree_node_new((void*)(uintptr_t)(i * 2 + 1)), b));
+	rbtree_merge(a, b);
+	if( rbtree_count(a) != NO * 2 || rbtree_count(b) ) die("merge count");
+	rbt_check(rbtree_root(a)->root);
+	for( unsigned k = 0; k < NO * 2; ++k ){
+		if( (uintptr_t)rbtree_node_data(rbtree_select(a, k)) != k ) die("merge order %u", k);
+	}
+
+	dbg_info("intrusive build and merge");
+	__free item_s* it = MANY(item_s, NO);
+	for( unsigned i = 0; i < NO; ++i ) it[i].id = i;
+	rbtRoot_s ra = { NULL, 0, NULL };
+	rbtRoot_s rb = { NULL, 0, NULL };
+	items_build(&ra, it, NO / 2);
+	for( unsigned i = NO / 2; i < NO; ++i ) items_insert(&rb, &it[i]);
+	items_merge(&ra, &rb);
+	rbt_check(ra.root);
+	unsigned k = 0;
+	for( item_s* e = items_first(&ra); e; e = items_next(e) ){
+		if( e->id != k++ ) die("intrusive merge order");
+	}
+	if( k != NO || rb.root ) die("intrusive merge count");
 }
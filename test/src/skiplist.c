@@ -0,0 +1,169 @@
+#include <notstd/map.h>
+#include <notstd/skiplist.h>
+#include <notstd/threads.h>
+#include <notstd/delay.h>
+
+#define N 20000
+#define SKIPLIST_THR    8
+#define SKIPLIST_SHARED 4096UL
+
+__private int u64cmp(const void* a, const void* b){
+	const uint64_t ua = *(const uint64_t*)a;
+	const uint64_t ub = *(const uint64_t*)b;
+	return (ua > ub) - (ua < ub);
+}
+
+//odd multiplier is a bijection on 32 bit, keys are unique and unordered
+__private uint64_t key_of(unsigned i){
+	return (uint32_t)(i * 2654435761U) * 2ULL;
+}
+
+__private void skiplist_check(skiplist_t* sl, size_t count){
+	if( skiplist_count(sl) != count ) die("wrong count %zu != %zu", skiplist_count(sl), count);
+	uint64_t* prev = NULL;
+	uint64_t* k;
+	size_t n = 0;
+	foreach(skiplist_inorder, sl, k, 0, 0){
+		if( prev && *k <= *prev ) die("not ordered %lu <= %lu", *k, *prev);
+		prev = k;
+		++n;
+	}
+	if( n != count ) die("iterate %zu elements, expected %zu", n, count);
+}
+
+__private void skiplist_single(void){
+	__free uint64_t* keys = MANY(uint64_t, N);
+	__free skiplist_t* sl = skiplist_new(u64cmp);
+
+	dbg_info("insert");
+	for( unsigned i = 0; i < N; ++i ){
+		keys[i] = key_of(i);
+		if( skiplist_insert(sl, &keys[i]) ) die("insert fail %lu", keys[i]);
+	}
+	if( !skiplist_insert(sl, &keys[0]) || errno != EEXIST ) die("insert duplicate");
+	skiplist_check(sl, N);
+
+	dbg_info("search");
+	for( unsigned i = 0; i < N; ++i ){
+		if( skiplist_find(sl, &keys[i]) != &keys[i] ) die("try find element %lu but not exists", keys[i]);
+		const uint64_t miss = keys[i] + 1;
+		if( skiplist_find(sl, &miss) ) die("find element %lu not inserted", miss);
+		uint64_t* best = skiplist_find_best(sl, &miss);
+		if( best && *best <= keys[i] ) die("find best %lu of %lu", *best, miss);
+	}
+	const uint64_t over = UINT64_MAX;
+	if( skiplist_find_best(sl, &over) ) die("find best over max");
+
+	dbg_info("range");
+	const uint64_t from = key_of(N/2);
+	uint64_t* k;
+	unsigned count = 0;
+	foreach(skiplist_inorder, sl, k, 0, 0){
+		if( *k >= from ) break;
+		++count;
+	}
+	unsigned range = 0;
+	foreach(skiplist_range, sl, k, &from, 100){
+		if( !range && *k != from ) die("range not start from key");
+		++range;
+	}
+	if( range != (N - count < 100 ? N - count : 100) ) die("range count %u", range);
+	__free skiplist_i* it = skiplist_inorder_iterator(sl, count, 1);
+	if( *(uint64_t*)skiplist_inorder_iterate(it) != from ) die("iterator offset");
+	if( skiplist_inorder_iterate(it) ) die("iterator count");
+
+	dbg_info("delete");
+	for( unsigned i = 0; i < N; i += 2 ){
+		if( skiplist_remove(sl, &keys[i]) != &keys[i] ) die("remove %lu", keys[i]);
+		if( skiplist_remove(sl, &keys[i]) ) die("remove twice %lu", keys[i]);
+	}
+	skiplist_check(sl, N/2);
+	for( unsigned i = 0; i < N; ++i ){
+		void* d = skiplist_find(sl, &keys[i]);
+		if( (i & 1) && d != &keys[i] ) die("lost element %lu", keys[i]);
+		if( !(i & 1) && d ) die("find element but element is removed");
+	}
+}
+
+typedef struct sltest{
+	skiplist_t* sl;
+	uint64_t* keys;
+	uint64_t* shared;
+	unsigned id;
+	unsigned added;
+	unsigned removed;
+}sltest_s;
+
+//own keys are inserted and half removed, odd keys are never lost, shared keys are contended from all threads and only one win each insert or remove
+__private void async_skiplist(__unused thr_t* self, void* arg){
+	sltest_s* st = arg;
+	for( size_t i = st->id; i < N; i += SKIPLIST_THR ){
+		if( skiplist_insert(st->sl, &st->keys[i]) ) die("skiplist writer insert %zu", i);
+	}
+	for( size_t i = 0; i < SKIPLIST_SHARED; ++i ){
+		if( !skiplist_insert(st->sl, &st->shared[i]) ) ++st->added;
+	}
+	for( size_t i = st->id; i < N; i += SKIPLIST_THR ){
+		if( (i & 1) && skiplist_find(st->sl, &st->keys[i]) != &st->keys[i] ) die("skiplist reader lost key %zu", i);
+		if( !(i & 1) && skiplist_remove(st->sl, &st->keys[i]) != &st->keys[i] ) die("skiplist writer remove %zu", i);
+	}
+	for( size_t i = 0; i < SKIPLIST_SHARED; ++i ){
+		if( skiplist_remove(st->sl, &st->shared[i]) ) ++st->removed;
+	}
+}
+
+__private void skiplist_concurrent(void){
+	__free uint64_t* keys = MANY(uint64_t, N);
+	__free uint64_t* shared = MANY(uint64_t, SKIPLIST_SHARED);
+	__free skiplist_t* sl = skiplist_new(u64cmp);
+	for( size_t i = 0; i < N; ++i ) keys[i] = key_of(i);
+	for( size_t i = 0; i < SKIPLIST_SHARED; ++i ) shared[i] = key_of(i) + 1;
+
+	sltest_s st[SKIPLIST_THR];
+	thr_t* t[SKIPLIST_THR];
+	delay_t start = time_us();
+	for( unsigned i = 0; i < SKIPLIST_THR; ++i ){
+		st[i] = (sltest_s){ .sl = sl, .keys = keys, .shared = shared, .id = i, .added = 0, .removed = 0 };
+		t[i] = START(async_skiplist, &st[i]);
+	}
+	thr_waitv(t, SKIPLIST_THR);
+	delay_t en = time_us();
+	for( unsigned i = 0; i < SKIPLIST_THR; ++i ) mem_free(t[i]);
+
+	//a slow thread can insert shared key after all others have removed it
+	unsigned added = 0;
+	unsigned removed = 0;
+	for( unsigned i = 0; i < SKIPLIST_THR; ++i ){
+		added   += st[i].added;
+		removed += st[i].removed;
+	}
+	unsigned present = 0;
+	for( size_t i = 0; i < SKIPLIST_SHARED; ++i ) present += skiplist_find(sl, &shared[i]) == &shared[i];
+	if( added < SKIPLIST_SHARED || added - removed != present ) die("skiplist shared added %u removed %u present %u", added, removed, present);
+	skiplist_check(sl, N/2 + present);
+	for( size_t i = 0; i < N; ++i ){
+		void* f = skiplist_find(sl, &keys[i]);
+		if( (i & 1) ? f != &keys[i] : f != NULL ) die("skiplist final find %zu", i);
+	}
+	epoch_barrier();
+	printf("skiplist: %u threads in %luus\n", SKIPLIST_THR, en - start);
+}
+
+//nodes are released in cleanup of list
+__private void skiplist_free(void){
+	__free uint64_t* keys = MANY(uint64_t, 64);
+	for( unsigned n = 0; n < 8; ++n ){
+		skiplist_t* sl = skiplist_new(u64cmp);
+		for( unsigned i = 0; i < 64; ++i ){
+			keys[i] = key_of(i);
+			if( skiplist_insert(sl, &keys[i]) ) die("insert fail %lu", keys[i]);
+		}
+		mem_free(sl);
+	}
+}
+
+void uc_skiplist(void){
+	skiplist_free();
+	skiplist_single();
+	skiplist_concurrent();
+}
@@ -68,6 +68,165 @@ __private void async_event_wait(__unused thr_t* thr, void* ctx){
 	dbg_info("event raised");
 }
 
+__private void async_burst(__unused thr_t* thr, void* ctx){
+	__atomic_add_fetch((unsigned*)ctx, 1, __ATOMIC_RELAXED);
+}
+
+typedef struct condtest{
+	glock_s mtx;
+	glock_s cond;
+	unsigned ready;
+	unsigned waiting;
+	unsigned wake;
+}condtest_s;
+
+__private void async_cond_wait(__unused thr_t* thr, void* ctx){
+	condtest_s* ct = ctx;
+	mutex_guard(&ct->mtx){
+		++ct->waiting;
+		while( !ct->ready ) cond_wait(&ct->cond, &ct->mtx);
+		++ct->wake;
+	}
+}
+
+#define CONDTHR 8
+
+__private void uc_cond(void){
+	condtest_s ct = { .ready = 0, .waiting = 0, .wake = 0 };
+	mutex_ctor(&ct.mtx, 0);
+	cond_ctor(&ct.cond, 0);
+	thr_t* t[CONDTHR];
+	for( unsigned i = 0; i < CONDTHR; ++i ) t[i] = START(async_cond_wait, &ct);
+	unsigned waiting = 0;
+	while( waiting < CONDTHR ){
+		delay_ms(1);
+		mutex_guard(&ct.mtx) waiting = ct.waiting;
+	}
+	mutex_guard(&ct.mtx){
+		ct.ready = 1;
+		cond_broadcast(&ct.cond);
+	}
+	thr_waitv(t, CONDTHR);
+	for( unsigned i = 0; i < CONDTHR; ++i ) mem_free(t[i]);
+	if( ct.wake != CONDTHR ) die("cond broadcast wake %u/%u", ct.wake, CONDTHR);
+	printf("cond broadcast wake %u threads\n", ct.wake);
+}
+
+typedef struct locktest{
+	glock_s mtx;
+	mcs_s mcs;
+	cohort_t* cohort;
+	unsigned mode;
+	unsigned long counter;
+}locktest_s;
+
+#define LOCKTHR 4
+#define LOCKINC 100000
+
+__private void async_lock_inc(__unused thr_t* thr, void* ctx){
+	locktest_s* lt = ctx;
+	for( unsigned i = 0; i < LOCKINC; ++i ){
+		switch( lt->mode ){
+			case 0: mutex_guard(&lt->mtx) ++lt->counter; break;
+			case 1: mcs_guard(&lt->mcs) ++lt->counter; break;
+			case 2: cohort_guard(lt->cohort) ++lt->counter; break;
+		}
+	}
+}
+
+__private void uc_qlock(void){
+	const char* name[] = { "mutex", "mcs", "cohort" };
+	__free cohort_t* cohort = cohort_new(0);
+	for( unsigned mode = 0; mode < sizeof_vector(name); ++mode ){
+		locktest_s lt = { .mode = mode, .counter = 0, .cohort = cohort };
+		mutex_ctor(&lt.mtx, 0);
+		mcs_ctor(&lt.mcs, 0);
+		thr_t* t[LOCKTHR];
+		delay_t st = time_us();
+		for( unsigned i = 0; i < LOCKTHR; ++i ) t[i] = START(async_lock_inc, &lt);
+		thr_waitv(t, LOCKTHR);
+		delay_t en = time_us();
+		for( unsigned i = 0; i < LOCKTHR; ++i ) mem_free(t[i]);
+		if( lt.counter != LOCKTHR * LOCKINC ) die("%s lose increment %lu", name[mode], lt.counter);
+		printf("%6s: %u threads x %u lock in %luus\n", name[mode], LOCKTHR, LOCKINC, en - st);
+	}
+}
+
+#define BURST 1024U
+
+__private void uc_burst(void){
+	unsigned done = 0;
+	thr_t* t[16];
+	delay_t st = time_us();
+	for( unsigned i = 0; i < BURST; i += 16 ){
+		for( unsigned k = 0; k < 16; ++k ) t[k] = START(async_burst, &done);
+		thr_waitv(t, 16);
+		for( unsigned k = 0; k < 16; ++k ){
+			if( thr_check(t[k]) != THR_STATE_STOP ) die("thread not stopped after wait");
+			mem_free(t[k]);
+		}
+	}
+	delay_t en = time_us();
+	if( done != BURST ) die("burst lose task %u", done);
+	printf("burst %u task in %luus, parked %u\n", done, en - st, thr_pool_count());
+}
+
+__private void async_affinity(thr_t* thr, void* ctx){
+	unsigned index = (uintptr_t)ctx;
+	cpu_set_t mask;
+	pthread_getaffinity_np(thr_id(thr), sizeof(cpu_set_t), &mask);
+	printf("> worker %u on %d cpu, running on cpu%d\n", index, CPU_COUNT(&mask), sched_getcpu());
+}
+
+__private void uc_topology(void){
+	topology_dump();
+	cpu_set_t set;
+	if( cpuset_parse(&set, "0-3,8,10-11") || CPU_COUNT(&set) != 7 || !CPU_ISSET(10, &set) ) die("cpuset parse");
+	if( !cpuset_parse(&set, "3-1") ) die("cpuset parse accept wrong list");
+
+	const cpuAffinity_e policy[] = { CPU_AFFINITY_COMPACT, CPU_AFFINITY_SCATTER, CPU_AFFINITY_CORE, CPU_AFFINITY_NODE };
+	const char* name[] = { "compact", "scatter", "core", "node" };
+	thr_t* t[4];
+	for( unsigned p = 0; p < sizeof_vector(policy); ++p ){
+		printf("%s\n", name[p]);
+		for( unsigned i = 0; i < 4; ++i ) t[i] = START_ON(async_affinity, (void*)(uintptr_t)i, policy[p], i);
+		thr_waitv(t, 4);
+		for( unsigned i = 0; i < 4; ++i ) mem_free(t[i]);
+	}
+}
+
+__private void async_pin(thr_t* self, __unused void* ctx){
+	cpu_set_t one;
+	CPU_ZERO(&one);
+	CPU_SET(sched_getcpu(), &one);
+	thr_cpu_mask(self, &one);
+}
+
+__private void async_get_mask(thr_t* self, void* ctx){
+	pthread_getaffinity_np(thr_id(self), sizeof(cpu_set_t), ctx);
+}
+
+//pinned job not change affinity of next job on same os thread, ended job can't change affinity
+__private void uc_pool_affinity(void){
+	cpu_set_t proc;
+	cpu_set_t job;
+	sched_getaffinity(0, sizeof(cpu_set_t), &proc);
+	thr_t* t = START(async_pin, NULL);
+	thr_wait(t);
+	mem_free(t);
+	for( unsigned i = 0; i < 2; ++i ){
+		t = START(async_get_mask, &job);
+		thr_wait(t);
+		if( !CPU_EQUAL(&proc, &job) ) die("pooled job inherit affinity of previous job");
+		cpu_set_t one;
+		CPU_ZERO(&one);
+		CPU_SET(0, &one);
+		thr_cpu_mask(t, &one);
+		mem_free(t);
+	}
+	printf("pool affinity reset to %d cpu\n", CPU_COUNT(&proc));
+}
+
 int main(){
 	glock_s mtx;
 	mutex_ctor(&mtx, 0);
@@ -148,6 +307,26 @@ int main(){
 	mem_free(t[1]);
 	puts("");
 	
+	puts("condition");
+	uc_cond();
+	puts("");
+
+	puts("queue lock");
+	uc_qlock();
+	puts("");
+
+	puts("topology");
+	uc_topology();
+	puts("");
+
+	puts("burst");
+	uc_burst();
+	puts("");
+
+	puts("pool affinity");
+	uc_pool_affinity();
+	puts("");
+
 	puts("thread are stopped");
 
 	__free thr_t** vthr = VECTOR(thr_t*, 10);
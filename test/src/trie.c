@@ -1,8 +1,11 @@
 #include <notstd/trie.h>
+#include <notstd/map.h>
 
-//TODO test iterator
+//TODO test iterator of TRIE_EDGE
 
-void uc_trie(void){
+#define N 20000
+
+__private void trie_words(trieMode_e mode){
 	char* words[] = {
 		"hello",
 		"world",
@@ -18,7 +21,7 @@ void uc_trie(void){
 		NULL
 	};
 	
-	trie_t* t = trie_new();
+	trie_t* t = trie_new_mode(mode);
 
 	dbg_info("insert");	
 	unsigned i = 0;
@@ -66,3 +69,127 @@ void uc_trie(void){
 	}while(words[++i]);
 	trie_dump(t);
 }
+
+//keys share long prefix and many are prefix of others, grow and shrink all node types
+__private void trie_art_keys(char** keys){
+	char buf[64];
+	for( unsigned i = 0; i < N; ++i ){
+		const unsigned r = i * 2654435761U;
+		switch( i % 4 ){
+			case 0: sprintf(buf, "%u", r); break;
+			case 1: sprintf(buf, "routing/table/prefix/%u", r % 5000); break;
+			case 2: sprintf(buf, "%c%c", 1 + r % 255, 'a' + (r >> 8) % 26); break;
+			case 3: sprintf(buf, "routing/table/prefix/%u/%c", r % 300, 1 + r % 255); break;
+		}
+		const size_t len = strlen(buf);
+		keys[i] = MANY(char, len + 1);
+		memcpy(keys[i], buf, len + 1);
+	}
+}
+
+__private int strp_cmp(const void* a, const void* b){
+	return strcmp(*(char**)a, *(char**)b);
+}
+
+__private void trie_art_check(trie_t* t, char** keys, unsigned count){
+	char* prev = NULL;
+	char* k;
+	unsigned n = 0;
+	foreach(trie, t, k, 0, 0){
+		if( prev && strcmp(prev, k) >= 0 ) die("trie art iterate not ordered %s >= %s", prev, k);
+		prev = k;
+		++n;
+	}
+	if( n != count ) die("trie art iterate %u elements, expected %u", n, count);
+	for( unsigned i = 0; i < count; ++i ){
+		if( trie_find(t, keys[i], 0) != keys[i] ) die("trie art lost %s", keys[i]);
+	}
+}
+
+__private void trie_art(void){
+	__free char** keys = MANY(char*, N);
+	trie_art_keys(keys);
+	//remove duplicate keys, data is first pointer with key
+	qsort(keys, N, sizeof(char*), strp_cmp);
+	unsigned count = 1;
+	for( unsigned i = 1; i < N; ++i ){
+		if( strcmp(keys[i], keys[count-1]) ) keys[count++] = keys[i];
+		else mem_free(keys[i]);
+	}
+	//insert in random order
+	for( unsigned i = count - 1; i > 0; --i ){
+		const unsigned j = (i * 2654435761U) % (i + 1);
+		char* s = keys[i];
+		keys[i] = keys[j];
+		keys[j] = s;
+	}
+
+	__free trie_t* t = trie_new_mode(TRIE_ART);
+	if( trie_mode(t) != TRIE_ART ) die("trie mode");
+	for( unsigned i = 0; i < count; ++i ){
+		if( trie_insert(t, keys[i], 0, keys[i]) ) die("trie art insert %s", keys[i]);
+	}
+	if( trie_insert(t, keys[0], 0, keys[0]) ) die("trie art replace");
+	trie_art_check(t, keys, count);
+	if( trie_find(t, "routing/table/prefix/", 0) ) die("trie art find prefix of key");
+	if( trie_find(t, "routing/table/prefix/1/xx", 0) ) die("trie art find over key");
+	if( trie_find(t, "routing/tablX/prefix/1", 0) ) die("trie art find over stored prefix");
+	if( trie_find(t, keys[0], strlen(keys[0]) - 1) == keys[0] ) die("trie art find with len");
+
+	__free trie_i* it = trie_iterator(t, 10, 5);
+	unsigned n = 0;
+	while( trie_iterate(it) ) ++n;
+	if( n != 5 ) die("trie art iterator count %u", n);
+
+	for( unsigned i = 0; i < count; i += 2 ){
+		if( trie_remove(t, keys[i], 0) ) die("trie art remove %s", keys[i]);
+		if( !trie_remove(t, keys[i], 0) ) die("trie art remove twice %s", keys[i]);
+	}
+	for( unsigned i = 0; i < count; ++i ){
+		void* d = trie_find(t, keys[i], 0);
+		if( (i & 1) && d != keys[i] ) die("trie art lost %s after remove", keys[i]);
+		if( !(i & 1) && d ) die("trie art find removed %s", keys[i]);
+	}
+	for( unsigned i = 1; i < count; i += 2 ){
+		if( trie_remove(t, keys[i], 0) ) die("trie art remove %s", keys[i]);
+	}
+	trie_art_check(t, keys, 0);
+	for( unsigned i = 0; i < count; ++i ){
+		if( trie_insert(t, keys[i], 0, keys[i]) ) die("trie art insert after clear %s", keys[i]);
+	}
+	trie_art_check(t, keys, count);
+	for( unsigned i = 0; i < count; ++i ) mem_free(keys[i]);
+}
+
+//always new keys with some kept alive, labels pool is compacted many times and kept labels must survive
+__private void trie_edge_churn(void){
+	char buf[32];
+	trie_t* t = trie_new();
+	for( unsigned r = 0; r < 64; ++r ){
+		for( unsigned i = 0; i < 256; ++i ){
+			sprintf(buf, "k%016lx", (r * 256UL + i + 1) * 0x9E3779B97F4A7C15UL);
+			trie_insert(t, buf, 0, (void*)(uintptr_t)(r * 256 + i + 1));
+		}
+		for( unsigned i = 0; i < 256; ++i ){
+			if( !(i % 16) ) continue;
+			sprintf(buf, "k%016lx", (r * 256UL + i + 1) * 0x9E3779B97F4A7C15UL);
+			if( trie_remove(t, buf, 0) ) die("churn remove %s", buf);
+		}
+	}
+	for( unsigned r = 0; r < 64; ++r ){
+		for( unsigned i = 0; i < 256; ++i ){
+			sprintf(buf, "k%016lx", (r * 256UL + i + 1) * 0x9E3779B97F4A7C15UL);
+			uintptr_t v = (uintptr_t)trie_find(t, buf, 0);
+			uintptr_t e = i % 16 ? 0 : r * 256 + i + 1;
+			if( v != e ) die("churn find %s get %lu expected %lu", buf, v, e);
+		}
+	}
+	mem_free(t);
+}
+
+void uc_trie(void){
+	trie_words(TRIE_EDGE);
+	trie_edge_churn();
+	trie_words(TRIE_ART);
+	trie_art();
+}